@@ -0,0 +1,74 @@
+# Writes a header holding every variant of every shader program in
+# SHADER_DIR as constexpr strings: one per combination of FEATURES
+# (comma-separated defines), indexed by a key whose bit i turns on the
+# i-th feature. A program is a <name>.vert with a matching <name>.frag.
+#
+#   cmake -DSHADER_DIR=<dir> -DFEATURES=<a,b,...> -DOUTPUT=<header>
+#     -P embed-shaders.cmake
+
+string(REPLACE "," ";" FEATURES "${FEATURES}")
+list(LENGTH FEATURES FEATURE_COUNT)
+math(EXPR VARIANT_COUNT "1 << ${FEATURE_COUNT}")
+math(EXPR LAST_VARIANT "${VARIANT_COUNT} - 1")
+
+# Inserts the defines after #version, which has to stay the first line.
+function(make_variant SOURCE KEY RESULT)
+  set(DEFINES "")
+  set(BIT 0)
+  foreach(FEATURE IN LISTS FEATURES)
+    math(EXPR ENABLED "(${KEY} >> ${BIT}) & 1")
+    if(ENABLED)
+      string(APPEND DEFINES "#define ${FEATURE}\n")
+    endif()
+    math(EXPR BIT "${BIT} + 1")
+  endforeach()
+  string(FIND "${SOURCE}" "\n" VERSION_END)
+  math(EXPR VERSION_END "${VERSION_END} + 1")
+  string(SUBSTRING "${SOURCE}" 0 ${VERSION_END} HEAD)
+  string(SUBSTRING "${SOURCE}" ${VERSION_END} -1 TAIL)
+  set(${RESULT} "${HEAD}${DEFINES}${TAIL}" PARENT_SCOPE)
+endfunction()
+
+set(HEADER "// Generated from ${SHADER_DIR} by embed-shaders.cmake.\n\n")
+string(APPEND HEADER "#ifndef STATIC_SHADERS_HXX\n#define STATIC_SHADERS_HXX\n\n")
+string(APPEND HEADER "#include <cstddef>\n#include <string_view>\n\n")
+string(APPEND HEADER "namespace my::staticShaders {\n\n")
+string(APPEND HEADER "struct Variant {\n")
+string(APPEND HEADER "  std::string_view vertex;\n  std::string_view fragment;\n")
+string(APPEND HEADER "};\n\n")
+string(APPEND HEADER "constexpr std::string_view features[]{")
+set(SEPARATOR "")
+foreach(FEATURE IN LISTS FEATURES)
+  string(APPEND HEADER "${SEPARATOR}\"${FEATURE}\"")
+  set(SEPARATOR ", ")
+endforeach()
+string(APPEND HEADER "};\n")
+string(APPEND HEADER "constexpr std::size_t variantCount{${VARIANT_COUNT}};\n")
+
+file(GLOB VERTEX_SHADERS "${SHADER_DIR}/*.vert")
+list(SORT VERTEX_SHADERS)
+foreach(VERTEX_PATH IN LISTS VERTEX_SHADERS)
+  get_filename_component(NAME "${VERTEX_PATH}" NAME_WE)
+  set(FRAGMENT_PATH "${SHADER_DIR}/${NAME}.frag")
+  if(NOT EXISTS "${FRAGMENT_PATH}")
+    message(FATAL_ERROR "No fragment shader for ${VERTEX_PATH}")
+  endif()
+  file(READ "${VERTEX_PATH}" VERTEX_SOURCE)
+  file(READ "${FRAGMENT_PATH}" FRAGMENT_SOURCE)
+  string(MAKE_C_IDENTIFIER "${NAME}" IDENTIFIER)
+  string(APPEND HEADER "\nconstexpr Variant ${IDENTIFIER}Variants[]{\n")
+  foreach(KEY RANGE ${LAST_VARIANT})
+    make_variant("${VERTEX_SOURCE}" ${KEY} VERTEX_VARIANT)
+    make_variant("${FRAGMENT_SOURCE}" ${KEY} FRAGMENT_VARIANT)
+    string(APPEND HEADER "  {\n")
+    string(APPEND HEADER "    R\"glsl(${VERTEX_VARIANT})glsl\",\n")
+    string(APPEND HEADER "    R\"glsl(${FRAGMENT_VARIANT})glsl\"\n")
+    string(APPEND HEADER "  },\n")
+  endforeach()
+  string(APPEND HEADER "};\n")
+endforeach()
+
+string(APPEND HEADER "\n} // namespace my::staticShaders\n\n")
+string(APPEND HEADER "#endif // STATIC_SHADERS_HXX\n")
+
+file(WRITE "${OUTPUT}" "${HEADER}")
@@ -7,9 +7,21 @@ precision mediump float;
 #endif
 
 in vec3 vertexColor;
+#ifdef USE_FOG
+in float viewDistance;
+
+// The clear color, so that distant geometry fades into the background.
+const vec3 fogColor = vec3(0., .5, 1.);
+const float fogDensity = .015;
+#endif
 
 out vec4 fragColor;
 
 void main() {
+#ifdef USE_FOG
+  float fogAmount = 1. - exp(-fogDensity*viewDistance);
+  fragColor = vec4(mix(vertexColor, fogColor, fogAmount), 1.);
+#else
   fragColor = vec4(vertexColor, 1.);
+#endif
 }
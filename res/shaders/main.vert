@@ -1,16 +1,41 @@
 #version 330
 
-in vec3 position;
-in vec3 color;
+// Locations match my::AttributeLocation.
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+#ifdef USE_INSTANCING
+layout(location = 3) in mat4 model;
+#endif
 
-uniform mat4 projection;
-uniform mat4 view;
+layout(std140) uniform Camera {
+  mat4 projection;
+  mat4 view;
+  mat4 viewProjection;
+};
+#ifndef USE_INSTANCING
 uniform mat4 model;
+#endif
+
+// A fixed light from above; the ambient term keeps faces turned away
+// from it readable.
+const vec3 lightDirection = normalize(vec3(.3, .9, .6));
+const float ambient = .4;
 
 out vec3 vertexColor;
+#ifdef USE_FOG
+out float viewDistance;
+#endif
 
 void main() {
-  gl_Position = projection*view*model*vec4(position, 1.);
+  gl_Position = viewProjection*model*vec4(position, 1.);
   // gl_Position = vec4(position, 1.);
-  vertexColor = color;
+  // Models are only scaled uniformly, so the model matrix can turn
+  // normals as is.
+  vec3 worldNormal = normalize(mat3(model)*normal);
+  float diffuse = max(dot(worldNormal, lightDirection), 0.);
+  vertexColor = color*(ambient + (1. - ambient)*diffuse);
+#ifdef USE_FOG
+  viewDistance = length((view*model*vec4(position, 1.)).xyz);
+#endif
 }
@@ -0,0 +1,413 @@
+// Times the engine's hot paths and writes the results as JSON, so runs
+// from different versions can be diffed:
+//
+//   world-3d-bench [--output <file>] [--filter <text>] [--min-time <ms>]
+//
+// Rendering goes through the same window handler as the engine; build
+// with USE_WINDOWING_SYSTEM=EGL to run it headless.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "camera.hxx"
+#include "game.hxx"
+#include "graphics-engine.hxx"
+#include "graphics-types.hxx"
+#include "io.hxx"
+#include "logger.hxx"
+#include "models.hxx"
+#include "thread-pool.hxx"
+#include "vertex-format.hxx"
+#include "window.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+struct BenchmarkOptions {
+  std::optional<std::string> output{};
+  std::string filter{};
+  std::chrono::milliseconds minTime{500};
+};
+
+// Per-operation times in nanoseconds, over batches of operations.
+struct BenchmarkResult {
+  std::string name{};
+  std::uint64_t iterations{};
+  double min{};
+  double p50{};
+  double p95{};
+  double mean{};
+  // Bytes each operation processes, for throughput; zero if it doesn't
+  // apply.
+  std::size_t bytesPerOperation{};
+};
+
+class BenchmarkRunner {
+public:
+  BenchmarkRunner(const BenchmarkOptions& options);
+
+  // Skipped unless the name contains the filter.
+  auto run(
+    std::string name, const std::function<void()>& operation,
+    std::size_t bytesPerOperation = 0
+  ) -> void;
+  auto getResults() const -> const std::vector<BenchmarkResult>&;
+
+private:
+  const BenchmarkOptions& _options;
+  std::vector<BenchmarkResult> _results{};
+};
+
+auto parseBenchmarkOptions(int argc, char** argv) -> BenchmarkOptions;
+auto benchmarkCamera(BenchmarkRunner& runner) -> void;
+auto benchmarkGeometry(BenchmarkRunner& runner) -> void;
+auto benchmarkReadFile(BenchmarkRunner& runner) -> void;
+// Returns the renderer's name.
+auto benchmarkGL(BenchmarkRunner& runner) -> std::string;
+auto percentile(const std::vector<double>& sorted, double fraction)
+-> double;
+auto writeResults(
+  std::ostream& out, const std::vector<BenchmarkResult>& results,
+  const std::string& renderer
+) -> void;
+auto writeString(std::ostream& out, std::string_view string) -> void;
+
+// Each timed batch runs long enough for the clock to resolve it.
+constexpr std::chrono::microseconds minBatchTime{200};
+constexpr std::size_t minSamples{5};
+constexpr std::size_t maxSamples{10000};
+constexpr std::size_t readFileSize{1 << 20};
+// Scenes for the render benchmark, in objects.
+constexpr std::size_t sceneSizes[]{1, 1000, 100000};
+
+// Results are folded into this so that the work can't be optimized out.
+volatile std::uint64_t sink{};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto main(int argc, char** argv) -> int {
+  my::LogThread logThread{};
+  try {
+    const BenchmarkOptions options{parseBenchmarkOptions(argc, argv)};
+    BenchmarkRunner runner{options};
+    benchmarkCamera(runner);
+    benchmarkGeometry(runner);
+    benchmarkReadFile(runner);
+    const std::string renderer{benchmarkGL(runner)};
+
+    if (options.output) {
+      std::ofstream file{*options.output};
+      writeResults(file, runner.getResults(), renderer);
+      if (!file) {
+        throw std::runtime_error{"Failed to write " + *options.output};
+      }
+    } else {
+      writeResults(std::cout, runner.getResults(), renderer);
+    }
+  } catch (std::exception& ex) {
+    my::Logger::flush();
+    std::cerr << ex.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
+
+namespace {
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options)
+: _options{options} {}
+
+auto BenchmarkRunner::run(
+  std::string name, const std::function<void()>& operation,
+  std::size_t bytesPerOperation
+) -> void {
+  if (name.find(_options.filter) == std::string::npos) {
+    return;
+  }
+  using Clock = std::chrono::steady_clock;
+  const auto timeBatch{[&operation](std::size_t size) {
+    const auto start{Clock::now()};
+    for (std::size_t i{}; i < size; i++) {
+      operation();
+    }
+    return Clock::now() - start;
+  }};
+
+  // Doubling the batch until it's long enough also warms up caches and
+  // whatever the driver sets up lazily.
+  std::size_t batchSize{1};
+  while (timeBatch(batchSize) < minBatchTime) {
+    batchSize *= 2;
+  }
+  std::vector<double> samples{};
+  const auto start{Clock::now()};
+  while (
+    samples.size() < minSamples
+    || (Clock::now() - start < _options.minTime && samples.size() < maxSamples)
+  ) {
+    const std::chrono::duration<double, std::nano> time{timeBatch(batchSize)};
+    samples.push_back(time.count()/static_cast<double>(batchSize));
+  }
+
+  std::sort(samples.begin(), samples.end());
+  BenchmarkResult result{};
+  result.name = std::move(name);
+  result.iterations = samples.size()*batchSize;
+  result.min = samples.front();
+  result.p50 = percentile(samples, .5);
+  result.p95 = percentile(samples, .95);
+  for (const auto sample : samples) {
+    result.mean += sample;
+  }
+  result.mean /= static_cast<double>(samples.size());
+  result.bytesPerOperation = bytesPerOperation;
+  std::cerr << result.name << ": " << std::fixed << std::setprecision(1);
+  std::cerr << result.p50 << " ns\n" << std::defaultfloat;
+  _results.push_back(std::move(result));
+}
+
+auto BenchmarkRunner::getResults() const
+-> const std::vector<BenchmarkResult>& {
+  return _results;
+}
+
+auto parseBenchmarkOptions(int argc, char** argv) -> BenchmarkOptions {
+  BenchmarkOptions options{};
+  for (int i{1}; i < argc; i++) {
+    const std::string_view argument{argv[i]};
+    if (i + 1 >= argc) {
+      throw std::runtime_error{
+        "Missing value for " + std::string{argument}
+      };
+    }
+    if (argument == "--output") {
+      options.output = argv[++i];
+    } else if (argument == "--filter") {
+      options.filter = argv[++i];
+    } else if (argument == "--min-time") {
+      options.minTime = std::chrono::milliseconds{std::stoi(argv[++i])};
+    } else {
+      throw std::runtime_error{
+        "Unknown option: " + std::string{argument}
+      };
+    }
+  }
+  return options;
+}
+
+auto benchmarkCamera(BenchmarkRunner& runner) -> void {
+  my::Camera camera{glm::radians(90.f), 1.f, .1f, 100.f};
+  camera.move(0.f, 0.f, -1.f);
+  runner.run("camera-update", [&camera]() {
+    camera.update(1.f/60.f);
+    sink = sink + static_cast<std::uint64_t>(
+      static_cast<std::int64_t>(camera.getViewMatrix()[3].z)
+    );
+  });
+  int width{400};
+  runner.run("camera-set-aspect-ratio", [&camera, &width]() {
+    // Alternates, so that the projection changes every time.
+    width = 1000 - width;
+    camera.setAspectRatio(width, 600);
+    sink = sink + static_cast<std::uint64_t>(
+      camera.getProjectionMatrix()[0].x
+    );
+  });
+}
+
+auto benchmarkGeometry(BenchmarkRunner& runner) -> void {
+  const my::BasicTriangle triangle{};
+  const my::MeshGeometry mesh{
+    {triangle.getVertices(), triangle.getVertices() + 9},
+    {triangle.getColors(), triangle.getColors() + 9},
+    {triangle.getIndices(), triangle.getIndices() + 3}
+  };
+  // Through the base class, as the engine calls them.
+  const std::vector<const my::Geometry*> geometries{&triangle, &mesh};
+  runner.run("geometry-accessors", [&geometries]() {
+    std::uint64_t total{};
+    for (const auto geometry : geometries) {
+      total += static_cast<std::uint64_t>(
+        geometry->getVertexCount() + geometry->getColorCount()
+        + geometry->getIndexCount() + geometry->getVertexMemorySize()
+        + geometry->getIndexMemorySize()
+      );
+      total += geometry->getIndices()[0];
+      total += static_cast<std::uint64_t>(
+        geometry->getVertices()[0] + geometry->getColors()[0]
+      );
+    }
+    sink = sink + total;
+  });
+}
+
+auto benchmarkReadFile(BenchmarkRunner& runner) -> void {
+  const std::string filePath{
+    (std::filesystem::temp_directory_path() / "world-3d-bench.bin").string()
+  };
+  const std::string contents(readFileSize, 'x');
+  if (!my::writeFile(filePath, contents.data(), contents.size())) {
+    throw std::runtime_error{"Failed to write " + filePath};
+  }
+  runner.run("read-file-1mib", [&filePath]() {
+    const std::optional<std::string> data{my::readFile(filePath)};
+    sink = sink + (data ? data->size() : 0);
+  }, readFileSize);
+  std::filesystem::remove(filePath);
+}
+
+auto benchmarkGL(BenchmarkRunner& runner) -> std::string {
+  my::WindowHandler window{};
+  my::ThreadPool workers{};
+  const my::RenderSettings settings{};
+  my::GraphicsEngine graphics{
+    window.getProcAddressLoader(), settings, workers
+  };
+  graphics.resize(window.getWidth(), window.getHeight());
+
+  {
+    const my::BasicTriangle triangle{};
+    const std::vector<my::PackedVertex> vertices{my::packVertices(triangle)};
+    const my::Buffer vertexBuffer{
+      my::BufferTarget::Array, vertices.data(),
+      static_cast<GLsizei>(vertices.size()*sizeof(my::PackedVertex))
+    };
+    const my::Buffer indexBuffer{
+      my::BufferTarget::ElementArray, triangle.getIndices(),
+      static_cast<GLsizei>(triangle.getIndexMemorySize())
+    };
+    my::VertexArrayBuilder builder{};
+    // Includes deleting the vertex array again.
+    runner.run("vertex-array-build", [&]() {
+      builder.setIndexCount(triangle.getIndexCount());
+      builder << &indexBuffer;
+      builder.addVertexBuffer<my::PackedVertex>(vertexBuffer);
+      const my::VertexArray vertexArray{builder.build()};
+      sink = sink + vertexArray.getID();
+    });
+
+    const my::ShaderProgram program{
+      my::Shader{my::ShaderType::Vertex,
+        "#version 330\n"
+        "uniform mat4 model;\n"
+        "uniform vec4 tint;\n"
+        "void main() { gl_Position = model*tint; }\n"},
+      my::Shader{my::ShaderType::Fragment,
+        "#version 330\n"
+        "out vec4 color;\n"
+        "void main() { color = vec4(1.); }\n"}
+    };
+    program.use();
+    const my::Uniform model{program, "model"};
+    const my::Uniform tint{program, "tint"};
+    glm::mat4 matrix{1.f};
+    runner.run("uniform-set-mat4", [&model, &matrix]() {
+      matrix[3].x += 1.f;
+      model.setData(matrix);
+    });
+    glm::vec4 vector{1.f};
+    runner.run("uniform-set-vec4", [&tint, &vector]() {
+      vector.x += 1.f;
+      tint.setData(vector);
+    });
+    glFinish();
+  }
+
+  // Whole frames, waiting for the GPU to finish each, on the same grid
+  // of triangles the engine draws with --objects.
+  const std::vector<my::ObjectState> staticObjects{};
+  for (const auto objectCount : sceneSizes) {
+    my::Game game{objectCount};
+    const my::GameState& state{game.getState()};
+    runner.run("render-" + std::to_string(objectCount), [&]() {
+      window.preRender();
+      graphics.render(state, 1.f, staticObjects);
+      window.postRender();
+      glFinish();
+    });
+  }
+  return reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+}
+
+auto percentile(const std::vector<double>& sorted, double fraction)
+-> double {
+  const auto index{static_cast<std::size_t>(
+    fraction*static_cast<double>(sorted.size() - 1) + .5
+  )};
+  return sorted[index];
+}
+
+auto writeResults(
+  std::ostream& out, const std::vector<BenchmarkResult>& results,
+  const std::string& renderer
+) -> void {
+  // One benchmark per line, keys in a fixed order, so that results diff
+  // cleanly.
+  out << "{\n";
+#ifdef DEBUG
+  out << "  \"build\": \"debug\",\n";
+#else
+  out << "  \"build\": \"release\",\n";
+#endif // DEBUG
+  out << "  \"renderer\": ";
+  writeString(out, renderer);
+  out << ",\n  \"unit\": \"ns\",\n";
+  out << "  \"benchmarks\": [";
+  const char* separator{"\n"};
+  out << std::fixed << std::setprecision(1);
+  for (const auto& result : results) {
+    out << separator << "    {\"name\": ";
+    writeString(out, result.name);
+    out << ", \"iterations\": " << result.iterations;
+    out << ", \"min\": " << result.min;
+    out << ", \"p50\": " << result.p50;
+    out << ", \"p95\": " << result.p95;
+    out << ", \"mean\": " << result.mean;
+    if (result.bytesPerOperation > 0) {
+      out << ", \"bytes\": " << result.bytesPerOperation;
+    }
+    out << '}';
+    separator = ",\n";
+  }
+  out << "\n  ]\n}\n";
+}
+
+auto writeString(std::ostream& out, std::string_view string) -> void {
+  out << '"';
+  for (const char c : string) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out << ' ';
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+} // namespace
@@ -0,0 +1,113 @@
+#include "bounds.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Relative error of the half floats meshes are stored with on the GPU;
+// bounds are padded by this so they still contain the rounded vertices.
+constexpr float halfEpsilon{1.f/2048.f};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::BoundingBox::getMin() const -> glm::vec3 {
+  return center - extent;
+}
+
+auto my::BoundingBox::getMax() const -> glm::vec3 {
+  return center + extent;
+}
+
+auto my::BoundingBox::getSurfaceArea() const -> float {
+  return 8.f*(extent.x*extent.y + extent.y*extent.z + extent.z*extent.x);
+}
+
+auto my::BoundingBox::transform(const glm::mat4& matrix) const
+-> BoundingBox {
+  // Arvo's method: each new half-extent is the old ones weighted by the
+  // absolute values of the matrix row, which bounds the rotated box.
+  BoundingBox box{};
+  for (int row{}; row < 3; row++) {
+    box.center[row] = matrix[3][row];
+    for (int column{}; column < 3; column++) {
+      box.center[row] += matrix[column][row]*center[column];
+      box.extent[row] += std::abs(matrix[column][row])*extent[column];
+    }
+  }
+  return box;
+}
+
+auto my::BoundingBox::fromMinMax(const glm::vec3& min, const glm::vec3& max)
+-> BoundingBox {
+  return {(min + max)*.5f, (max - min)*.5f};
+}
+
+auto my::BoundingBox::merge(const BoundingBox& a, const BoundingBox& b)
+-> BoundingBox {
+  return fromMinMax(
+    glm::min(a.getMin(), b.getMin()), glm::max(a.getMax(), b.getMax())
+  );
+}
+
+auto my::BoundingSphere::transform(const glm::mat4& matrix) const
+-> BoundingSphere {
+  // Non-uniform scales stretch the sphere into an ellipsoid; the longest
+  // axis bounds it.
+  const auto columnLength{[&](int column) {
+    return glm::length(
+      glm::vec3{matrix[column][0], matrix[column][1], matrix[column][2]}
+    );
+  }};
+  const float scale{
+    std::max({columnLength(0), columnLength(1), columnLength(2)})
+  };
+  const glm::vec4 moved{matrix*glm::vec4{center, 1.f}};
+  return {{moved.x, moved.y, moved.z}, radius*scale};
+}
+
+auto my::computeBounds(const Geometry& geometry) -> MeshBounds {
+  const GLfloat* positions{geometry.getVertices()};
+  const auto vertexCount{static_cast<std::size_t>(geometry.getVertexCount())};
+  if (vertexCount == 0) {
+    return {};
+  }
+  const auto position{[&](std::size_t vertex) {
+    return glm::vec3{
+      positions[vertex*3], positions[vertex*3 + 1], positions[vertex*3 + 2]
+    };
+  }};
+  glm::vec3 min{position(0)};
+  glm::vec3 max{min};
+  for (std::size_t i{1}; i < vertexCount; i++) {
+    min = glm::min(min, position(i));
+    max = glm::max(max, position(i));
+  }
+  MeshBounds bounds{};
+  bounds.box = BoundingBox::fromMinMax(min, max);
+  const float padding{
+    std::max({
+      std::abs(min.x), std::abs(min.y), std::abs(min.z),
+      std::abs(max.x), std::abs(max.y), std::abs(max.z)
+    })*halfEpsilon
+  };
+  bounds.box.extent += glm::vec3{padding};
+  // Centered on the box rather than the minimal sphere, which is close
+  // enough for culling and needs only one more pass.
+  bounds.sphere.center = bounds.box.center;
+  for (std::size_t i{}; i < vertexCount; i++) {
+    bounds.sphere.radius = std::max(
+      bounds.sphere.radius, glm::distance(bounds.sphere.center, position(i))
+    );
+  }
+  bounds.sphere.radius += padding*std::sqrt(3.f);
+  return bounds;
+}
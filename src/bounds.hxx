@@ -0,0 +1,46 @@
+#ifndef BOUNDS_HXX
+#define BOUNDS_HXX
+
+#include <glm/glm.hpp>
+
+#include "models.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Axis-aligned box stored as center and half-extents, which is what the
+// plane tests and transforms work with.
+struct BoundingBox {
+  glm::vec3 center{};
+  glm::vec3 extent{};
+
+  auto getMin() const -> glm::vec3;
+  auto getMax() const -> glm::vec3;
+  auto getSurfaceArea() const -> float;
+  auto transform(const glm::mat4& matrix) const -> BoundingBox;
+  static auto fromMinMax(const glm::vec3& min, const glm::vec3& max)
+  -> BoundingBox;
+  static auto merge(const BoundingBox& a, const BoundingBox& b)
+  -> BoundingBox;
+};
+
+struct BoundingSphere {
+  glm::vec3 center{};
+  float radius{};
+
+  auto transform(const glm::mat4& matrix) const -> BoundingSphere;
+};
+
+struct MeshBounds {
+  BoundingBox box{};
+  BoundingSphere sphere{};
+};
+
+auto computeBounds(const Geometry& geometry) -> MeshBounds;
+
+} // namespace my
+
+#endif // BOUNDS_HXX
@@ -0,0 +1,182 @@
+#include "bvh.hxx"
+
+#include <algorithm>
+#include <array>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto isSameBox(const my::BoundingBox& a, const my::BoundingBox& b) -> bool;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::BoundingVolumeHierarchy::build(const std::vector<BoundingBox>& boxes)
+-> void {
+  const auto count{static_cast<std::uint32_t>(boxes.size())};
+  _boxes = boxes;
+  _objects.resize(count);
+  for (std::uint32_t i{}; i < count; i++) {
+    _objects[i] = i;
+  }
+  _leaves.assign(count, 0);
+  _nodes.clear();
+  _nodes.reserve(2*(count/_leafSize + 1));
+  _dirtyLeaves.clear();
+  _nodes.push_back({});
+  if (count > 0) {
+    split(0, 0, count);
+  }
+  _leafDirty.assign(_nodes.size(), false);
+}
+
+auto my::BoundingVolumeHierarchy::update(
+  std::uint32_t object, const BoundingBox& box
+) -> void {
+  _boxes[object] = box;
+  const std::uint32_t leaf{_leaves[object]};
+  if (!_leafDirty[leaf]) {
+    _leafDirty[leaf] = true;
+    _dirtyLeaves.push_back(leaf);
+  }
+}
+
+auto my::BoundingVolumeHierarchy::refit() -> void {
+  for (const auto leaf : _dirtyLeaves) {
+    _leafDirty[leaf] = false;
+    const BoundingBox leafBox{computeLeafBox(_nodes[leaf])};
+    if (isSameBox(leafBox, _nodes[leaf].box)) {
+      continue;
+    }
+    _nodes[leaf].box = leafBox;
+    // Walk up until a parent comes out unchanged; everything above it
+    // already covers this branch.
+    for (std::uint32_t node{leaf}; node != 0;) {
+      Node& parent{_nodes[_nodes[node].parent]};
+      const BoundingBox box{BoundingBox::merge(
+        _nodes[parent.first].box, _nodes[parent.first + 1].box
+      )};
+      if (isSameBox(box, parent.box)) {
+        break;
+      }
+      parent.box = box;
+      node = _nodes[node].parent;
+    }
+  }
+  _dirtyLeaves.clear();
+}
+
+auto my::BoundingVolumeHierarchy::getObjectCount() const -> std::size_t {
+  return _boxes.size();
+}
+
+auto my::BoundingVolumeHierarchy::cull(
+  const Frustum& frustum, std::vector<std::uint32_t>& visible
+) const -> void {
+  if (_boxes.empty()) {
+    return;
+  }
+  // Once a node is entirely inside, nothing below it needs testing.
+  std::array<std::uint32_t, _maxDepth> stack{};
+  std::array<bool, _maxDepth> insideStack{};
+  std::size_t depth{};
+  stack[depth] = 0;
+  insideStack[depth++] = false;
+  while (depth > 0) {
+    depth--;
+    const Node& node{_nodes[stack[depth]]};
+    bool inside{insideStack[depth]};
+    if (!inside) {
+      const Containment containment{frustum.test(node.box)};
+      if (containment == Containment::Outside) {
+        continue;
+      }
+      inside = containment == Containment::Inside;
+    }
+    if (node.count == 0) {
+      stack[depth] = node.first;
+      insideStack[depth++] = inside;
+      stack[depth] = node.first + 1;
+      insideStack[depth++] = inside;
+      continue;
+    }
+    for (std::uint32_t i{node.first}; i < node.first + node.count; i++) {
+      const std::uint32_t object{_objects[i]};
+      if (
+        inside || node.count == 1
+        || frustum.test(_boxes[object]) != Containment::Outside
+      ) {
+        visible.push_back(object);
+      }
+    }
+  }
+}
+
+auto my::BoundingVolumeHierarchy::split(
+  std::uint32_t node, std::uint32_t first, std::uint32_t count
+) -> void {
+  _nodes[node].first = first;
+  _nodes[node].count = count;
+  _nodes[node].box = computeLeafBox(_nodes[node]);
+  if (count <= _leafSize) {
+    for (std::uint32_t i{first}; i < first + count; i++) {
+      _leaves[_objects[i]] = node;
+    }
+    return;
+  }
+
+  // Split at the median along the axis the centers are most spread on.
+  glm::vec3 min{_boxes[_objects[first]].center};
+  glm::vec3 max{min};
+  for (std::uint32_t i{first + 1}; i < first + count; i++) {
+    min = glm::min(min, _boxes[_objects[i]].center);
+    max = glm::max(max, _boxes[_objects[i]].center);
+  }
+  const glm::vec3 spread{max - min};
+  int axis{spread.y > spread.x ? 1 : 0};
+  if (spread.z > spread[axis]) {
+    axis = 2;
+  }
+  const auto begin{_objects.begin() + first};
+  const auto middle{begin + count/2};
+  std::nth_element(
+    begin, middle, begin + count, [&](std::uint32_t a, std::uint32_t b) {
+      return _boxes[a].center[axis] < _boxes[b].center[axis];
+    }
+  );
+
+  const auto left{static_cast<std::uint32_t>(_nodes.size())};
+  _nodes.push_back({});
+  _nodes.push_back({});
+  _nodes[left].parent = node;
+  _nodes[left + 1].parent = node;
+  _nodes[node].first = left;
+  _nodes[node].count = 0;
+  split(left, first, count/2);
+  split(left + 1, first + count/2, count - count/2);
+}
+
+auto my::BoundingVolumeHierarchy::computeLeafBox(const Node& leaf) const
+-> BoundingBox {
+  glm::vec3 min{_boxes[_objects[leaf.first]].getMin()};
+  glm::vec3 max{_boxes[_objects[leaf.first]].getMax()};
+  for (std::uint32_t i{leaf.first + 1}; i < leaf.first + leaf.count; i++) {
+    min = glm::min(min, _boxes[_objects[i]].getMin());
+    max = glm::max(max, _boxes[_objects[i]].getMax());
+  }
+  return BoundingBox::fromMinMax(min, max);
+}
+
+namespace {
+
+auto isSameBox(const my::BoundingBox& a, const my::BoundingBox& b) -> bool {
+  return a.center == b.center && a.extent == b.extent;
+}
+
+} // namespace
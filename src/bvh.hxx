@@ -0,0 +1,72 @@
+#ifndef BVH_HXX
+#define BVH_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bounds.hxx"
+#include "frustum.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Bounding volume hierarchy over object boxes, for culling. Built once
+// by median splits, then kept up to date by refitting only the branches
+// above objects that moved. Refitting never reorders the tree, so it
+// stays tight only while objects move coherently; rebuild when the set
+// of objects changes.
+class BoundingVolumeHierarchy {
+public:
+  BoundingVolumeHierarchy() = default;
+  BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+  BoundingVolumeHierarchy(BoundingVolumeHierarchy&&) = delete;
+  auto operator=(const BoundingVolumeHierarchy&)
+  -> BoundingVolumeHierarchy& = delete;
+  auto operator=(BoundingVolumeHierarchy&&)
+  -> BoundingVolumeHierarchy& = delete;
+
+  auto build(const std::vector<BoundingBox>& boxes) -> void;
+  // Takes effect on the next refit().
+  auto update(std::uint32_t object, const BoundingBox& box) -> void;
+  auto refit() -> void;
+  auto getObjectCount() const -> std::size_t;
+  // Appends the objects that may be visible, in no particular order.
+  auto cull(const Frustum& frustum, std::vector<std::uint32_t>& visible) const
+  -> void;
+
+private:
+  struct Node {
+    BoundingBox box{};
+    // Inner nodes: the left child, with the right one after it. Leaves:
+    // the first of their entries in _objects.
+    std::uint32_t first{};
+    // Zero for inner nodes.
+    std::uint32_t count{};
+    std::uint32_t parent{};
+  };
+
+  static constexpr std::uint32_t _leafSize{4};
+  // Deep enough for any tree built by median splits of 32-bit counts.
+  static constexpr std::size_t _maxDepth{64};
+
+  std::vector<Node> _nodes{};
+  // Object indices, grouped by leaf.
+  std::vector<std::uint32_t> _objects{};
+  std::vector<BoundingBox> _boxes{};
+  // The leaf holding each object.
+  std::vector<std::uint32_t> _leaves{};
+  std::vector<std::uint32_t> _dirtyLeaves{};
+  std::vector<bool> _leafDirty{};
+
+  auto split(std::uint32_t node, std::uint32_t first, std::uint32_t count)
+  -> void;
+  auto computeLeafBox(const Node& leaf) const -> BoundingBox;
+};
+
+} // namespace my
+
+#endif // BVH_HXX
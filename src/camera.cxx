@@ -16,20 +16,24 @@ auto my::Camera::setAspectRatio(int width, int height) -> void {
 
 auto my::Camera::setX(float x) -> void {
   _viewMatrix[3][0] = -x;
+  _previousViewMatrix = _viewMatrix;
 }
 
 auto my::Camera::setY(float y) -> void {
   _viewMatrix[3][1] = -y;
+  _previousViewMatrix = _viewMatrix;
 }
 
 auto my::Camera::setZ(float z) -> void {
   _viewMatrix[3][2] = -z;
+  _previousViewMatrix = _viewMatrix;
 }
 
 auto my::Camera::setPosition(float x, float y, float z) -> void {
   _viewMatrix[3][0] = -x;
   _viewMatrix[3][1] = -y;
   _viewMatrix[3][2] = -z;
+  _previousViewMatrix = _viewMatrix;
 }
 
 auto my::Camera::moveX(float dx) -> void {
@@ -54,8 +58,9 @@ auto my::Camera::roll(float) -> void {}
 auto my::Camera::yaw(float) -> void {}
 auto my::Camera::pitch(float) -> void {}
 
-auto my::Camera::update() -> void {
-  _viewMatrix = glm::translate(_viewMatrix, _translateVector);
+auto my::Camera::update(float dt) -> void {
+  _previousViewMatrix = _viewMatrix;
+  _viewMatrix = glm::translate(_viewMatrix, _translateVector*dt);
 }
 
 auto my::Camera::getProjectionMatrix() const -> const glm::mat4& {
@@ -65,3 +70,7 @@ auto my::Camera::getProjectionMatrix() const -> const glm::mat4& {
 auto my::Camera::getViewMatrix() const -> const glm::mat4& {
   return _viewMatrix;
 }
+
+auto my::Camera::getPreviousViewMatrix() const -> const glm::mat4& {
+  return _previousViewMatrix;
+}
@@ -23,13 +23,16 @@ public:
   auto roll(float dax) -> void;
   auto yaw(float day) -> void;
   auto pitch(float daz) -> void;
-  auto update() -> void;
+  auto update(float dt) -> void;
   auto getProjectionMatrix() const -> const glm::mat4&;
   auto getViewMatrix() const -> const glm::mat4&;
+  auto getPreviousViewMatrix() const -> const glm::mat4&;
 
 private:
   glm::mat4 _projectionMatrix{1.};
   glm::mat4 _viewMatrix{1.};
+  glm::mat4 _previousViewMatrix{1.};
+  // Velocity in world units per second, applied by update.
   glm::vec3 _translateVector{};
   float _fovy;
   float _aspect;
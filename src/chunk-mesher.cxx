@@ -0,0 +1,274 @@
+#include "chunk-mesher.hxx"
+
+#include <algorithm>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Voxels of the chunk with a one-voxel border taken from its neighbors.
+class PaddedVoxels {
+public:
+  PaddedVoxels(const my::ChunkNeighborhood& chunks);
+
+  // Coordinates run from -1 to VoxelChunk::size.
+  auto get(const std::array<int, 3>& position) const -> my::Voxel;
+
+private:
+  static constexpr int _size{my::VoxelChunk::size + 2};
+
+  std::vector<my::Voxel> _voxels;
+
+  auto at(int x, int y, int z) -> my::Voxel&;
+};
+
+constexpr int chunkSize{my::VoxelChunk::size};
+constexpr std::size_t voxelColorCount{6};
+constexpr std::array<GLfloat, voxelColorCount*3> voxelColors{
+  .36f, .62f, .25f,
+  .47f, .35f, .22f,
+  .5f, .5f, .52f,
+  .86f, .8f, .55f,
+  .95f, .95f, .97f,
+  .2f, .4f, .8f
+};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::ChunkGeometry::getVertices() const -> const GLfloat* {
+  return _vertices.data();
+}
+
+auto my::ChunkGeometry::getColors() const -> const GLfloat* {
+  return _colors.data();
+}
+
+auto my::ChunkGeometry::getIndices() const -> const GLuint* {
+  return _indices.data();
+}
+
+auto my::ChunkGeometry::getVertexArraySize() const -> GLint {
+  return static_cast<GLint>(_vertices.size());
+}
+
+auto my::ChunkGeometry::getColorArraySize() const -> GLint {
+  return static_cast<GLint>(_colors.size());
+}
+
+auto my::ChunkGeometry::getIndexArraySize() const -> GLint {
+  return static_cast<GLint>(_indices.size());
+}
+
+auto my::ChunkGeometry::addQuad(
+  const std::array<glm::vec3, 4>& corners, glm::vec3 color
+) -> void {
+  const auto first{static_cast<GLuint>(_vertices.size()/3)};
+  for (const auto& corner : corners) {
+    _vertices.insert(_vertices.end(), {corner.x, corner.y, corner.z});
+    _colors.insert(_colors.end(), {color.x, color.y, color.z});
+  }
+  _indices.insert(_indices.end(), {
+    first, static_cast<GLuint>(first + 1), static_cast<GLuint>(first + 2),
+    first, static_cast<GLuint>(first + 2), static_cast<GLuint>(first + 3)
+  });
+}
+
+auto my::meshChunk(const ChunkNeighborhood& chunks)
+-> std::optional<ChunkGeometry> {
+  if (chunks.center.isEmpty()) {
+    return std::nullopt;
+  }
+  ChunkGeometry geometry{};
+  const PaddedVoxels voxels{chunks};
+  std::vector<Voxel> mask(static_cast<std::size_t>(chunkSize*chunkSize));
+  // Sweep each axis d in both directions, one slice at a time; u and v
+  // span the slice so that u x v points along +d.
+  for (std::size_t d{}; d < 3; d++) {
+    const std::size_t u{(d + 1) % 3};
+    const std::size_t v{(d + 2) % 3};
+    for (const int direction : {-1, 1}) {
+      for (int slice{}; slice < chunkSize; slice++) {
+        // Faces exposed in this slice, by material.
+        for (int j{}; j < chunkSize; j++) {
+          for (int i{}; i < chunkSize; i++) {
+            std::array<int, 3> position{};
+            position[d] = slice;
+            position[u] = i;
+            position[v] = j;
+            const Voxel voxel{voxels.get(position)};
+            position[d] += direction;
+            mask[static_cast<std::size_t>(j*chunkSize + i)] =
+              voxel != emptyVoxel && voxels.get(position) == emptyVoxel
+              ? voxel : emptyVoxel;
+          }
+        }
+        // Grow each face into the widest, then tallest, rectangle of the
+        // same material and clear what it covers.
+        for (int j{}; j < chunkSize; j++) {
+          for (int i{}; i < chunkSize;) {
+            const Voxel voxel{mask[static_cast<std::size_t>(j*chunkSize + i)]};
+            if (voxel == emptyVoxel) {
+              i++;
+              continue;
+            }
+            const auto row{mask.begin() + j*chunkSize};
+            int width{1};
+            while (i + width < chunkSize && row[i + width] == voxel) {
+              width++;
+            }
+            int height{1};
+            for (; j + height < chunkSize; height++) {
+              const auto next{row + height*chunkSize};
+              if (!std::all_of(
+                next + i, next + i + width,
+                [voxel](Voxel other) { return other == voxel; }
+              )) {
+                break;
+              }
+            }
+            for (int cleared{j}; cleared < j + height; cleared++) {
+              std::fill_n(
+                mask.begin() + cleared*chunkSize + i, width, emptyVoxel
+              );
+            }
+
+            glm::vec3 origin{};
+            origin[static_cast<int>(d)] = static_cast<float>(
+              direction > 0 ? slice + 1 : slice
+            );
+            origin[static_cast<int>(u)] = static_cast<float>(i);
+            origin[static_cast<int>(v)] = static_cast<float>(j);
+            glm::vec3 across{};
+            across[static_cast<int>(u)] = static_cast<float>(width);
+            glm::vec3 up{};
+            up[static_cast<int>(v)] = static_cast<float>(height);
+            if (direction > 0) {
+              geometry.addQuad(
+                {origin, origin + across, origin + across + up, origin + up},
+                getVoxelColor(voxel)
+              );
+            } else {
+              geometry.addQuad(
+                {origin, origin + up, origin + across + up, origin + across},
+                getVoxelColor(voxel)
+              );
+            }
+            i += width;
+          }
+        }
+      }
+    }
+  }
+  if (geometry.getIndexCount() == 0) {
+    return std::nullopt;
+  }
+  return geometry;
+}
+
+auto my::buildChunkOccluder(const VoxelChunk& chunk)
+-> std::optional<ChunkGeometry> {
+  int bestStart{};
+  int bestLayers{};
+  int layers{};
+  for (int y{}; y < chunkSize; y++) {
+    bool solid{true};
+    for (int z{}; z < chunkSize && solid; z++) {
+      for (int x{}; x < chunkSize && solid; x++) {
+        solid = chunk.get(x, y, z) != emptyVoxel;
+      }
+    }
+    layers = solid ? layers + 1 : 0;
+    if (layers > bestLayers) {
+      bestLayers = layers;
+      bestStart = y + 1 - layers;
+    }
+  }
+  if (bestLayers == 0) {
+    return std::nullopt;
+  }
+  const auto size{static_cast<float>(chunkSize)};
+  const glm::vec3 min{0.f, static_cast<float>(bestStart), 0.f};
+  const glm::vec3 max{size, static_cast<float>(bestStart + bestLayers), size};
+  // The six faces, wound the same way as meshChunk() winds them.
+  ChunkGeometry geometry{};
+  for (int d{}; d < 3; d++) {
+    const int u{(d + 1) % 3};
+    const int v{(d + 2) % 3};
+    for (const int direction : {-1, 1}) {
+      glm::vec3 origin{min};
+      if (direction > 0) {
+        origin[d] = max[d];
+      }
+      glm::vec3 across{};
+      across[u] = max[u] - min[u];
+      glm::vec3 up{};
+      up[v] = max[v] - min[v];
+      if (direction > 0) {
+        geometry.addQuad(
+          {origin, origin + across, origin + across + up, origin + up}, {}
+        );
+      } else {
+        geometry.addQuad(
+          {origin, origin + up, origin + across + up, origin + across}, {}
+        );
+      }
+    }
+  }
+  return geometry;
+}
+
+auto my::getVoxelColor(Voxel voxel) -> glm::vec3 {
+  const std::size_t color{
+    static_cast<std::size_t>(voxel - 1) % voxelColorCount
+  };
+  return {
+    voxelColors[color*3], voxelColors[color*3 + 1], voxelColors[color*3 + 2]
+  };
+}
+
+namespace {
+
+PaddedVoxels::PaddedVoxels(const my::ChunkNeighborhood& chunks)
+: _voxels(static_cast<std::size_t>(_size*_size*_size), my::emptyVoxel) {
+  const my::VoxelChunk& center{chunks.center};
+  const auto& neighbors{chunks.neighbors};
+  for (int z{}; z < chunkSize; z++) {
+    for (int y{}; y < chunkSize; y++) {
+      for (int x{}; x < chunkSize; x++) {
+        at(x, y, z) = center.get(x, y, z);
+      }
+    }
+  }
+  constexpr int last{chunkSize - 1};
+  for (int a{}; a < chunkSize; a++) {
+    for (int b{}; b < chunkSize; b++) {
+      at(-1, a, b) = neighbors[0].get(last, a, b);
+      at(chunkSize, a, b) = neighbors[1].get(0, a, b);
+      at(a, -1, b) = neighbors[2].get(a, last, b);
+      at(a, chunkSize, b) = neighbors[3].get(a, 0, b);
+      at(a, b, -1) = neighbors[4].get(a, b, last);
+      at(a, b, chunkSize) = neighbors[5].get(a, b, 0);
+    }
+  }
+}
+
+auto PaddedVoxels::get(const std::array<int, 3>& position) const
+-> my::Voxel {
+  return _voxels[static_cast<std::size_t>(
+    ((position[2] + 1)*_size + position[1] + 1)*_size + position[0] + 1
+  )];
+}
+
+auto PaddedVoxels::at(int x, int y, int z) -> my::Voxel& {
+  return _voxels[static_cast<std::size_t>(
+    ((z + 1)*_size + y + 1)*_size + x + 1
+  )];
+}
+
+} // namespace
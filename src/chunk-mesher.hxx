@@ -0,0 +1,64 @@
+#ifndef CHUNK_MESHER_HXX
+#define CHUNK_MESHER_HXX
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "models.hxx"
+#include "voxel-chunk.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Mesh of one chunk, in chunk-local coordinates from 0 to
+// VoxelChunk::size on each axis.
+class ChunkGeometry : public Geometry {
+public:
+  auto getVertices() const -> const GLfloat* final;
+  auto getColors() const -> const GLfloat* final;
+  auto getIndices() const -> const GLuint* final;
+  auto getVertexArraySize() const -> GLint final;
+  auto getColorArraySize() const -> GLint final;
+  auto getIndexArraySize() const -> GLint final;
+  // Corners go counter-clockwise as seen from the front.
+  auto addQuad(const std::array<glm::vec3, 4>& corners, glm::vec3 color)
+  -> void;
+
+private:
+  std::vector<GLfloat> _vertices{};
+  std::vector<GLfloat> _colors{};
+  std::vector<GLuint> _indices{};
+};
+
+// A chunk's voxels along with copies of its six face neighbors, which
+// decide whether faces on the chunk's border are visible. Being copies,
+// they can be meshed on another thread while the world changes.
+struct ChunkNeighborhood {
+  VoxelChunk center{};
+  // -x, +x, -y, +y, -z, +z; empty where there is no neighbor.
+  std::array<VoxelChunk, 6> neighbors{};
+};
+
+// Merges coplanar faces of the same material into rectangles (greedy
+// meshing). An empty or fully enclosed chunk gives no mesh.
+auto meshChunk(const ChunkNeighborhood& chunks)
+-> std::optional<ChunkGeometry>;
+// Box over the thickest run of layers (along y) that are solid all the
+// way across, to stand in for the chunk in the occlusion buffer; none if
+// no layer is. Every voxel is opaque, so it never hides anything the
+// chunk's mesh wouldn't.
+auto buildChunkOccluder(const VoxelChunk& chunk)
+-> std::optional<ChunkGeometry>;
+auto getVoxelColor(Voxel voxel) -> glm::vec3;
+
+} // namespace my
+
+#endif // CHUNK_MESHER_HXX
@@ -0,0 +1,174 @@
+// Converts an OBJ model into a mesh file (see mesh-file.hxx), with its
+// levels of detail, so the engine can map it instead of parsing it:
+//
+//   world-3d-convert <input.obj> <output.mesh> [--levels <count>]
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "io.hxx"
+#include "logger.hxx"
+#include "mesh-file.hxx"
+#include "models.hxx"
+#include "simplify.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Reads positions, optional vertex colors (as "v x y z r g b") and
+// faces, which are triangulated as fans. Texture coordinates and
+// normals are ignored; the vertex format has neither.
+auto loadObj(std::string_view filePath) -> my::MeshGeometry;
+auto parseIndex(const char*& cursor, std::size_t vertexCount) -> GLuint;
+auto skipSpace(const char* cursor, const char* end) -> const char*;
+
+constexpr std::size_t defaultLevelCount{4};
+// For models without vertex colors.
+constexpr GLfloat defaultShade{.8f};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto main(int argc, char** argv) -> int {
+  my::LogThread logThread{};
+  try {
+    std::size_t levelCount{defaultLevelCount};
+    if (argc == 5 && std::string_view{argv[3]} == "--levels") {
+      levelCount = static_cast<std::size_t>(std::stoul(argv[4]));
+    } else if (argc != 3) {
+      std::cerr << "Usage: " << argv[0];
+      std::cerr << " <input.obj> <output.mesh> [--levels <count>]\n";
+      return EXIT_FAILURE;
+    }
+    const my::MeshGeometry geometry{loadObj(argv[1])};
+    const std::vector<my::MeshGeometry> levels{
+      my::buildLevelsOfDetail(geometry, levelCount)
+    };
+    if (!my::writeMeshFile(argv[2], geometry, levels)) {
+      throw std::runtime_error{
+        "Failed to write mesh file: " + std::string{argv[2]}
+      };
+    }
+    std::cout << argv[2] << ": " << geometry.getVertexCount();
+    std::cout << " vertices, " << geometry.getIndexCount()/3;
+    std::cout << " triangles, " << levels.size() << " levels of detail\n";
+  } catch (std::exception& ex) {
+    my::Logger::flush();
+    std::cerr << ex.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
+
+namespace {
+
+auto loadObj(std::string_view filePath) -> my::MeshGeometry {
+  const std::optional<std::string> text{my::readFile(filePath)};
+  if (!text) {
+    throw std::runtime_error{"Failed to read " + std::string{filePath}};
+  }
+  std::vector<GLfloat> positions{};
+  std::vector<GLfloat> colors{};
+  std::vector<GLuint> indices{};
+  std::vector<GLuint> face{};
+  const char* cursor{text->data()};
+  const char* const end{text->data() + text->size()};
+  while (cursor < end) {
+    const char* lineEnd{cursor};
+    while (lineEnd < end && *lineEnd != '\n') {
+      lineEnd++;
+    }
+    // Lines are parsed in place; strtof() and friends stop at the
+    // newline, or at the string's terminator after the last line.
+    cursor = skipSpace(cursor, lineEnd);
+    if (lineEnd - cursor > 2 && cursor[0] == 'v' && cursor[1] == ' ') {
+      cursor += 2;
+      GLfloat values[6]{};
+      std::size_t count{};
+      for (; count < 6; count++) {
+        char* next{};
+        values[count] = std::strtof(cursor, &next);
+        if (next == cursor || next > lineEnd) {
+          break;
+        }
+        cursor = next;
+      }
+      if (count < 3) {
+        throw std::runtime_error{
+          "Malformed vertex in " + std::string{filePath}
+        };
+      }
+      positions.insert(positions.end(), values, values + 3);
+      if (count == 6) {
+        colors.insert(colors.end(), values + 3, values + 6);
+      } else {
+        colors.insert(colors.end(), {defaultShade, defaultShade, defaultShade});
+      }
+    } else if (lineEnd - cursor > 2 && cursor[0] == 'f' && cursor[1] == ' ') {
+      cursor += 2;
+      face.clear();
+      for (
+        cursor = skipSpace(cursor, lineEnd);
+        cursor < lineEnd;
+        cursor = skipSpace(cursor, lineEnd)
+      ) {
+        face.push_back(parseIndex(cursor, positions.size()/3));
+        // Skip the texture coordinate and normal indices.
+        while (cursor < lineEnd && *cursor != ' ' && *cursor != '\t') {
+          cursor++;
+        }
+      }
+      for (std::size_t corner{2}; corner < face.size(); corner++) {
+        indices.insert(
+          indices.end(), {face[0], face[corner - 1], face[corner]}
+        );
+      }
+    }
+    cursor = lineEnd + 1;
+  }
+  if (indices.empty()) {
+    throw std::runtime_error{"No faces in " + std::string{filePath}};
+  }
+  return {std::move(positions), std::move(colors), std::move(indices)};
+}
+
+auto parseIndex(const char*& cursor, std::size_t vertexCount) -> GLuint {
+  char* next{};
+  const long index{std::strtol(cursor, &next, 10)};
+  if (next == cursor) {
+    throw std::runtime_error{"Malformed face"};
+  }
+  cursor = next;
+  // One-based, or counting back from the last vertex if negative.
+  const long vertex{index < 0 ? static_cast<long>(vertexCount) + index
+    : index - 1};
+  if (vertex < 0 || vertex >= static_cast<long>(vertexCount)) {
+    throw std::runtime_error{"Face refers to a missing vertex"};
+  }
+  return static_cast<GLuint>(vertex);
+}
+
+auto skipSpace(const char* cursor, const char* end) -> const char* {
+  while (
+    cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')
+  ) {
+    cursor++;
+  }
+  return cursor;
+}
+
+} // namespace
@@ -5,16 +5,4 @@
 #define DEBUG
 #endif
 
-#ifdef DEBUG
-#define QUOTE(x) #x
-#define STRING(x) QUOTE(x)
-
-#include <iostream>
-#define LOG(x) do { std::cout << x; } while (false);
-#define LOG_ERROR(x) do { std::cerr << x; } while (false);
-#else
-#define LOG(x)
-#define LOG_ERROR(x)
-#endif
-
 #endif // DEBUG_HXX
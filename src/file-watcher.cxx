@@ -0,0 +1,85 @@
+#include "file-watcher.hxx"
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+
+#include "logger.hxx"
+
+/*
+ * Definitions.
+ */
+
+#ifdef __linux__
+
+my::FileWatcher::FileWatcher(std::string directory)
+: _directory{std::move(directory)},
+  _descriptor{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)} {
+  if (_descriptor < 0) {
+    LOG_ERROR("Failed to start watching files");
+    return;
+  }
+  // Editors either write files in place or write a new file and move it
+  // over the old one.
+  if (
+    inotify_add_watch(
+      _descriptor, _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO
+    ) < 0
+  ) {
+    LOG_ERROR("Failed to watch directory: {}", _directory);
+    close(_descriptor);
+    _descriptor = -1;
+  }
+}
+
+my::FileWatcher::~FileWatcher() {
+  if (_descriptor >= 0) {
+    close(_descriptor);
+  }
+}
+
+auto my::FileWatcher::poll() -> std::vector<std::string> {
+  std::vector<std::string> paths{};
+  if (_descriptor < 0) {
+    return paths;
+  }
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    const ssize_t length{read(_descriptor, buffer, sizeof(buffer))};
+    if (length <= 0) {
+      break;
+    }
+    std::size_t offset{};
+    while (offset < static_cast<std::size_t>(length)) {
+      inotify_event event{};
+      std::memcpy(&event, buffer + offset, sizeof(event));
+      if (event.len > 0) {
+        paths.push_back(
+          _directory + '/' + (buffer + offset + sizeof(inotify_event))
+        );
+      }
+      offset += sizeof(inotify_event) + event.len;
+    }
+  }
+  return paths;
+}
+
+#else
+
+my::FileWatcher::FileWatcher(std::string directory)
+: _directory{std::move(directory)} {
+  LOG_WARNING("Watching files is only supported on Linux");
+}
+
+my::FileWatcher::~FileWatcher() {}
+
+auto my::FileWatcher::poll() -> std::vector<std::string> {
+  return {};
+}
+
+#endif // __linux__
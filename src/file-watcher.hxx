@@ -0,0 +1,37 @@
+#ifndef FILE_WATCHER_HXX
+#define FILE_WATCHER_HXX
+
+#include <string>
+#include <vector>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Files written in one directory, through inotify. Only Linux has it; a
+// watcher anywhere else, or on a directory that can't be watched, never
+// reports anything.
+class FileWatcher {
+public:
+  FileWatcher(std::string directory);
+  FileWatcher() = delete;
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher(FileWatcher&&) = delete;
+  auto operator=(const FileWatcher&) -> FileWatcher& = delete;
+  auto operator=(FileWatcher&&) -> FileWatcher& = delete;
+  ~FileWatcher() noexcept;
+
+  // Paths (the directory, a slash and the name) of files written or
+  // moved into the directory since the last poll; never waits.
+  auto poll() -> std::vector<std::string>;
+
+private:
+  std::string _directory;
+  int _descriptor{-1};
+};
+
+} // namespace my
+
+#endif // FILE_WATCHER_HXX
@@ -0,0 +1,103 @@
+#include "frame-timer.hxx"
+
+#include <algorithm>
+#include <iomanip>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto percentile(std::vector<double> samples, double fraction) -> double;
+auto reportPercentiles(
+  std::ostream& out, const char* label, const std::vector<double>& samples
+) -> void;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::FrameTimer::FrameTimer(std::size_t frameCount) {
+  glGenQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+  _cpuMilliseconds.reserve(frameCount);
+  _gpuMilliseconds.reserve(frameCount);
+}
+
+my::FrameTimer::~FrameTimer() {
+  glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+}
+
+auto my::FrameTimer::beginFrame() -> void {
+  // Reusing a query object means waiting for its result, which is only
+  // still pending if the GPU is more than _queryCount frames behind.
+  if (_frameIndex >= _queryCount) {
+    collect(_frameIndex - _queryCount);
+  }
+  glBeginQuery(GL_TIME_ELAPSED, _queries[_frameIndex % _queryCount]);
+  _frameStart = std::chrono::steady_clock::now();
+}
+
+auto my::FrameTimer::endFrame() -> void {
+  const auto frameEnd{std::chrono::steady_clock::now()};
+  glEndQuery(GL_TIME_ELAPSED);
+  const std::chrono::duration<double, std::milli> elapsed{
+    frameEnd - _frameStart
+  };
+  _cpuMilliseconds.push_back(elapsed.count());
+  _frameIndex++;
+}
+
+auto my::FrameTimer::finish() -> void {
+  const std::size_t first{
+    _frameIndex > _queryCount ? _frameIndex - _queryCount : 0
+  };
+  for (std::size_t frameIndex{first}; frameIndex < _frameIndex; frameIndex++) {
+    collect(frameIndex);
+  }
+}
+
+auto my::FrameTimer::report(std::ostream& out) const -> void {
+  out << "Frames: " << _cpuMilliseconds.size() << '\n';
+  reportPercentiles(out, "CPU", _cpuMilliseconds);
+  reportPercentiles(out, "GPU", _gpuMilliseconds);
+}
+
+auto my::FrameTimer::collect(std::size_t frameIndex) -> void {
+  if (frameIndex < _collectedIndex) {
+    return;
+  }
+  GLuint64 nanoseconds{};
+  glGetQueryObjectui64v(
+    _queries[frameIndex % _queryCount], GL_QUERY_RESULT, &nanoseconds
+  );
+  _gpuMilliseconds.push_back(static_cast<double>(nanoseconds) / 1e6);
+  _collectedIndex = frameIndex + 1;
+}
+
+namespace {
+
+auto percentile(std::vector<double> samples, double fraction) -> double {
+  if (samples.empty()) {
+    return 0.;
+  }
+  const auto rank{static_cast<std::size_t>(
+    fraction*static_cast<double>(samples.size() - 1)
+  )};
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+auto reportPercentiles(
+  std::ostream& out, const char* label, const std::vector<double>& samples
+) -> void {
+  out << label << " frame time (ms): " << std::fixed << std::setprecision(3);
+  out << "p50=" << percentile(samples, .50);
+  out << " p95=" << percentile(samples, .95);
+  out << " p99=" << percentile(samples, .99) << '\n';
+  out << std::defaultfloat << std::setprecision(6);
+}
+
+} // namespace
@@ -0,0 +1,50 @@
+#ifndef FRAME_TIMER_HXX
+#define FRAME_TIMER_HXX
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include <glad/gl.h>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Records CPU and GPU time per frame for the benchmark mode. GPU times
+// come from GL_TIME_ELAPSED queries that are read back a few frames
+// late, so measuring doesn't stall the pipeline.
+class FrameTimer {
+public:
+  FrameTimer(std::size_t frameCount);
+  FrameTimer() = delete;
+  FrameTimer(const FrameTimer&) = delete;
+  FrameTimer(FrameTimer&&) = delete;
+  auto operator=(const FrameTimer&) -> FrameTimer& = delete;
+  auto operator=(FrameTimer&&) -> FrameTimer& = delete;
+  ~FrameTimer() noexcept;
+
+  auto beginFrame() -> void;
+  auto endFrame() -> void;
+  auto finish() -> void;
+  auto report(std::ostream& out) const -> void;
+
+private:
+  static constexpr std::size_t _queryCount{4};
+  std::array<GLuint, _queryCount> _queries{};
+  std::size_t _frameIndex{};
+  std::size_t _collectedIndex{};
+  std::chrono::steady_clock::time_point _frameStart{};
+  std::vector<double> _cpuMilliseconds{};
+  std::vector<double> _gpuMilliseconds{};
+
+  auto collect(std::size_t frameIndex) -> void;
+};
+
+} // namespace my
+
+#endif // FRAME_TIMER_HXX
@@ -0,0 +1,98 @@
+#include "frustum.hxx"
+
+#include <cmath>
+#include <limits>
+
+#include "simd.hxx"
+
+/*
+ * Definitions.
+ */
+
+my::Frustum::Frustum(const glm::mat4& viewProjection) {
+  // Gribb and Hartmann: each plane is the last row of the matrix plus or
+  // minus one of the others. GLM indexes [column][row].
+  const auto row{[&](int index) {
+    return glm::vec4{
+      viewProjection[0][index], viewProjection[1][index],
+      viewProjection[2][index], viewProjection[3][index]
+    };
+  }};
+  const std::array<glm::vec4, 6> planes{
+    row(3) + row(0), row(3) - row(0),
+    row(3) + row(1), row(3) - row(1),
+    row(3) + row(2), row(3) - row(2)
+  };
+  for (std::size_t i{}; i < _planeCount; i++) {
+    if (i >= planes.size()) {
+      _w[i] = std::numeric_limits<float>::max();
+      continue;
+    }
+    // Normalized so the sphere test can compare distances to the radius.
+    const glm::vec4& plane{planes[i]};
+    const float length{
+      std::sqrt(plane.x*plane.x + plane.y*plane.y + plane.z*plane.z)
+    };
+    _x[i] = plane.x/length;
+    _y[i] = plane.y/length;
+    _z[i] = plane.z/length;
+    _w[i] = plane.w/length;
+  }
+}
+
+auto my::Frustum::test(const BoundingBox& box) const -> Containment {
+  // A box is outside a plane if even its corner furthest along the normal
+  // is behind it, and inside if its nearest corner is in front.
+#ifdef USE_SSE
+  const __m128 centerX{_mm_set1_ps(box.center.x)};
+  const __m128 centerY{_mm_set1_ps(box.center.y)};
+  const __m128 centerZ{_mm_set1_ps(box.center.z)};
+  const __m128 extentX{_mm_set1_ps(box.extent.x)};
+  const __m128 extentY{_mm_set1_ps(box.extent.y)};
+  const __m128 extentZ{_mm_set1_ps(box.extent.z)};
+  const __m128 signMask{_mm_set1_ps(-0.f)};
+  const __m128 zero{_mm_setzero_ps()};
+  int outside{};
+  int intersecting{};
+  for (std::size_t i{}; i < _planeCount; i += 4) {
+    const __m128 x{_mm_load_ps(&_x[i])};
+    const __m128 y{_mm_load_ps(&_y[i])};
+    const __m128 z{_mm_load_ps(&_z[i])};
+    const __m128 distance{_mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, centerX), _mm_mul_ps(y, centerY)),
+      _mm_add_ps(_mm_mul_ps(z, centerZ), _mm_load_ps(&_w[i]))
+    )};
+    const __m128 radius{_mm_add_ps(
+      _mm_add_ps(
+        _mm_mul_ps(_mm_andnot_ps(signMask, x), extentX),
+        _mm_mul_ps(_mm_andnot_ps(signMask, y), extentY)
+      ),
+      _mm_mul_ps(_mm_andnot_ps(signMask, z), extentZ)
+    )};
+    outside |= _mm_movemask_ps(
+      _mm_cmplt_ps(_mm_add_ps(distance, radius), zero)
+    );
+    intersecting |= _mm_movemask_ps(
+      _mm_cmplt_ps(_mm_sub_ps(distance, radius), zero)
+    );
+  }
+#else
+  bool outside{};
+  bool intersecting{};
+  for (std::size_t i{}; i < _planeCount; i++) {
+    const float distance{
+      _x[i]*box.center.x + _y[i]*box.center.y + _z[i]*box.center.z + _w[i]
+    };
+    const float radius{
+      std::abs(_x[i])*box.extent.x + std::abs(_y[i])*box.extent.y
+      + std::abs(_z[i])*box.extent.z
+    };
+    outside |= distance + radius < 0.f;
+    intersecting |= distance - radius < 0.f;
+  }
+#endif // USE_SSE
+  if (outside) {
+    return Containment::Outside;
+  }
+  return intersecting ? Containment::Intersecting : Containment::Inside;
+}
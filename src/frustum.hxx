@@ -0,0 +1,43 @@
+#ifndef FRUSTUM_HXX
+#define FRUSTUM_HXX
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "bounds.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+enum class Containment {
+  Outside,
+  Intersecting,
+  Inside,
+};
+
+// The six clip planes of a view-projection matrix, stored one component
+// per array so four planes can be tested at once. The arrays are padded
+// to eight with planes everything is inside of.
+class Frustum {
+public:
+  Frustum(const glm::mat4& viewProjection);
+  Frustum() = delete;
+
+  auto test(const BoundingBox& box) const -> Containment;
+
+private:
+  static constexpr std::size_t _planeCount{8};
+
+  alignas(16) std::array<float, _planeCount> _x{};
+  alignas(16) std::array<float, _planeCount> _y{};
+  alignas(16) std::array<float, _planeCount> _z{};
+  alignas(16) std::array<float, _planeCount> _w{};
+};
+
+} // namespace my
+
+#endif // FRUSTUM_HXX
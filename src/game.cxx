@@ -1,19 +1,134 @@
 #include "game.hxx"
 
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "profiler.hxx"
+#include "timestep.hxx"
+
 /*
  * Definitions.
  */
 
-my::Game::Game() {
+auto my::ObjectState::getModelMatrix(float alpha) const -> glm::mat4 {
+  return previousModelMatrix + (modelMatrix - previousModelMatrix)*alpha;
+}
+
+auto my::GameState::getAlpha(
+  std::chrono::steady_clock::time_point now
+) const -> float {
+  const std::chrono::duration<float> elapsed{now - tickTime};
+  return std::clamp(elapsed.count() / tickStep, 0.f, 1.f);
+}
+
+auto my::GameState::getViewMatrix(float alpha) const -> glm::mat4 {
+  // The camera only translates, so blending the matrices component-wise
+  // is the same as blending the positions.
+  return previousViewMatrix + (viewMatrix - previousViewMatrix)*alpha;
+}
+
+auto my::GameState::getCameraPosition(float alpha) const -> glm::vec3 {
+  // The view matrix is a pure translation by the negated position.
+  const glm::mat4 view{getViewMatrix(alpha)};
+  return {-view[3].x, -view[3].y, -view[3].z};
+}
+
+my::Game::Game(std::size_t objectCount, std::size_t mesh, float flySpeed) {
   _camera.setPosition(2., 2., 2.);
+  _camera.moveZ(-flySpeed);
+  // Lay extra objects out in a square grid on the ground in front of
+  // the camera; a single object stays at the origin.
+  const auto side{static_cast<std::size_t>(
+    std::ceil(std::sqrt(static_cast<double>(objectCount)))
+  )};
+  const float spacing{2.5f};
+  _objects.reserve(objectCount);
+  for (std::size_t i{}; i < objectCount; i++) {
+    ObjectState object{};
+    object.mesh = mesh;
+    if (objectCount > 1) {
+      const glm::vec3 position{
+        (static_cast<float>(i % side) - static_cast<float>(side)/2.f)*spacing,
+        0.f,
+        -static_cast<float>(i / side)*spacing
+      };
+      object.modelMatrix = glm::translate(glm::mat4{1.}, position);
+      object.previousModelMatrix = object.modelMatrix;
+    }
+    _objects.push_back(object);
+  }
+  publishState(1.);
 }
 
-auto my::Game::getCamera() const -> const Camera& {
-  return _camera;
+my::Game::~Game() {
+  stop();
 }
 
-auto my::Game::getCamera() -> Camera& {
-  return _camera;
+auto my::Game::start(double ticksPerSecond) -> void {
+  if (_running.exchange(true)) {
+    return;
+  }
+  _thread = std::thread{&Game::run, this, ticksPerSecond};
 }
 
-auto my::Game::tick() -> void {}
+auto my::Game::stop() -> void {
+  _running = false;
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+auto my::Game::setAspectRatio(int width, int height) -> void {
+  _pendingViewport = static_cast<std::uint64_t>(width) << 32
+    | static_cast<std::uint32_t>(height);
+}
+
+auto my::Game::getState() -> const GameState& {
+  _states.update();
+  return _states.getReadBuffer();
+}
+
+auto my::Game::tick(float dt) -> void {
+  const std::uint64_t viewport{_pendingViewport.exchange(0)};
+  if (viewport) {
+    _camera.setAspectRatio(
+      static_cast<int>(viewport >> 32),
+      static_cast<int>(viewport & 0xffffffff)
+    );
+  }
+  for (auto& object : _objects) {
+    object.previousModelMatrix = object.modelMatrix;
+  }
+  _camera.update(dt);
+}
+
+auto my::Game::run(double ticksPerSecond) -> void {
+  Profiler::nameThread("Simulation");
+  FixedTimestep timestep{ticksPerSecond};
+  while (_running) {
+    const int ticks{timestep.advance()};
+    for (int tickIndex{}; tickIndex < ticks; tickIndex++) {
+      PROFILE_SCOPE("Tick");
+      tick(timestep.getStep());
+    }
+    if (ticks > 0) {
+      publishState(timestep.getStep());
+    }
+    std::this_thread::sleep_for(timestep.getTimeToNextTick());
+  }
+}
+
+auto my::Game::publishState(float dt) -> void {
+  GameState& state{_states.getWriteBuffer()};
+  state.projectionMatrix = _camera.getProjectionMatrix();
+  state.previousViewMatrix = _camera.getPreviousViewMatrix();
+  state.viewMatrix = _camera.getViewMatrix();
+  // Assigning into the recycled slot reuses its allocation once the
+  // object count has settled.
+  state.objects.assign(_objects.begin(), _objects.end());
+  state.tickTime = std::chrono::steady_clock::now();
+  state.tickStep = dt;
+  _states.publish();
+}
@@ -1,9 +1,18 @@
 #ifndef GAME_HXX
 #define GAME_HXX
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
 #include <glm/trigonometric.hpp>
 
 #include "camera.hxx"
+#include "triple-buffer.hxx"
 
 /*
  * Declarations.
@@ -11,20 +20,61 @@
 
 namespace my {
 
+struct ObjectState {
+  // Index of the mesh in the graphics engine.
+  std::size_t mesh{};
+  glm::mat4 previousModelMatrix{1.};
+  glm::mat4 modelMatrix{1.};
+
+  auto getModelMatrix(float alpha) const -> glm::mat4;
+};
+
+// Immutable copy of everything the renderer needs from one simulation
+// tick, along with the state before that tick for interpolation.
+struct GameState {
+  glm::mat4 projectionMatrix{1.};
+  glm::mat4 previousViewMatrix{1.};
+  glm::mat4 viewMatrix{1.};
+  std::vector<ObjectState> objects{};
+  std::chrono::steady_clock::time_point tickTime{};
+  float tickStep{1.};
+
+  auto getAlpha(std::chrono::steady_clock::time_point now) const -> float;
+  auto getViewMatrix(float alpha) const -> glm::mat4;
+  auto getCameraPosition(float alpha) const -> glm::vec3;
+};
+
 class Game {
 public:
-  Game();
+  // Objects are copies of the given mesh. The camera flies forward (-z)
+  // at flySpeed world units per second.
+  Game(
+    std::size_t objectCount = 1, std::size_t mesh = 0, float flySpeed = 0.f
+  );
   Game(const Game&) = delete;
   Game(Game&&) = delete;
   Game& operator=(const Game&) = delete;
   Game& operator=(Game&&) = delete;
+  ~Game() noexcept;
 
-  auto getCamera() const -> const Camera&;
-  auto getCamera() -> Camera&;
-  auto tick() -> void;
+  auto start(double ticksPerSecond) -> void;
+  auto stop() -> void;
+  auto setAspectRatio(int width, int height) -> void;
+  auto getState() -> const GameState&;
+  auto tick(float dt) -> void;
 
 private:
   Camera _camera{glm::radians(90.f), 1.f, 0.1f, 100.f};
+  std::vector<ObjectState> _objects{};
+  TripleBuffer<GameState> _states{};
+  // Width and height packed into one word so the render thread can hand
+  // over a resize without locking; zero means no pending resize.
+  std::atomic<std::uint64_t> _pendingViewport{};
+  std::atomic<bool> _running{false};
+  std::thread _thread{};
+
+  auto run(double ticksPerSecond) -> void;
+  auto publishState(float dt) -> void;
 };
 
 } // namespace my
@@ -0,0 +1,80 @@
+#include "gpu-profiler.hxx"
+
+/*
+ * Definitions.
+ */
+
+my::GpuProfiler::GpuProfiler() : _track{Profiler::addTrack("GPU")} {
+  for (auto& frame : _frames) {
+    glGenQueries(
+      static_cast<GLsizei>(frame.queries.size()), frame.queries.data()
+    );
+  }
+}
+
+my::GpuProfiler::~GpuProfiler() {
+  for (auto& frame : _frames) {
+    glDeleteQueries(
+      static_cast<GLsizei>(frame.queries.size()), frame.queries.data()
+    );
+  }
+}
+
+auto my::GpuProfiler::beginFrame() -> void {
+  _frameIndex = (_frameIndex + 1) % _frameCount;
+  Frame& frame{_frames[_frameIndex]};
+  collect(frame);
+  if (!Profiler::isEnabled()) {
+    _calibrated = false;
+    return;
+  }
+  if (!_calibrated) {
+    // Both clocks run at the same rate, so one reading of each, taken
+    // whenever profiling starts, lines them up well enough.
+    GLint64 gpuTime{};
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    _clockOffset = Profiler::now() - gpuTime;
+    _calibrated = true;
+  }
+}
+
+auto my::GpuProfiler::beginPass(const char* name) -> void {
+  Frame& frame{_frames[_frameIndex]};
+  if (!_calibrated || frame.passCount == _maxPasses) {
+    return;
+  }
+  frame.names[frame.passCount] = name;
+  glQueryCounter(frame.queries[frame.passCount*2], GL_TIMESTAMP);
+}
+
+auto my::GpuProfiler::endPass() -> void {
+  Frame& frame{_frames[_frameIndex]};
+  if (!_calibrated || frame.passCount == _maxPasses) {
+    return;
+  }
+  glQueryCounter(frame.queries[frame.passCount*2 + 1], GL_TIMESTAMP);
+  frame.passCount++;
+}
+
+auto my::GpuProfiler::collect(Frame& frame) -> void {
+  for (std::size_t pass{}; pass < frame.passCount; pass++) {
+    GLuint64 start{};
+    GLuint64 end{};
+    glGetQueryObjectui64v(frame.queries[pass*2], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(frame.queries[pass*2 + 1], GL_QUERY_RESULT, &end);
+    _track.record(
+      frame.names[pass], static_cast<std::int64_t>(start) + _clockOffset,
+      static_cast<std::int64_t>(end) + _clockOffset
+    );
+  }
+  frame.passCount = 0;
+}
+
+my::GpuProfileScope::GpuProfileScope(GpuProfiler& profiler, const char* name)
+: _profiler{profiler} {
+  _profiler.beginPass(name);
+}
+
+my::GpuProfileScope::~GpuProfileScope() {
+  _profiler.endPass();
+}
@@ -0,0 +1,74 @@
+#ifndef GPU_PROFILER_HXX
+#define GPU_PROFILER_HXX
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+#include "profiler.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Times passes of each frame on the GPU, onto a "GPU" profiler track.
+// Results are read back when their queries come round again, a few
+// frames later, so that they are ready and reading them doesn't stall.
+// Passes can't nest. Does nothing while the profiler is disabled.
+class GpuProfiler {
+public:
+  GpuProfiler();
+  GpuProfiler(const GpuProfiler&) = delete;
+  GpuProfiler(GpuProfiler&&) = delete;
+  auto operator=(const GpuProfiler&) -> GpuProfiler& = delete;
+  auto operator=(GpuProfiler&&) -> GpuProfiler& = delete;
+  ~GpuProfiler() noexcept;
+
+  auto beginFrame() -> void;
+  auto beginPass(const char* name) -> void;
+  auto endPass() -> void;
+
+private:
+  static constexpr std::size_t _frameCount{4};
+  static constexpr std::size_t _maxPasses{8};
+  // Timestamps rather than GL_TIME_ELAPSED, which can't be used while
+  // the frame timer's query is active, and which couldn't be placed on
+  // the CPU's timeline anyway.
+  struct Frame {
+    std::array<GLuint, _maxPasses*2> queries{};
+    std::array<const char*, _maxPasses> names{};
+    std::size_t passCount{};
+  };
+
+  std::array<Frame, _frameCount> _frames{};
+  std::size_t _frameIndex{};
+  ProfileTrack& _track;
+  // CPU time minus GPU time, as of the last calibration.
+  std::int64_t _clockOffset{};
+  bool _calibrated{};
+
+  auto collect(Frame& frame) -> void;
+};
+
+// Times the rest of the enclosing block as a GPU pass.
+class GpuProfileScope {
+public:
+  GpuProfileScope(GpuProfiler& profiler, const char* name);
+  GpuProfileScope() = delete;
+  GpuProfileScope(const GpuProfileScope&) = delete;
+  GpuProfileScope(GpuProfileScope&&) = delete;
+  auto operator=(const GpuProfileScope&) -> GpuProfileScope& = delete;
+  auto operator=(GpuProfileScope&&) -> GpuProfileScope& = delete;
+  ~GpuProfileScope() noexcept;
+
+private:
+  GpuProfiler& _profiler;
+};
+
+} // namespace my
+
+#endif // GPU_PROFILER_HXX
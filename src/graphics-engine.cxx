@@ -1,18 +1,30 @@
 #include "graphics-engine.hxx"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
+#include <iterator>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
-#define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "debug.hxx"
+#include "bounds.hxx"
+#include "frustum.hxx"
+#include "graphics-state.hxx"
+#include "index-optimizer.hxx"
 #include "io.hxx"
+#include "logger.hxx"
 #include "models.hxx"
+#include "profiler.hxx"
+#include "simplify.hxx"
+#ifdef USE_STATIC_SHADERS
+#include "static-shaders.hxx"
+#endif // USE_STATIC_SHADERS
+#include "vertex-format.hxx"
 
 /*
  * Declarations.
@@ -26,12 +38,73 @@ auto debugMessageCallbackGL(
   GLsizei length, const GLchar* message, const GLvoid* userParam
 ) -> void;
 #endif // DEBUG
-auto initializeGL() -> bool;
+auto initializeGL(GLADloadfunc loader) -> bool;
+auto getShaderVariant(const my::RenderSettings& settings) -> std::uint32_t;
+// Only the variant asked for gets compiled.
 auto buildProgram(
-  std::string_view vertexPath, std::string_view fragmentPath
+  my::ThreadPool& workers, my::ProgramCache& programCache,
+  std::uint32_t variant
 ) -> my::ShaderProgram;
+#ifndef USE_STATIC_SHADERS
+auto insertDefines(std::string& source, std::uint32_t variant) -> void;
+#endif // USE_STATIC_SHADERS
+auto isIdentity(const glm::mat4& matrix) -> bool;
+auto quantizeDepth(const glm::mat4& viewMatrix, const glm::mat4& modelMatrix)
+-> std::uint32_t;
+auto pointModelAttribute(GLintptr offset) -> void;
+// Optional parts of the shaders, each behind a #define. Bit i of a
+// variant's key turns on shaderFeatures[i]; with USE_STATIC_SHADERS,
+// every variant is embedded, in the order of SHADER_FEATURES in
+// CMakeLists.txt.
+constexpr std::uint32_t instancingFeature{1 << 0};
+constexpr std::uint32_t fogFeature{1 << 1};
+constexpr std::string_view shaderFeatures[]{"USE_INSTANCING", "USE_FOG"};
+#ifdef USE_STATIC_SHADERS
+static_assert(
+  std::size(my::staticShaders::features) == std::size(shaderFeatures)
+  && my::staticShaders::features[0] == shaderFeatures[0]
+  && my::staticShaders::features[1] == shaderFeatures[1],
+  "SHADER_FEATURES in CMakeLists.txt doesn't match shaderFeatures"
+);
+#else
+constexpr const char* shaderDirectory{"res/shaders"};
 constexpr const char* mainVertexPath{"res/shaders/main.vert"};
 constexpr const char* mainFragmentPath{"res/shaders/main.frag"};
+#endif // USE_STATIC_SHADERS
+constexpr GLuint cameraBlockBinding{0};
+constexpr std::size_t initialInstanceCapacity{1024};
+constexpr std::size_t initialArenaVertices{1 << 16};
+constexpr std::size_t initialArenaIndices{1 << 16};
+// Free space split this badly makes the arena compact itself before the
+// next frame.
+constexpr double maxMeshFragmentation{.5};
+// The occlusion buffer is small enough to fill and test in well under a
+// millisecond. Each frame the nearest, largest few visible objects go
+// into it, each as a stand-in of at most maxOccluderTriangles: the mesh
+// itself when it is that small, otherwise its finest level of detail
+// that is, or a further simplified copy of its coarsest level.
+constexpr int occlusionWidth{256};
+constexpr int occlusionHeight{128};
+constexpr std::size_t maxOccluders{32};
+constexpr GLint maxOccluderTriangles{256};
+// Projected radius, as a fraction of half the viewport height, below
+// which level 1 is drawn; each further level takes over at half the
+// size of the one before.
+constexpr float levelOfDetailSize{.5f};
+// How far past a switching size an object has to get before it
+// switches, so that objects near it don't flicker between levels.
+constexpr float levelOfDetailHysteresis{.1f};
+
+// Matches the std140 layout of the Camera block in the shaders; mat4
+// columns are vec4s, so there is no padding.
+struct CameraBlock {
+  glm::mat4 projection{1.};
+  glm::mat4 view{1.};
+  glm::mat4 viewProjection{1.};
+};
+// View distance mapped onto the depth bits of the sort key; anything
+// further away sorts as if it were at this distance.
+constexpr float maxSortDepth{1024.f};
 
 } // namespace
 
@@ -39,55 +112,148 @@ constexpr const char* mainFragmentPath{"res/shaders/main.frag"};
  * Definitions.
  */
 
-my::GraphicsEngine::GraphicsEngine()
-: _glAvailable{initializeGL()},
-  _mainProgram{buildProgram(mainVertexPath, mainFragmentPath)} {
+my::GraphicsEngine::GraphicsEngine(
+  GLADloadfunc loader, const RenderSettings& settings, ThreadPool& workers
+)
+: _glAvailable{initializeGL(loader)}, _settings{settings}, _workers{workers},
+  _programCache{settings.programCache},
+  _mainProgram{
+    buildProgram(workers, _programCache, getShaderVariant(settings))
+  },
+  _cameraBlock{cameraBlockBinding, sizeof(CameraBlock)},
+  _meshArena{sizeof(PackedVertex), initialArenaVertices, initialArenaIndices} {
   if (!_glAvailable) {
     throw std::runtime_error{"Failed to initialize OpenGL"};
   }
+  glEnable(GL_DEPTH_TEST);
 
-  BasicTriangle triangle{};
-  Geometry& geometry{triangle};
-  Buffer positionBuffer{
-    BufferTarget::Array, geometry.getVertices(),
-    static_cast<GLsizei>(geometry.getVertexMemorySize())
-  };
-  Buffer colorBuffer{
-    BufferTarget::Array, geometry.getColors(),
-    static_cast<GLsizei>(geometry.getColorMemorySize())
-  };
-  Buffer indexBuffer{
-    BufferTarget::ElementArray, geometry.getIndices(),
-    static_cast<GLsizei>(geometry.getIndexMemorySize())
-  };
-  ShaderAttribute positionAttribute{
-    "position", positionBuffer, geometry.getVertexCount(),
-    AttributeType::Float, false, 0, nullptr
-  };
-  ShaderAttribute colorAttribute{
-    "color", colorBuffer, geometry.getColorCount(),
-    AttributeType::Float, false, 0, nullptr
-  };
-  VertexArrayBuilder& vaoBuilder{_mainProgram.getVertexArrayBuilder()};
-  vaoBuilder.setIndexCount(geometry.getIndexCount());
-  vaoBuilder << &indexBuffer;
-  vaoBuilder << &positionAttribute << &colorAttribute;
-  VertexArray vao{vaoBuilder.build()};
-  std::vector<VertexArray>& vertexArrays{_mainProgram.getVertexArrays()};
-  vertexArrays.reserve(1);
-  vertexArrays.push_back(std::move(vao));
-  std::vector<Uniform>& uniforms{_mainProgram.getUniforms()};
-  uniforms.reserve(3);
-  uniforms.push_back({_mainProgram, "projection"});
-  uniforms.push_back({_mainProgram, "view"});
-  uniforms.push_back({_mainProgram, "model"});
-  _buffers.push_back(std::move(positionBuffer));
-  _buffers.push_back(std::move(colorBuffer));
-  _buffers.push_back(std::move(indexBuffer));
+  if (_settings.instancing) {
+    _instanceStream.emplace(
+      BufferTarget::Array,
+      static_cast<GLsizeiptr>(initialInstanceCapacity*sizeof(InstanceData))
+    );
+  }
+  if (_settings.occlusion) {
+    _occlusionBuffer.emplace(occlusionWidth, occlusionHeight);
+  }
+  addMesh(BasicTriangle{});
+  buildVertexArray();
+  prepareProgram(_mainProgram);
+  if (_settings.shaderHotReload) {
+#ifdef USE_STATIC_SHADERS
+    LOG_WARNING("Shader hot reload needs shaders loaded from files");
+#else
+    _shaderWatcher.emplace(shaderDirectory);
+#endif // USE_STATIC_SHADERS
+  }
+}
+
+auto my::GraphicsEngine::addMesh(
+  const Geometry& geometry, const std::vector<MeshGeometry>& levels,
+  const Geometry* occluder
+) -> std::uint32_t {
+  // Placed the way mesh files are, so that meshes far from the origin
+  // keep their precision as half floats; everything kept below is in the
+  // placed mesh's space.
+  const MeshPlacement placement{computePlacement(geometry)};
+  const MeshGeometry placed{placeGeometry(geometry, placement)};
+  std::vector<MeshGeometry> placedLevels{};
+  placedLevels.reserve(levels.size());
+  for (const auto& level : levels) {
+    placedLevels.push_back(placeGeometry(level, placement));
+  }
+  const std::uint32_t mesh{uploadMesh(placed)};
+  trackMesh(mesh, computeBounds(placed), placement.getTransform());
+  for (const auto& level : placedLevels) {
+    _meshLevels[mesh].push_back(uploadMesh(level));
+  }
+  // Without a given occluder, the finest version within the budget.
+  // Meshes with levels of detail are known to simplify, and their
+  // coarsest level is small enough to simplify again right here; the
+  // rest, voxel chunks among them, have to be given an occluder if they
+  // are any bigger.
+  const Geometry* source{&placed};
+  std::optional<MeshGeometry> standIn{};
+  if (occluder) {
+    standIn = placeGeometry(*occluder, placement);
+    source = &*standIn;
+  } else {
+    for (const auto& level : placedLevels) {
+      if (source->getIndexCount() <= maxOccluderTriangles*3) {
+        break;
+      }
+      source = &level;
+    }
+    if (
+      source->getIndexCount() > maxOccluderTriangles*3
+      && !placedLevels.empty()
+    ) {
+      standIn = simplify(*source, maxOccluderTriangles);
+      source = &*standIn;
+    }
+  }
+  if (source->getIndexCount() <= maxOccluderTriangles*3) {
+    OccluderMesh& occluderMesh{_occluderMeshes[mesh]};
+    const GLfloat* positions{source->getVertices()};
+    for (GLint vertex{}; vertex < source->getVertexCount(); vertex++) {
+      occluderMesh.positions.push_back({
+        positions[vertex*3], positions[vertex*3 + 1], positions[vertex*3 + 2]
+      });
+    }
+    occluderMesh.indices.assign(
+      source->getIndices(), source->getIndices() + source->getIndexCount()
+    );
+  }
+  return mesh;
+}
+
+auto my::GraphicsEngine::addMesh(const MeshFile& file) -> std::uint32_t {
+  const auto upload{[this](const MeshFileLevel& level) {
+    return _meshArena.add(
+      level.vertices, level.vertexCount, level.indices, level.indexType,
+      level.indexCount
+    );
+  }};
+  const std::uint32_t mesh{upload(file.getLevel(0))};
+  trackMesh(mesh, file.getBounds(), file.getTransform());
+  for (std::size_t level{1}; level < file.getLevelCount(); level++) {
+    _meshLevels[mesh].push_back(upload(file.getLevel(level)));
+  }
+  // The finest level within the budget, unpacked again.
+  for (std::size_t i{}; i < file.getLevelCount(); i++) {
+    const MeshFileLevel& level{file.getLevel(i)};
+    if (level.indexCount > static_cast<std::size_t>(maxOccluderTriangles)*3) {
+      continue;
+    }
+    OccluderMesh& occluder{_occluderMeshes[mesh]};
+    const auto vertices{static_cast<const PackedVertex*>(level.vertices)};
+    for (std::size_t vertex{}; vertex < level.vertexCount; vertex++) {
+      const std::array<GLhalf, 4>& position{vertices[vertex].position};
+      occluder.positions.push_back({
+        unpackHalf(position[0]), unpackHalf(position[1]),
+        unpackHalf(position[2])
+      });
+    }
+    if (level.indexType == IndexType::UnsignedShort) {
+      const auto indices{static_cast<const GLushort*>(level.indices)};
+      occluder.indices.assign(indices, indices + level.indexCount);
+    } else {
+      const auto indices{static_cast<const GLuint*>(level.indices)};
+      occluder.indices.assign(indices, indices + level.indexCount);
+    }
+    break;
+  }
+  return mesh;
 }
 
-auto my::GraphicsEngine::setCamera(const Camera* camera) -> void {
-  _camera = camera;
+auto my::GraphicsEngine::removeMesh(std::uint32_t mesh) -> void {
+  _meshArena.remove(mesh);
+  for (const auto level : _meshLevels.at(mesh)) {
+    _meshArena.remove(level);
+  }
+  _meshLevels[mesh].clear();
+  _occluderMeshes.at(mesh) = {};
+  _meshesChanged = true;
 }
 
 auto my::GraphicsEngine::resize(int width, int height) -> void {
@@ -95,30 +261,508 @@ auto my::GraphicsEngine::resize(int width, int height) -> void {
   _windowHeight = height;
 }
 
-auto my::GraphicsEngine::render() const -> void {
-  if (!_camera) {
-    return;
+auto my::GraphicsEngine::render(
+  const GameState& state, float alpha,
+  const std::vector<ObjectState>& staticObjects
+) -> void {
+  PROFILE_SCOPE("Render");
+  const auto submitStart{std::chrono::steady_clock::now()};
+  StateCache& cache{StateCache::current()};
+  cache.resetCounters();
+  _gpuProfiler.beginFrame();
+  _stats = {};
+  _stats.objects = state.objects.size() + staticObjects.size();
+  _stats.programs = _programCache.getStats();
+  reloadShaders();
+  maintainMeshes();
+  {
+    const GpuProfileScope clearPass{_gpuProfiler, "Clear"};
+    resetFrame();
   }
-  resetFrame();
   _mainProgram.use();
-  const Uniform& projectionUniform{_mainProgram.getUniforms().at(0)};
-  const Uniform& viewUniform{_mainProgram.getUniforms().at(1)};
-  const Uniform& modelUniform{_mainProgram.getUniforms().at(2)};
-  projectionUniform.setData(_camera->getProjectionMatrix());
-  viewUniform.setData(_camera->getViewMatrix());
-  glm::mat4 modelMatrix{1.};
-  for (const auto& vao : _mainProgram.getVertexArrays()) {
-    vao.bind();
-    modelUniform.setData(modelMatrix);
-    vao.drawTriangles();
-    vao.unbind();
+  CameraBlock camera{};
+  camera.projection = state.projectionMatrix;
+  camera.view = state.getViewMatrix(alpha);
+  camera.viewProjection = camera.projection*camera.view;
+  if (_cameraBlock.setData(camera)) {
+    _stats.uniformBlockUploads++;
+  }
+  cullObjects(state, staticObjects, alpha, camera.viewProjection);
+  if (_occlusionBuffer) {
+    occludeObjects(camera.viewProjection);
+  }
+  // Both viewport axes scale with this, the cotangent of half the field
+  // of view.
+  queueObjects(camera.view, camera.projection[1][1]);
+  {
+    const GpuProfileScope drawPass{_gpuProfiler, "Draw"};
+    if (_settings.instancing) {
+      renderInstanced();
+    } else {
+      renderPerObject();
+    }
   }
+  const std::chrono::duration<double, std::milli> submitTime{
+    std::chrono::steady_clock::now() - submitStart
+  };
+  _stats.submitMilliseconds = submitTime.count();
+  _stats.stateChanges = cache.getCounters();
+}
+
+auto my::GraphicsEngine::getStats() const -> const RenderStats& {
+  return _stats;
+}
+
+auto my::GraphicsEngine::uploadMesh(const Geometry& geometry)
+-> std::uint32_t {
+  const PackedMesh packed{packMesh(geometry)};
+  const auto indexCount{static_cast<std::size_t>(geometry.getIndexCount())};
+  _vertexCacheStats.triangles += indexCount/3;
+  _vertexCacheStats.transformsBefore += countVertexTransforms(
+    geometry.getIndices(), indexCount, packed.vertices.size()
+  );
+  _vertexCacheStats.transformsAfter += countVertexTransforms(
+    packed.indices.data(), packed.indices.size(), packed.vertices.size()
+  );
+  return _meshArena.add(
+    packed.vertices.data(), packed.vertices.size(), packed.indices.data(),
+    packed.indices.size()
+  );
+}
+
+auto my::GraphicsEngine::trackMesh(
+  std::uint32_t mesh, const MeshBounds& bounds, const glm::mat4& placement
+) -> void {
+  if (mesh >= _meshBounds.size()) {
+    _meshBounds.resize(mesh + 1);
+    _meshPlacements.resize(mesh + 1);
+    _meshLevels.resize(mesh + 1);
+    _occluderMeshes.resize(mesh + 1);
+  }
+  _meshBounds[mesh] = bounds;
+  _meshPlacements[mesh] = placement;
+  _meshLevels[mesh].clear();
+  _occluderMeshes[mesh] = {};
+  _meshesChanged = true;
+}
+
+auto my::GraphicsEngine::prepareProgram(ShaderProgram& program) const
+-> void {
+  program.bindUniformBlock("Camera", _cameraBlock.getBinding());
+  if (!_settings.instancing) {
+    std::vector<Uniform>& uniforms{program.getUniforms()};
+    uniforms.reserve(1);
+    uniforms.push_back({program, "model"});
+  }
+}
+
+auto my::GraphicsEngine::reloadShaders() -> void {
+#ifndef USE_STATIC_SHADERS
+  if (!_shaderWatcher) {
+    return;
+  }
+  for (const auto& path : _shaderWatcher->poll()) {
+    if (path == mainVertexPath || path == mainFragmentPath) {
+      // Starts over, abandoning any build of older sources.
+      _programBuild.reset();
+      _shaderReads = readFilesAsync(
+        _workers, {std::string{mainVertexPath}, std::string{mainFragmentPath}}
+      );
+      break;
+    }
+  }
+  if (!_shaderReads.empty()) {
+    for (const auto& read : _shaderReads) {
+      if (read.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+        return;
+      }
+    }
+    std::optional<std::string> vertexSource{_shaderReads[0].get()};
+    std::optional<std::string> fragmentSource{_shaderReads[1].get()};
+    _shaderReads.clear();
+    if (!vertexSource || !fragmentSource) {
+      LOG_ERROR("Failed to reload shader sources");
+      return;
+    }
+    const std::uint32_t variant{getShaderVariant(_settings)};
+    insertDefines(*vertexSource, variant);
+    insertDefines(*fragmentSource, variant);
+    _programBuild.emplace(*vertexSource, *fragmentSource);
+    return;
+  }
+  if (!_programBuild || !_programBuild->isComplete()) {
+    return;
+  }
+  std::optional<ShaderProgram> program{_programBuild->finish()};
+  _programBuild.reset();
+  if (!program) {
+    LOG_ERROR("Failed to rebuild shaders; keeping the previous program");
+    return;
+  }
+  // Attribute locations are fixed, so the vertex arrays carry over as
+  // they are; uniform locations have to be looked up again.
+  prepareProgram(*program);
+  program->getVertexArrays() = std::move(_mainProgram.getVertexArrays());
+  _mainProgram = std::move(*program);
+  LOG_INFO("Reloaded shaders");
+#endif // USE_STATIC_SHADERS
+}
+
+auto my::GraphicsEngine::buildVertexArray() -> void {
+  // All meshes live in the arena's buffers, so one vertex array draws
+  // any of them and draws of different meshes can be merged into a
+  // single multi-draw.
+  VertexArrayBuilder& vaoBuilder{_mainProgram.getVertexArrayBuilder()};
+  // Only bounds the whole-array draw; the range draws take their counts
+  // from the arena.
+  const MeshArenaStats arenaStats{_meshArena.getStats()};
+  vaoBuilder.setIndexCount(static_cast<GLint>(
+    arenaStats.indexBytesCapacity/sizeof(GLushort)
+  ));
+  vaoBuilder << &_meshArena.getIndexBuffer();
+  vaoBuilder.addVertexBuffer<PackedVertex>(_meshArena.getVertexBuffer());
+  if (_settings.instancing) {
+    vaoBuilder.addVertexBuffer<InstanceData>(
+      _instanceStream->getBuffer(), 1 /*divisor*/
+    );
+  }
+  VertexArray vao{vaoBuilder.build()};
+  std::vector<VertexArray>& vertexArrays{_mainProgram.getVertexArrays()};
+  vertexArrays.clear();
+  vertexArrays.push_back(std::move(vao));
+  _vertexArrayGeneration = _meshArena.getGeneration();
+}
+
+auto my::GraphicsEngine::maintainMeshes() -> void {
+  const MeshArenaStats arenaStats{_meshArena.getStats()};
+  if (
+    std::max(arenaStats.vertexFragmentation, arenaStats.indexFragmentation)
+    > maxMeshFragmentation
+  ) {
+    _meshArena.defragment();
+  }
+  if (_meshArena.getGeneration() != _vertexArrayGeneration) {
+    buildVertexArray();
+  }
+  _stats.meshes = _meshArena.getStats();
+  _stats.vertexCache = _vertexCacheStats;
 }
 
 auto my::GraphicsEngine::resetFrame() const -> void {
-  glViewport(0, 0, _windowWidth, _windowHeight);
-  glClearColor(0., .5, 1., 1.);
-  glClear(GL_COLOR_BUFFER_BIT);
+  // Both only change on resize, so the cache elides them on most frames.
+  StateCache& cache{StateCache::current()};
+  cache.viewport(0, 0, _windowWidth, _windowHeight);
+  cache.clearColor(0., .5, 1., 1.);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+auto my::GraphicsEngine::cullObjects(
+  const GameState& state, const std::vector<ObjectState>& staticObjects,
+  float alpha, const glm::mat4& viewProjection
+) -> void {
+  PROFILE_SCOPE("Cull");
+  const auto cullStart{std::chrono::steady_clock::now()};
+  // Only objects that moved or changed mesh since the last frame get new
+  // bounds; the hierarchy is rebuilt when objects or meshes come or go.
+  // Static objects are numbered after the state's.
+  const std::size_t dynamicCount{state.objects.size()};
+  const std::size_t count{dynamicCount + staticObjects.size()};
+  const bool rebuild{_meshesChanged || count != _bvh.getObjectCount()};
+  _meshesChanged = false;
+  _modelMatrices.resize(count);
+  _objectMeshes.resize(count);
+  _objectBoxes.resize(count);
+  // Levels are kept by slot, so they only carry over while each slot
+  // still holds the same object as far as can be told: a new count
+  // shifts the static objects, and a new mesh is a new object.
+  if (count != _objectLevels.size()) {
+    _objectLevels.assign(count, 0);
+  }
+  for (std::size_t i{}; i < count; i++) {
+    const ObjectState& object{
+      i < dynamicCount ? state.objects[i] : staticObjects[i - dynamicCount]
+    };
+    const glm::mat4 modelMatrix{
+      object.getModelMatrix(alpha)*_meshPlacements.at(object.mesh)
+    };
+    if (
+      !rebuild && modelMatrix == _modelMatrices[i]
+      && object.mesh == _objectMeshes[i]
+    ) {
+      continue;
+    }
+    if (object.mesh != _objectMeshes[i]) {
+      _objectLevels[i] = 0;
+    }
+    _modelMatrices[i] = modelMatrix;
+    _objectMeshes[i] = object.mesh;
+    _objectBoxes[i] = _meshBounds.at(object.mesh).box.transform(modelMatrix);
+    if (!rebuild) {
+      _bvh.update(static_cast<std::uint32_t>(i), _objectBoxes[i]);
+    }
+  }
+  if (rebuild) {
+    _bvh.build(_objectBoxes);
+  } else {
+    _bvh.refit();
+  }
+  _visibleObjects.clear();
+  _bvh.cull(Frustum{viewProjection}, _visibleObjects);
+  _stats.visibleObjects = _visibleObjects.size();
+  _stats.culledObjects = count - _visibleObjects.size();
+  const std::chrono::duration<double, std::milli> cullTime{
+    std::chrono::steady_clock::now() - cullStart
+  };
+  _stats.cullMilliseconds = cullTime.count();
+}
+
+auto my::GraphicsEngine::occludeObjects(const glm::mat4& viewProjection)
+-> void {
+  PROFILE_SCOPE("Occlusion");
+  const auto occlusionStart{std::chrono::steady_clock::now()};
+  // Rank the visible objects by the size of their bounds over their
+  // distance, a cheap stand-in for projected area.
+  _occluders.clear();
+  for (const auto i : _visibleObjects) {
+    if (_occluderMeshes[_objectMeshes[i]].indices.empty()) {
+      continue;
+    }
+    const BoundingBox& box{_objectBoxes[i]};
+    const float w{(viewProjection*glm::vec4{box.center, 1.f}).w};
+    if (w <= 0.f) {
+      continue;
+    }
+    _occluders.push_back({glm::length(box.extent)/w, i});
+  }
+  if (_occluders.size() > maxOccluders) {
+    std::nth_element(
+      _occluders.begin(), _occluders.begin() + maxOccluders, _occluders.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; }
+    );
+    _occluders.resize(maxOccluders);
+  }
+
+  _occlusionBuffer->clear(viewProjection);
+  for (const auto& [size, i] : _occluders) {
+    const OccluderMesh& occluder{_occluderMeshes[_objectMeshes[i]]};
+    _occlusionBuffer->rasterize(
+      occluder.positions, occluder.indices, _modelMatrices[i]
+    );
+  }
+  _occlusionBuffer->buildHierarchy();
+  const auto visibleEnd{std::remove_if(
+    _visibleObjects.begin(), _visibleObjects.end(),
+    [this](std::uint32_t i) {
+      return _occlusionBuffer->isOccluded(_objectBoxes[i]);
+    }
+  )};
+  _stats.occludedObjects = static_cast<std::size_t>(
+    _visibleObjects.end() - visibleEnd
+  );
+  _visibleObjects.erase(visibleEnd, _visibleObjects.end());
+  _stats.visibleObjects = _visibleObjects.size();
+  const std::chrono::duration<double, std::milli> occlusionTime{
+    std::chrono::steady_clock::now() - occlusionStart
+  };
+  _stats.occlusionMilliseconds = occlusionTime.count();
+}
+
+auto my::GraphicsEngine::selectLevel(
+  std::uint32_t object, const glm::mat4& viewMatrix, float projectionScale
+) -> std::uint32_t {
+  const auto mesh{static_cast<std::uint32_t>(_objectMeshes[object])};
+  const std::vector<std::uint32_t>& levels{_meshLevels[mesh]};
+  std::uint8_t& level{_objectLevels[object]};
+  if (levels.empty() || !_settings.levelsOfDetail) {
+    level = 0;
+    return mesh;
+  }
+  const BoundingSphere sphere{
+    _meshBounds[mesh].sphere.transform(_modelMatrices[object])
+  };
+  const glm::vec4 center{viewMatrix*glm::vec4{sphere.center, 1.f}};
+  const float distance{glm::length(glm::vec3{center.x, center.y, center.z})};
+  if (distance <= sphere.radius) {
+    level = 0;
+    return mesh;
+  }
+  const float size{sphere.radius*projectionScale/distance};
+  const auto getSwitchSize{[](std::size_t coarser) {
+    return levelOfDetailSize/static_cast<float>(1 << (coarser - 1));
+  }};
+  // Levels can be fewer than last time if the mesh was replaced.
+  level = static_cast<std::uint8_t>(
+    std::min<std::size_t>(level, levels.size())
+  );
+  while (
+    level < levels.size()
+    && size < getSwitchSize(level + 1u)*(1.f - levelOfDetailHysteresis)
+  ) {
+    level++;
+  }
+  while (
+    level > 0 && size > getSwitchSize(level)*(1.f + levelOfDetailHysteresis)
+  ) {
+    level--;
+  }
+  return level == 0 ? mesh : levels[level - 1u];
+}
+
+auto my::GraphicsEngine::queueObjects(
+  const glm::mat4& viewMatrix, float projectionScale
+) -> void {
+  PROFILE_SCOPE("Queue");
+  _renderQueue.clear();
+  _renderQueue.reserve(_visibleObjects.size());
+  for (const auto i : _visibleObjects) {
+    SortKey key{};
+    key.transformed = !_settings.instancing || !isIdentity(_modelMatrices[i]);
+    const std::uint32_t mesh{selectLevel(i, viewMatrix, projectionScale)};
+    key.mesh = mesh;
+    key.depth = quantizeDepth(viewMatrix, _modelMatrices[i]);
+    _renderQueue.push({key.pack(), i, mesh});
+  }
+  _renderQueue.sort();
+}
+
+auto my::GraphicsEngine::renderPerObject() -> void {
+  PROFILE_SCOPE("Submit");
+  const Uniform& modelUniform{_mainProgram.getUniforms().at(0)};
+  const VertexArray& vao{_mainProgram.getVertexArrays().at(0)};
+  vao.bind();
+  for (const auto& item : _renderQueue.getItems()) {
+    const MeshRange& mesh{_meshArena.get(item.mesh)};
+    modelUniform.setData(_modelMatrices[item.object]);
+    vao.drawTriangles(
+      mesh.indexType, mesh.indexCount, mesh.indexOffset, mesh.baseVertex
+    );
+    _stats.drawCalls++;
+    _stats.triangles += static_cast<std::size_t>(mesh.indexCount/3);
+  }
+}
+
+auto my::GraphicsEngine::renderInstanced() -> void {
+  PROFILE_SCOPE("Submit");
+  // Gather the sorted items into batches, writing the model matrices of
+  // each transformed batch contiguously into this frame's region of the
+  // instance stream.
+  const GLsizeiptr instanceBytes{static_cast<GLsizeiptr>(
+    (_renderQueue.getItems().size() + 1)*sizeof(InstanceData)
+  )};
+  // Sized from this frame's draws, so the one allocation always fits.
+  _instanceStream->reserve(instanceBytes);
+  _instanceStream->beginFrame();
+  const std::optional<StreamAllocation> allocation{
+    _instanceStream->allocate(instanceBytes, sizeof(glm::vec4))
+  };
+  if (!allocation) {
+    _instanceStream->finishWrites();
+    throw std::runtime_error{"Instance data doesn't fit its stream buffer"};
+  }
+  const auto instances{static_cast<InstanceData*>(allocation->data)};
+  GLsizei instanceCount{};
+  instances[instanceCount++] = {glm::mat4{1.}};
+  _batches.clear();
+  const std::vector<DrawItem>& items{_renderQueue.getItems()};
+  for (std::size_t first{}; first < items.size();) {
+    const DrawItem& item{items[first]};
+    if (!SortKey::unpack(item.key).transformed) {
+      _batches.push_back({item.mesh, false, 0, 1});
+      first++;
+      continue;
+    }
+    // Meshes whose IDs share a key group can be interleaved by depth;
+    // they just split into smaller batches.
+    const std::uint64_t batchKey{SortKey::getBatch(item.key)};
+    Batch batch{item.mesh, true, instanceCount, 0};
+    std::size_t last{first};
+    for (; last < items.size(); last++) {
+      if (
+        SortKey::getBatch(items[last].key) != batchKey
+        || items[last].mesh != item.mesh
+      ) {
+        break;
+      }
+      instances[instanceCount++] = {_modelMatrices[items[last].object]};
+    }
+    batch.instanceCount = static_cast<GLsizei>(last - first);
+    _batches.push_back(batch);
+    first = last;
+  }
+  _instanceStream->finishWrites();
+
+  const VertexArray& vao{_mainProgram.getVertexArrays().at(0)};
+  vao.bind();
+  _instanceStream->getBuffer().bind();
+  for (std::size_t first{}; first < _batches.size();) {
+    const Batch& batch{_batches[first]};
+    if (!batch.transformed) {
+      std::size_t last{first + 1};
+      while (last < _batches.size() && !_batches[last].transformed) {
+        last++;
+      }
+      // One multi-draw per index type.
+      submitUntransformed(
+        first, last, IndexType::UnsignedShort, allocation->offset
+      );
+      submitUntransformed(
+        first, last, IndexType::UnsignedInt, allocation->offset
+      );
+      first = last;
+      continue;
+    }
+    const MeshRange& mesh{_meshArena.get(batch.mesh)};
+    pointModelAttribute(
+      allocation->offset
+      + static_cast<GLintptr>(batch.firstInstance*sizeof(InstanceData))
+    );
+    vao.drawTrianglesInstanced(
+      mesh.indexType, mesh.indexCount, mesh.indexOffset, mesh.baseVertex,
+      batch.instanceCount
+    );
+    _stats.drawCalls++;
+    _stats.triangles += static_cast<std::size_t>(
+      mesh.indexCount/3*batch.instanceCount
+    );
+    first++;
+  }
+  _instanceStream->endFrame();
+  _stats.streamStalls = _instanceStream->getStallCount();
+}
+
+auto my::GraphicsEngine::submitUntransformed(
+  std::size_t first, std::size_t last, IndexType indexType,
+  GLintptr identityOffset
+) -> void {
+  // Without a per-draw instance offset (GL 3.3 has no base instance),
+  // a multi-draw can only share one transform, so it's reserved for
+  // meshes that are already in world space.
+  _multiDrawCounts.clear();
+  _multiDrawOffsets.clear();
+  _multiDrawBaseVertices.clear();
+  for (std::size_t i{first}; i < last; i++) {
+    const MeshRange& mesh{_meshArena.get(_batches[i].mesh)};
+    if (mesh.indexType != indexType) {
+      continue;
+    }
+    _multiDrawCounts.push_back(mesh.indexCount);
+    _multiDrawOffsets.push_back(
+      reinterpret_cast<const GLvoid*>(mesh.indexOffset)
+    );
+    _multiDrawBaseVertices.push_back(mesh.baseVertex);
+    _stats.triangles += static_cast<std::size_t>(mesh.indexCount/3);
+  }
+  if (_multiDrawCounts.empty()) {
+    return;
+  }
+  pointModelAttribute(identityOffset);
+  const VertexArray& vao{_mainProgram.getVertexArrays().at(0)};
+  vao.multiDrawTriangles(
+    indexType, _multiDrawCounts.data(), _multiDrawOffsets.data(),
+    _multiDrawBaseVertices.data(),
+    static_cast<GLsizei>(_multiDrawCounts.size())
+  );
+  _stats.drawCalls++;
 }
 
 namespace {
@@ -127,40 +771,115 @@ namespace {
 auto debugMessageCallbackGL(
   GLenum, GLenum, GLuint, GLenum, GLsizei, const GLchar* message, const GLvoid*
 ) -> void {
-  LOG_ERROR("GL error: " << message << '\n');
+  LOG_ERROR("GL error: {}", message);
 }
 #endif // DEBUG
 
-auto initializeGL() -> bool {
-  if (!gladLoadGL(glfwGetProcAddress)) {
+auto initializeGL(GLADloadfunc loader) -> bool {
+  if (!gladLoadGL(loader)) {
     return false;
   }
 #ifdef DEBUG
   if (GLAD_GL_ARB_debug_output) {
-    LOG("GL extension GL_ARB_debug_output available\n");
+    LOG_INFO("GL extension GL_ARB_debug_output available");
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
     glDebugMessageCallbackARB(debugMessageCallbackGL, nullptr /*userParam*/);
   }
   else {
-    LOG("GL extension GL_ARB_debug_output unavailable\n");
+    LOG_INFO("GL extension GL_ARB_debug_output unavailable");
   }
 #endif
-  LOG("C++ version: " << STRING(__cplusplus) << '\n');
-  LOG("Driver OpenGL version: " << glGetString(GL_VERSION) << '\n');
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    // Shaders then compile and link on the driver's threads, side by
+    // side, until something asks for their status.
+    glMaxShaderCompilerThreadsKHR(0xffffffff);
+  }
+  LOG_INFO("C++ version: {}", __cplusplus);
+  LOG_INFO("Driver OpenGL version: {}", glGetString(GL_VERSION));
   return true;
 }
 
+auto getShaderVariant(const my::RenderSettings& settings) -> std::uint32_t {
+  std::uint32_t variant{};
+  if (settings.instancing) {
+    variant |= instancingFeature;
+  }
+  if (settings.fog) {
+    variant |= fogFeature;
+  }
+  return variant;
+}
+
+#ifdef USE_STATIC_SHADERS
+
 auto buildProgram(
-  std::string_view vertexPath, std::string_view fragmentPath
+  my::ThreadPool&, my::ProgramCache& programCache, std::uint32_t variant
 ) -> my::ShaderProgram {
-  std::optional<std::string> vertexSource{my::readFile(vertexPath)};
-  std::optional<std::string> fragmentSource{my::readFile(fragmentPath)};
+  const my::staticShaders::Variant& sources{
+    my::staticShaders::mainVariants[variant]
+  };
+  return programCache.build(sources.vertex, sources.fragment);
+}
+
+#else
+
+auto buildProgram(
+  my::ThreadPool& workers, my::ProgramCache& programCache,
+  std::uint32_t variant
+) -> my::ShaderProgram {
+  auto sources{my::readFilesAsync(
+    workers, {std::string{mainVertexPath}, std::string{mainFragmentPath}}
+  )};
+  std::optional<std::string> vertexSource{sources[0].get()};
+  std::optional<std::string> fragmentSource{sources[1].get()};
   if (!vertexSource || !fragmentSource) {
     throw std::runtime_error{"Failed to load shader sources"};
   }
-  my::Shader vertexShader{my::ShaderType::Vertex, *vertexSource};
-  my::Shader fragmentShader{my::ShaderType::Fragment, *fragmentSource};
-  return {vertexShader, fragmentShader};
+  insertDefines(*vertexSource, variant);
+  insertDefines(*fragmentSource, variant);
+  return programCache.build(*vertexSource, *fragmentSource);
+}
+
+auto insertDefines(std::string& source, std::uint32_t variant) -> void {
+  std::string defines{};
+  for (std::size_t feature{}; feature < std::size(shaderFeatures); feature++) {
+    if (variant & (1u << feature)) {
+      defines += "#define ";
+      defines += shaderFeatures[feature];
+      defines += '\n';
+    }
+  }
+  // #version has to stay the first line, so the defines go after it.
+  const std::size_t versionEnd{source.find('\n') + 1};
+  source.insert(versionEnd, defines);
+}
+
+#endif // USE_STATIC_SHADERS
+
+auto isIdentity(const glm::mat4& matrix) -> bool {
+  return matrix == glm::mat4{1.};
+}
+
+auto quantizeDepth(const glm::mat4& viewMatrix, const glm::mat4& modelMatrix)
+-> std::uint32_t {
+  const float distance{-(viewMatrix*modelMatrix[3]).z};
+  const float normalized{std::clamp(distance / maxSortDepth, 0.f, 1.f)};
+  return static_cast<std::uint32_t>(normalized*65535.f);
+}
+
+auto pointModelAttribute(GLintptr offset) -> void {
+  // Repeats what the vertex array builder set up for the model attribute,
+  // starting from a different instance.
+  const auto location{static_cast<GLuint>(my::AttributeLocation::Model)};
+  for (GLuint column{}; column < 4; column++) {
+    const auto columnOffset{
+      offset + static_cast<GLintptr>(column*sizeof(glm::vec4))
+    };
+    glVertexAttribPointer(
+      location + column, 4, GL_FLOAT, false, sizeof(my::InstanceData),
+      reinterpret_cast<const GLvoid*>(columnOffset)
+    );
+  }
 }
 
 } // namespace
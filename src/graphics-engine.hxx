@@ -1,14 +1,32 @@
 #ifndef GRAPHICS_HXX
 #define GRAPHICS_HXX
 
+#include <cstddef>
+#include <cstdint>
+#include <future>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include <glad/gl.h>
 
-#include "camera.hxx"
+#include "bounds.hxx"
+#include "bvh.hxx"
+#include "file-watcher.hxx"
+#include "game.hxx"
+#include "graphics-state.hxx"
+#include "gpu-profiler.hxx"
 #include "graphics-types.hxx"
+#include "mesh-arena.hxx"
+#include "mesh-file.hxx"
+#include "models.hxx"
+#include "occlusion-buffer.hxx"
+#include "program-cache.hxx"
+#include "render-queue.hxx"
+#include "stream-buffer.hxx"
+#include "thread-pool.hxx"
 
 /*
  * Declarations.
@@ -16,27 +34,178 @@
 
 namespace my {
 
+struct RenderSettings {
+  // Draw repeated meshes with one instanced draw call each.
+  bool instancing{true};
+  // Skip objects hidden behind nearer ones, tested on the CPU.
+  bool occlusion{true};
+  // Draw meshes that have simplified levels with fewer triangles the
+  // smaller they are on screen.
+  bool levelsOfDetail{true};
+  // Fade distant geometry into the background.
+  bool fog{};
+  // Rebuild the shaders whenever their files change, without stopping;
+  // not available with USE_STATIC_SHADERS.
+  bool shaderHotReload{};
+  // Directory to keep linked shader programs in between runs; empty
+  // compiles them every time.
+  std::string programCache{};
+};
+
+// Vertices the post-transform cache would transform for every mesh added
+// so far, with the indices as given and as optimized; over the triangle
+// count, these are the average cache miss ratios.
+struct VertexCacheStats {
+  std::size_t triangles{};
+  std::size_t transformsBefore{};
+  std::size_t transformsAfter{};
+};
+
+struct RenderStats {
+  std::size_t objects{};
+  std::size_t drawCalls{};
+  std::size_t triangles{};
+  std::size_t uniformBlockUploads{};
+  std::size_t streamStalls{};
+  std::size_t visibleObjects{};
+  std::size_t culledObjects{};
+  double cullMilliseconds{};
+  std::size_t occludedObjects{};
+  double occlusionMilliseconds{};
+  double submitMilliseconds{};
+  StateCounters stateChanges{};
+  MeshArenaStats meshes{};
+  VertexCacheStats vertexCache{};
+  ProgramCacheStats programs{};
+};
+
 class GraphicsEngine {
 public:
-  GraphicsEngine();
+  // Shader sources are read on the workers.
+  GraphicsEngine(
+    GLADloadfunc loader, const RenderSettings& settings, ThreadPool& workers
+  );
+  GraphicsEngine() = delete;
   GraphicsEngine(const GraphicsEngine&) = delete;
   GraphicsEngine(GraphicsEngine&&) = delete;
   GraphicsEngine& operator=(const GraphicsEngine&) = delete;
   GraphicsEngine& operator=(GraphicsEngine&&) = delete;
 
-  auto setCamera(const Camera* camera) -> void;
+  // IDs are what ObjectState::mesh refers to. Removed IDs get reused.
+  // Levels are successively simplified versions of the geometry, as from
+  // buildLevelsOfDetail(), within its bounds. The occluder, if given,
+  // stands in for the mesh in the occlusion buffer and must lie inside
+  // it; otherwise one is picked from the mesh and its levels. Positions
+  // are packed relative to the center of the bounds, as in mesh files.
+  auto addMesh(
+    const Geometry& geometry, const std::vector<MeshGeometry>& levels = {},
+    const Geometry* occluder = nullptr
+  ) -> std::uint32_t;
+  // Uploads every level straight from the file's mapping, placed by its
+  // transform. The finest level small enough, if any, is also unpacked
+  // as the occluder.
+  auto addMesh(const MeshFile& file) -> std::uint32_t;
+  auto removeMesh(std::uint32_t mesh) -> void;
   auto resize(int width, int height) -> void;
-  auto render() const -> void;
+  // Static objects are drawn along with the state's objects; they are
+  // owned by the render thread, such as the chunks of a voxel world.
+  auto render(
+    const GameState& state, float alpha,
+    const std::vector<ObjectState>& staticObjects
+  ) -> void;
+  auto getStats() const -> const RenderStats&;
 
 private:
+  // Consecutive draws of one mesh. Transformed batches are instanced,
+  // reading instanceCount model matrices from firstInstance on; the
+  // others draw once with the identity in instance slot 0.
+  struct Batch {
+    std::uint32_t mesh{};
+    bool transformed{};
+    GLsizei firstInstance{};
+    GLsizei instanceCount{};
+  };
+  // CPU copy of a mesh's stand-in in the occlusion buffer; empty for
+  // meshes without one within the triangle budget.
+  struct OccluderMesh {
+    std::vector<glm::vec3> positions{};
+    std::vector<GLuint> indices{};
+  };
+
   bool _glAvailable;
+  RenderSettings _settings;
+  ThreadPool& _workers;
   int _windowWidth{};
   int _windowHeight{};
+  ProgramCache _programCache;
   ShaderProgram _mainProgram;
-  std::vector<Buffer> _buffers{};
-  const Camera* _camera{nullptr};
+  // A reload reads the changed sources on the workers, then builds the
+  // program over as many frames as the driver takes, then swaps it in
+  // at the start of a frame.
+  std::optional<FileWatcher> _shaderWatcher{};
+  std::vector<std::future<std::optional<std::string>>> _shaderReads{};
+  std::optional<ProgramBuild> _programBuild{};
+  UniformBlock _cameraBlock;
+  MeshArena _meshArena;
+  // Arena generation the vertex array was last built against.
+  std::uint32_t _vertexArrayGeneration{};
+  // Mesh IDs get reused, so any change invalidates every object's bounds.
+  bool _meshesChanged{};
+  // Per-frame model matrices; slot 0 holds the identity.
+  std::optional<StreamBuffer> _instanceStream{};
+  // Per mesh, in the space of its packed positions, along with the
+  // transform that puts them back where the source geometry had them.
+  std::vector<MeshBounds> _meshBounds{};
+  std::vector<glm::mat4> _meshPlacements{};
+  // Arena IDs of levels 1 and up per mesh; the mesh itself is level 0.
+  std::vector<std::vector<std::uint32_t>> _meshLevels{};
+  // Per object, as of the last frame: the interpolated model matrix
+  // (including the mesh's placement), the mesh and their world-space box.
+  std::vector<glm::mat4> _modelMatrices{};
+  std::vector<std::size_t> _objectMeshes{};
+  std::vector<BoundingBox> _objectBoxes{};
+  // Level of detail each object was last drawn at, for hysteresis.
+  std::vector<std::uint8_t> _objectLevels{};
+  BoundingVolumeHierarchy _bvh{};
+  std::vector<std::uint32_t> _visibleObjects{};
+  std::optional<OcclusionBuffer> _occlusionBuffer{};
+  std::vector<OccluderMesh> _occluderMeshes{};
+  // Visible objects ranked by how much of the screen they might cover.
+  std::vector<std::pair<float, std::uint32_t>> _occluders{};
+  RenderQueue _renderQueue{};
+  std::vector<Batch> _batches{};
+  std::vector<GLsizei> _multiDrawCounts{};
+  std::vector<const GLvoid*> _multiDrawOffsets{};
+  std::vector<GLint> _multiDrawBaseVertices{};
+  GpuProfiler _gpuProfiler{};
+  RenderStats _stats{};
+  VertexCacheStats _vertexCacheStats{};
 
+  auto uploadMesh(const Geometry& geometry) -> std::uint32_t;
+  auto trackMesh(
+    std::uint32_t mesh, const MeshBounds& bounds, const glm::mat4& placement
+  ) -> void;
+  auto prepareProgram(ShaderProgram& program) const -> void;
+  auto reloadShaders() -> void;
+  auto buildVertexArray() -> void;
+  auto maintainMeshes() -> void;
   auto resetFrame() const -> void;
+  auto cullObjects(
+    const GameState& state, const std::vector<ObjectState>& staticObjects,
+    float alpha, const glm::mat4& viewProjection
+  ) -> void;
+  auto occludeObjects(const glm::mat4& viewProjection) -> void;
+  auto selectLevel(
+    std::uint32_t object, const glm::mat4& viewMatrix, float projectionScale
+  ) -> std::uint32_t;
+  auto queueObjects(const glm::mat4& viewMatrix, float projectionScale)
+  -> void;
+  auto renderPerObject() -> void;
+  auto renderInstanced() -> void;
+  auto submitUntransformed(
+    std::size_t first, std::size_t last, IndexType indexType,
+    GLintptr identityOffset
+  ) -> void;
 };
 
 } // namespace my
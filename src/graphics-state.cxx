@@ -0,0 +1,150 @@
+#include "graphics-state.hxx"
+
+/*
+ * Definitions.
+ */
+
+auto my::StateCache::current() -> StateCache& {
+  thread_local StateCache cache{};
+  return cache;
+}
+
+auto my::StateCache::bindVertexArray(GLuint id) -> void {
+  if (id == _vertexArray) {
+    _counters.elided++;
+    return;
+  }
+  glBindVertexArray(id);
+  _vertexArray = id;
+  // The element array binding is part of the vertex array.
+  _buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = _unknown;
+  _counters.issued++;
+}
+
+auto my::StateCache::bindBuffer(GLenum target, GLuint id) -> void {
+  const std::size_t slot{getBufferSlot(target)};
+  if (slot < _buffers.size() && id == _buffers[slot]) {
+    _counters.elided++;
+    return;
+  }
+  glBindBuffer(target, id);
+  if (slot < _buffers.size()) {
+    _buffers[slot] = id;
+  }
+  _counters.issued++;
+}
+
+auto my::StateCache::bindBufferBase(
+  GLenum target, GLuint index, GLuint id
+) -> void {
+  // Indexed bindings are only set up once per block, so they aren't
+  // shadowed; but binding one also replaces the generic binding.
+  glBindBufferBase(target, index, id);
+  const std::size_t slot{getBufferSlot(target)};
+  if (slot < _buffers.size()) {
+    _buffers[slot] = id;
+  }
+  _counters.issued++;
+}
+
+auto my::StateCache::useProgram(GLuint id) -> void {
+  if (id == _program) {
+    _counters.elided++;
+    return;
+  }
+  glUseProgram(id);
+  _program = id;
+  _counters.issued++;
+}
+
+auto my::StateCache::viewport(
+  GLint x, GLint y, GLsizei width, GLsizei height
+) -> void {
+  const std::array<GLint, 4> viewport{x, y, width, height};
+  if (_viewportKnown && viewport == _viewport) {
+    _counters.elided++;
+    return;
+  }
+  glViewport(x, y, width, height);
+  _viewport = viewport;
+  _viewportKnown = true;
+  _counters.issued++;
+}
+
+auto my::StateCache::clearColor(
+  GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha
+) -> void {
+  const std::array<GLfloat, 4> color{red, green, blue, alpha};
+  if (_clearColorKnown && color == _clearColor) {
+    _counters.elided++;
+    return;
+  }
+  glClearColor(red, green, blue, alpha);
+  _clearColor = color;
+  _clearColorKnown = true;
+  _counters.issued++;
+}
+
+auto my::StateCache::onDeleteVertexArray(GLuint id) -> void {
+  // GL reverts deleted bindings to 0.
+  if (id == _vertexArray) {
+    _vertexArray = 0;
+    _buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = 0;
+  }
+}
+
+auto my::StateCache::onDeleteBuffer(GLuint id) -> void {
+  for (auto& buffer : _buffers) {
+    if (buffer == id) {
+      buffer = 0;
+    }
+  }
+}
+
+auto my::StateCache::onDeleteProgram(GLuint id) -> void {
+  // A deleted program stays in use until another one is installed, so
+  // the binding is left alone; it just can't be matched again.
+  if (id == _program) {
+    _program = _unknown;
+  }
+}
+
+auto my::StateCache::invalidate() -> void {
+  _vertexArray = _unknown;
+  _buffers.fill(_unknown);
+  _program = _unknown;
+  _viewportKnown = false;
+  _clearColorKnown = false;
+}
+
+auto my::StateCache::getCounters() const -> const StateCounters& {
+  return _counters;
+}
+
+auto my::StateCache::resetCounters() -> void {
+  _counters = {};
+}
+
+auto my::StateCache::getBufferSlot(GLenum target) const -> std::size_t {
+  switch (target) {
+    case GL_ARRAY_BUFFER: {
+      return 0;
+    }
+    case GL_ELEMENT_ARRAY_BUFFER: {
+      return 1;
+    }
+    case GL_UNIFORM_BUFFER: {
+      return 2;
+    }
+    case GL_COPY_READ_BUFFER: {
+      return 3;
+    }
+    case GL_COPY_WRITE_BUFFER: {
+      return 4;
+    }
+    default: {
+      // Untracked targets are always passed through.
+      return _bufferTargetCount;
+    }
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef GRAPHICS_STATE_HXX
+#define GRAPHICS_STATE_HXX
+
+#include <array>
+#include <cstddef>
+
+#include <glad/gl.h>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct StateCounters {
+  std::size_t issued{};
+  std::size_t elided{};
+};
+
+// Shadows the GL binding state of the context current on this thread
+// and drops calls that wouldn't change it. All binds made by the
+// wrapper types go through here, so code that calls GL directly must
+// call invalidate() afterwards.
+class StateCache {
+public:
+  StateCache() = default;
+  StateCache(const StateCache&) = delete;
+  StateCache(StateCache&&) = delete;
+  auto operator=(const StateCache&) -> StateCache& = delete;
+  auto operator=(StateCache&&) -> StateCache& = delete;
+
+  // GL contexts are current per thread, so each thread gets its own
+  // cache.
+  static auto current() -> StateCache&;
+
+  auto bindVertexArray(GLuint id) -> void;
+  auto bindBuffer(GLenum target, GLuint id) -> void;
+  auto bindBufferBase(GLenum target, GLuint index, GLuint id) -> void;
+  auto useProgram(GLuint id) -> void;
+  auto viewport(GLint x, GLint y, GLsizei width, GLsizei height) -> void;
+  auto clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+  -> void;
+  auto onDeleteVertexArray(GLuint id) -> void;
+  auto onDeleteBuffer(GLuint id) -> void;
+  auto onDeleteProgram(GLuint id) -> void;
+  auto invalidate() -> void;
+  auto getCounters() const -> const StateCounters&;
+  auto resetCounters() -> void;
+
+private:
+  // Marks state we don't know, e.g. before the first call; never equal
+  // to a real object name.
+  static constexpr GLuint _unknown{~0u};
+  static constexpr std::size_t _bufferTargetCount{5};
+
+  GLuint _vertexArray{_unknown};
+  std::array<GLuint, _bufferTargetCount> _buffers{
+    _unknown, _unknown, _unknown, _unknown, _unknown
+  };
+  GLuint _program{_unknown};
+  std::array<GLint, 4> _viewport{};
+  std::array<GLfloat, 4> _clearColor{};
+  bool _viewportKnown{false};
+  bool _clearColorKnown{false};
+  StateCounters _counters{};
+
+  auto getBufferSlot(GLenum target) const -> std::size_t;
+};
+
+} // namespace my
+
+#endif // GRAPHICS_STATE_HXX
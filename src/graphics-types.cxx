@@ -1,16 +1,19 @@
 #include "graphics-types.hxx"
 
+#include <cstring>
 #include <optional>
 #include <stdexcept>
+#include <string>
 
-#include "debug.hxx"
+#include "graphics-state.hxx"
+#include "logger.hxx"
 #include "models.hxx"
 
 #ifdef DEBUG
-#define LOG_ERROR_INVALID(x) LOG_ERROR("Invalid " << x << '\n')
-#define LOG_MOVING(x) LOG("Moving " << x << '\n')
-#define LOG_MOVE_ASSIGNING(x) LOG("Move-assigning " << x << '\n')
-#define LOG_CLEANING_UP(x) LOG("Cleaning up " << x << '\n')
+#define LOG_ERROR_INVALID(x) LOG_ERROR("Invalid {}", x)
+#define LOG_MOVING(x) LOG_DEBUG("Moving {}", x)
+#define LOG_MOVE_ASSIGNING(x) LOG_DEBUG("Move-assigning {}", x)
+#define LOG_CLEANING_UP(x) LOG_DEBUG("Cleaning up {}", x)
 #else
 #define LOG_ERROR_INVALID(x)
 #define LOG_MOVING(x)
@@ -18,22 +21,32 @@
 #define LOG_CLEANING_UP(x)
 #endif // DEBUG
 
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto logLinkErrors(
+  GLuint program, const my::Shader& vertexShader,
+  const my::Shader& fragmentShader
+) -> void;
+
+} // namespace
+
 /*
  * Definitions.
  */
 
 my::Buffer::Buffer(
   BufferTarget target, const GLvoid* data, GLsizei size, BufferUsage usage
-) : _target{target} {
-  const auto targetGL{static_cast<GLenum>(target)};
+) : _target{target}, _usage{usage} {
   glGenBuffers(1, &_id);
-  glBindBuffer(targetGL, _id);
-  glBufferData(targetGL, size, data, static_cast<GLenum>(usage));
-  glBindBuffer(targetGL, 0);
+  setData(data, size);
 }
 
 my::Buffer::Buffer(Buffer&& buffer)
-: _target{buffer._target}, _id{buffer._id} {
+: _target{buffer._target}, _usage{buffer._usage}, _id{buffer._id} {
   LOG_MOVING(buffer);
   buffer._valid = false;
 }
@@ -41,6 +54,7 @@ my::Buffer::Buffer(Buffer&& buffer)
 auto my::Buffer::operator=(Buffer&& buffer) -> Buffer& {
   LOG_MOVE_ASSIGNING(buffer);
   _target = buffer._target;
+  _usage = buffer._usage;
   _id = buffer._id;
   buffer._valid = false;
   return *this;
@@ -52,6 +66,7 @@ my::Buffer::~Buffer() {
   }
   LOG_CLEANING_UP(*this);
   glDeleteBuffers(1, &_id);
+  StateCache::current().onDeleteBuffer(_id);
 }
 
 #ifdef DEBUG
@@ -67,6 +82,10 @@ auto my::operator<<(std::ostream& out, const my::Buffer& buffer)
       out << "ElementArray";
       break;
     }
+    case BufferTarget::Uniform: {
+      out << "Uniform";
+      break;
+    }
     default: {
       out << "?";
       break;
@@ -88,30 +107,30 @@ auto my::Buffer::bind() const -> void {
     throw std::runtime_error{"Attempt to bind invalid buffer"};
   }
 #endif // DEBUG
-  glBindBuffer(static_cast<GLenum>(_target), _id);
+  StateCache::current().bindBuffer(static_cast<GLenum>(_target), _id);
 }
 
 auto my::Buffer::unbind() const -> void {
-  glBindBuffer(static_cast<GLenum>(_target), 0);
+  StateCache::current().bindBuffer(static_cast<GLenum>(_target), 0);
 }
 
-my::ShaderAttribute::ShaderAttribute(
-  std::string_view name_, const Buffer& buffer_, GLint size_,
-  AttributeType type_, GLboolean normalized_, GLint stride_,
-  const GLvoid* pointer_
-) : name{name_}, buffer{buffer_}, size{size_}, type{type_},
-    normalized{normalized_}, stride{stride_}, pointer{pointer_} {}
-
-my::VertexArrayBuilder::VertexArrayBuilder(ShaderProgram& program)
-: _program{program} {}
+auto my::Buffer::setData(const GLvoid* data, GLsizeiptr size) -> void {
+  // Respecifying the whole store lets the driver hand out fresh memory
+  // instead of waiting for draws still reading the old contents. Uploads
+  // go through the copy-write target, which unlike the element array
+  // target isn't part of whatever vertex array is bound.
+  StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, _id);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, data, static_cast<GLenum>(_usage));
+}
 
-auto my::operator<<(VertexArrayBuilder& builder, ShaderAttribute* attribute)
--> VertexArrayBuilder& {
-  builder._attributes.push_back(attribute);
-  return builder;
+auto my::Buffer::setSubData(
+  GLintptr offset, const GLvoid* data, GLsizeiptr size
+) -> void {
+  StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, _id);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
 }
 
-auto my::operator<<(VertexArrayBuilder& builder, Buffer* buffer)
+auto my::operator<<(VertexArrayBuilder& builder, const Buffer* buffer)
 -> VertexArrayBuilder& {
   builder._indexBuffer = buffer;
   return builder;
@@ -137,31 +156,44 @@ auto my::VertexArrayBuilder::build() -> VertexArray {
   }
 #endif // DEBUG
 
+  StateCache& state{StateCache::current()};
   GLuint id;
   glGenVertexArrays(1, &id);
-  glBindVertexArray(id);
-
-  for (const auto attribute : _attributes) {
-    const GLint location{glGetAttribLocation(
-      _program.getID(), attribute->name.data()
-    )};
-    attribute->buffer.bind();
-    glVertexAttribPointer(
-      location, attribute->size, static_cast<GLenum>(attribute->type),
-      attribute->normalized, attribute->stride, attribute->pointer
-    );
-    glEnableVertexAttribArray(location);
+  state.bindVertexArray(id);
+
+  // Locations are fixed, so this is nothing but the GL calls.
+  for (const auto& binding : _bindings) {
+    binding.buffer->bind();
+    for (std::size_t i{}; i < binding.attributeCount; i++) {
+      const VertexAttribute& attribute{binding.attributes[i]};
+      const auto location{static_cast<GLuint>(attribute.location)};
+      const std::size_t columnSize{
+        getAttributeColumnSize(attribute.type, attribute.size)
+      };
+      for (GLint column{}; column < attribute.columns; column++) {
+        const auto columnLocation{location + static_cast<GLuint>(column)};
+        const std::size_t offset{
+          attribute.offset + static_cast<std::size_t>(column)*columnSize
+        };
+        glVertexAttribPointer(
+          columnLocation, attribute.size, static_cast<GLenum>(attribute.type),
+          attribute.normalized, binding.stride,
+          reinterpret_cast<const GLvoid*>(offset)
+        );
+        glVertexAttribDivisor(columnLocation, binding.divisor);
+        glEnableVertexAttribArray(columnLocation);
+      }
+    }
   }
 
   if (_indexBuffer) {
     _indexBuffer->bind();
   }
 
-  glBindVertexArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-  _attributes.clear();
+  // The vertex array is left bound: buffer uploads don't use the element
+  // array target, so nothing can modify it by accident, and the next
+  // bind of it is free.
+  _bindings.clear();
   _indexBuffer = nullptr;
 
   return {id, _indexCount};
@@ -190,6 +222,7 @@ my::VertexArray::~VertexArray() {
   }
   LOG_CLEANING_UP(*this);
   glDeleteVertexArrays(1, &_id);
+  StateCache::current().onDeleteVertexArray(_id);
 }
 
 #ifdef DEBUG
@@ -216,11 +249,11 @@ auto my::VertexArray::bind() const -> void {
     throw std::runtime_error{"Attempt to bind invalid vertex array"};
   }
 #endif // DEBUG
-  glBindVertexArray(_id);
+  StateCache::current().bindVertexArray(_id);
 }
 
 auto my::VertexArray::unbind() const -> void {
-  glBindVertexArray(0);
+  StateCache::current().bindVertexArray(0);
 }
 
 auto my::VertexArray::drawTriangles() const -> void {
@@ -229,6 +262,44 @@ auto my::VertexArray::drawTriangles() const -> void {
   );
 }
 
+auto my::VertexArray::drawTrianglesInstanced(GLsizei instanceCount) const
+-> void {
+  glDrawElementsInstanced(
+    GL_TRIANGLES, _indexCount, GL_UNSIGNED_SHORT, nullptr, instanceCount
+  );
+}
+
+auto my::VertexArray::drawTriangles(
+  IndexType indexType, GLsizei indexCount, GLsizeiptr indexOffset,
+  GLint baseVertex
+) const -> void {
+  glDrawElementsBaseVertex(
+    GL_TRIANGLES, indexCount, static_cast<GLenum>(indexType),
+    reinterpret_cast<const GLvoid*>(indexOffset), baseVertex
+  );
+}
+
+auto my::VertexArray::drawTrianglesInstanced(
+  IndexType indexType, GLsizei indexCount, GLsizeiptr indexOffset,
+  GLint baseVertex, GLsizei instanceCount
+) const -> void {
+  glDrawElementsInstancedBaseVertex(
+    GL_TRIANGLES, indexCount, static_cast<GLenum>(indexType),
+    reinterpret_cast<const GLvoid*>(indexOffset), instanceCount, baseVertex
+  );
+}
+
+auto my::VertexArray::multiDrawTriangles(
+  IndexType indexType, const GLsizei* indexCounts,
+  const GLvoid* const* indexOffsets, const GLint* baseVertices,
+  GLsizei drawCount
+) const -> void {
+  glMultiDrawElementsBaseVertex(
+    GL_TRIANGLES, indexCounts, static_cast<GLenum>(indexType), indexOffsets,
+    drawCount, baseVertices
+  );
+}
+
 my::Shader::Shader(
   ShaderType type, std::string_view source
 ) : _type{type}, _id{glCreateShader(static_cast<GLenum>(type))} {
@@ -329,49 +400,158 @@ auto my::Uniform::getLocation() const -> GLint {
   return _location;
 }
 
+template<>
+auto my::Uniform::setData(const GLfloat& data) const -> void {
+  glUniform1f(_location, data);
+}
+
+template<>
+auto my::Uniform::setData(const GLint& data) const -> void {
+  glUniform1i(_location, data);
+}
+
+template<>
+auto my::Uniform::setData(const GLuint& data) const -> void {
+  glUniform1ui(_location, data);
+}
+
+template<>
+auto my::Uniform::setData(const glm::vec2& data) const -> void {
+  glUniform2fv(_location, 1, glm::value_ptr(data));
+}
+
+template<>
+auto my::Uniform::setData(const glm::vec3& data) const -> void {
+  glUniform3fv(_location, 1, glm::value_ptr(data));
+}
+
+template<>
+auto my::Uniform::setData(const glm::vec4& data) const -> void {
+  glUniform4fv(_location, 1, glm::value_ptr(data));
+}
+
+template<>
+auto my::Uniform::setData(const glm::ivec2& data) const -> void {
+  glUniform2iv(_location, 1, glm::value_ptr(data));
+}
+
+template<>
+auto my::Uniform::setData(const glm::ivec3& data) const -> void {
+  glUniform3iv(_location, 1, glm::value_ptr(data));
+}
+
+template<>
+auto my::Uniform::setData(const glm::ivec4& data) const -> void {
+  glUniform4iv(_location, 1, glm::value_ptr(data));
+}
+
+template<>
+auto my::Uniform::setData(const glm::mat3& data) const -> void {
+  glUniformMatrix3fv(_location, 1, false, glm::value_ptr(data));
+}
+
 template<>
 auto my::Uniform::setData(const glm::mat4& data) const -> void {
   glUniformMatrix4fv(_location, 1, false, glm::value_ptr(data));
 }
 
+template<>
+auto my::Uniform::setData(const std::vector<GLfloat>& data) const -> void {
+  glUniform1fv(_location, static_cast<GLsizei>(data.size()), data.data());
+}
+
+template<>
+auto my::Uniform::setData(const std::vector<GLint>& data) const -> void {
+  glUniform1iv(_location, static_cast<GLsizei>(data.size()), data.data());
+}
+
+template<>
+auto my::Uniform::setData(const std::vector<glm::vec2>& data) const -> void {
+  glUniform2fv(
+    _location, static_cast<GLsizei>(data.size()),
+    reinterpret_cast<const GLfloat*>(data.data())
+  );
+}
+
+template<>
+auto my::Uniform::setData(const std::vector<glm::vec3>& data) const -> void {
+  glUniform3fv(
+    _location, static_cast<GLsizei>(data.size()),
+    reinterpret_cast<const GLfloat*>(data.data())
+  );
+}
+
+template<>
+auto my::Uniform::setData(const std::vector<glm::vec4>& data) const -> void {
+  glUniform4fv(
+    _location, static_cast<GLsizei>(data.size()),
+    reinterpret_cast<const GLfloat*>(data.data())
+  );
+}
+
+template<>
+auto my::Uniform::setData(const std::vector<glm::mat4>& data) const -> void {
+  glUniformMatrix4fv(
+    _location, static_cast<GLsizei>(data.size()), false,
+    reinterpret_cast<const GLfloat*>(data.data())
+  );
+}
+
+my::UniformBlock::UniformBlock(GLuint binding, GLsizeiptr size)
+: _buffer{
+    BufferTarget::Uniform, nullptr, static_cast<GLsizei>(size),
+    BufferUsage::DynamicDraw
+  },
+  _binding{binding}, _contents(static_cast<std::size_t>(size)) {
+  StateCache::current().bindBufferBase(
+    GL_UNIFORM_BUFFER, _binding, _buffer.getID()
+  );
+}
+
+#ifdef DEBUG
+auto my::operator<<(std::ostream& out, const UniformBlock& block)
+-> std::ostream& {
+  out << "UniformBlock(binding=" << block._binding;
+  out << ", size=" << block._contents.size() << ')';
+  return out;
+}
+#endif // DEBUG
+
+auto my::UniformBlock::getBinding() const -> GLuint {
+  return _binding;
+}
+
+auto my::UniformBlock::update(const GLvoid* data, GLsizeiptr size) -> bool {
+#ifdef DEBUG
+  if (size < 0 || static_cast<std::size_t>(size) > _contents.size()) {
+    throw std::runtime_error{"Attempt to overflow uniform block"};
+  }
+#endif // DEBUG
+  const auto byteCount{static_cast<std::size_t>(size)};
+  if (_uploaded && std::memcmp(_contents.data(), data, byteCount) == 0) {
+    return false;
+  }
+  std::memcpy(_contents.data(), data, byteCount);
+  _buffer.setSubData(0, data, size);
+  _uploaded = true;
+  return true;
+}
+
 my::ShaderProgram::ShaderProgram(
   const Shader& vertexShader, const Shader& fragmentShader
 ) : _id{glCreateProgram()} {
   glAttachShader(_id, vertexShader.getID());
   glAttachShader(_id, fragmentShader.getID());
+  if (GLAD_GL_ARB_get_program_binary) {
+    // Some drivers only keep what getBinary() needs when asked up front.
+    glProgramParameteri(_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
   glLinkProgram(_id);
   GLint status{};
   glGetProgramiv(_id, GL_LINK_STATUS, &status);
-#ifdef DEBUG
   if (!status) {
-    GLint logLength{};
-    std::string log{};
-
-    glGetProgramiv(_id, GL_INFO_LOG_LENGTH, &logLength);
-    log.resize(logLength);
-    glGetProgramInfoLog(_id, logLength, nullptr, log.data());
-    LOG_ERROR("GL program error: " << log << '\n');
-    log.clear();
-
-    glGetShaderiv(vertexShader.getID(), GL_INFO_LOG_LENGTH, &logLength);
-    if (logLength > 0) {
-      log.resize(logLength);
-      glGetShaderInfoLog(vertexShader.getID(), logLength, nullptr, log.data());
-      LOG_ERROR("GL vertex shader error: " << log << '\n');
-      log.clear();
-    }
-
-    glGetShaderiv(fragmentShader.getID(), GL_INFO_LOG_LENGTH, &logLength);
-    if (logLength > 0) {
-      log.resize(logLength);
-      glGetShaderInfoLog(
-        fragmentShader.getID(), logLength, nullptr, log.data()
-      );
-      LOG_ERROR("GL fragment shader error: " << log << '\n');
-      log.clear();
-    }
+    logLinkErrors(_id, vertexShader, fragmentShader);
   }
-#endif // DEBUG
   glDetachShader(_id, vertexShader.getID());
   glDetachShader(_id, fragmentShader.getID());
   if (!status) {
@@ -380,6 +560,25 @@ my::ShaderProgram::ShaderProgram(
   }
 }
 
+my::ShaderProgram::ShaderProgram(GLuint id) : _id{id} {}
+
+auto my::ShaderProgram::fromBinary(
+  GLenum format, const GLvoid* binary, GLsizei length
+) -> std::optional<ShaderProgram> {
+  if (!GLAD_GL_ARB_get_program_binary) {
+    return {};
+  }
+  const GLuint id{glCreateProgram()};
+  glProgramBinary(id, format, binary, length);
+  GLint status{};
+  glGetProgramiv(id, GL_LINK_STATUS, &status);
+  if (!status) {
+    glDeleteProgram(id);
+    return {};
+  }
+  return ShaderProgram{id};
+}
+
 my::ShaderProgram::ShaderProgram(ShaderProgram&& program)
 : _id{program._id}, _vertexArrays{std::move(program._vertexArrays)},
   _uniforms{std::move(program._uniforms)} {
@@ -389,6 +588,15 @@ my::ShaderProgram::ShaderProgram(ShaderProgram&& program)
 
 auto my::ShaderProgram::operator=(ShaderProgram&& program) -> ShaderProgram& {
   LOG_MOVE_ASSIGNING(program);
+  if (this == &program) {
+    return *this;
+  }
+  // Replacing a program, as a reload does, deletes the one it replaces.
+  if (_valid) {
+    glDeleteProgram(_id);
+    StateCache::current().onDeleteProgram(_id);
+  }
+  _valid = program._valid;
   _id = program._id;
   _vertexArrays = std::move(program._vertexArrays);
   _uniforms = std::move(program._uniforms);
@@ -402,6 +610,7 @@ my::ShaderProgram::~ShaderProgram() {
   }
   LOG_CLEANING_UP(*this);
   glDeleteProgram(_id);
+  StateCache::current().onDeleteProgram(_id);
 }
 
 #ifdef DEBUG
@@ -443,6 +652,18 @@ auto my::ShaderProgram::getUniforms() -> std::vector<Uniform>& {
   return _uniforms;
 }
 
+auto my::ShaderProgram::bindUniformBlock(
+  std::string_view name, GLuint binding
+) const -> void {
+  const GLuint index{glGetUniformBlockIndex(_id, name.data())};
+  if (index == GL_INVALID_INDEX) {
+    throw std::runtime_error{
+      "Attempt to bind invalid uniform block"
+    };
+  }
+  glUniformBlockBinding(_id, index, binding);
+}
+
 auto my::ShaderProgram::use() const -> void {
 #ifdef DEBUG
   if (!_valid) {
@@ -450,5 +671,104 @@ auto my::ShaderProgram::use() const -> void {
     throw std::runtime_error{"Attempt to use invalid shader program"};
   }
 #endif // DEBUG
-  glUseProgram(_id);
+  StateCache::current().useProgram(_id);
+}
+
+auto my::ShaderProgram::getBinary() const -> std::optional<ProgramBinary> {
+  if (!GLAD_GL_ARB_get_program_binary) {
+    return {};
+  }
+  GLint length{};
+  glGetProgramiv(_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return {};
+  }
+  ProgramBinary binary{};
+  binary.data.resize(static_cast<std::size_t>(length));
+  glGetProgramBinary(
+    _id, length, &length, &binary.format, binary.data.data()
+  );
+  binary.data.resize(static_cast<std::size_t>(length));
+  return binary;
+}
+
+my::ProgramBuild::ProgramBuild(
+  std::string_view vertexSource, std::string_view fragmentSource
+) : _vertexShader{ShaderType::Vertex, vertexSource},
+    _fragmentShader{ShaderType::Fragment, fragmentSource},
+    _id{glCreateProgram()} {
+  // Nothing here asks for a status, so nothing here waits.
+  glAttachShader(_id, _vertexShader.getID());
+  glAttachShader(_id, _fragmentShader.getID());
+  glLinkProgram(_id);
+}
+
+my::ProgramBuild::~ProgramBuild() {
+  if (!_finished) {
+    glDeleteProgram(_id);
+  }
+}
+
+auto my::ProgramBuild::isComplete() const -> bool {
+  if (!GLAD_GL_KHR_parallel_shader_compile) {
+    return true;
+  }
+  GLint complete{};
+  glGetProgramiv(_id, GL_COMPLETION_STATUS_KHR, &complete);
+  return complete;
 }
+
+auto my::ProgramBuild::finish() -> std::optional<ShaderProgram> {
+  if (_finished) {
+    return {};
+  }
+  _finished = true;
+  GLint status{};
+  glGetProgramiv(_id, GL_LINK_STATUS, &status);
+  if (!status) {
+    logLinkErrors(_id, _vertexShader, _fragmentShader);
+  }
+  glDetachShader(_id, _vertexShader.getID());
+  glDetachShader(_id, _fragmentShader.getID());
+  if (!status) {
+    glDeleteProgram(_id);
+    return {};
+  }
+  return ShaderProgram{_id};
+}
+
+namespace {
+
+auto logLinkErrors(
+  GLuint program, const my::Shader& vertexShader,
+  const my::Shader& fragmentShader
+) -> void {
+  GLint logLength{};
+  std::string log{};
+
+  glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+  log.resize(logLength);
+  glGetProgramInfoLog(program, logLength, nullptr, log.data());
+  LOG_ERROR("GL program error: {}", log);
+  log.clear();
+
+  glGetShaderiv(vertexShader.getID(), GL_INFO_LOG_LENGTH, &logLength);
+  if (logLength > 0) {
+    log.resize(logLength);
+    glGetShaderInfoLog(vertexShader.getID(), logLength, nullptr, log.data());
+    LOG_ERROR("GL vertex shader error: {}", log);
+    log.clear();
+  }
+
+  glGetShaderiv(fragmentShader.getID(), GL_INFO_LOG_LENGTH, &logLength);
+  if (logLength > 0) {
+    log.resize(logLength);
+    glGetShaderInfoLog(
+      fragmentShader.getID(), logLength, nullptr, log.data()
+    );
+    LOG_ERROR("GL fragment shader error: {}", log);
+    log.clear();
+  }
+}
+
+} // namespace
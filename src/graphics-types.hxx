@@ -1,15 +1,19 @@
 #ifndef GRAPHICS_TYPES_HXX
 #define GRAPHICS_TYPES_HXX
 
+#include <array>
 #include <cstddef>
+#include <optional>
 #ifdef DEBUG
 #include <iostream>
 #include <stdexcept>
 #endif // DEBUG
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include <glad/gl.h>
+#include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 /*
@@ -23,11 +27,14 @@ class ShaderProgram;
 enum class BufferTarget {
   Array = GL_ARRAY_BUFFER,
   ElementArray = GL_ELEMENT_ARRAY_BUFFER,
+  Uniform = GL_UNIFORM_BUFFER,
   /* ... */
 };
 
 enum class BufferUsage {
   StaticDraw = GL_STATIC_DRAW,
+  DynamicDraw = GL_DYNAMIC_DRAW,
+  StreamDraw = GL_STREAM_DRAW,
   /* ... */
 };
 
@@ -50,9 +57,13 @@ public:
   auto getID() const -> GLuint;
   auto bind() const -> void;
   auto unbind() const -> void;
+  auto setData(const GLvoid* data, GLsizeiptr size) -> void;
+  auto setSubData(GLintptr offset, const GLvoid* data, GLsizeiptr size)
+  -> void;
 
 private:
   BufferTarget _target;
+  BufferUsage _usage;
   GLuint _id{};
   bool _valid{true};
 };
@@ -68,54 +79,100 @@ enum class AttributeType {
   UnsignedShort = GL_UNSIGNED_SHORT,
   Int = GL_INT,
   UnsignedInt = GL_UNSIGNED_INT,
+  HalfFloat = GL_HALF_FLOAT,
   Float = GL_FLOAT,
   Double = GL_DOUBLE,
+  // Four components packed into 32 bits, w in the top two.
+  Int2101010Rev = GL_INT_2_10_10_10_REV,
+  UnsignedInt2101010Rev = GL_UNSIGNED_INT_2_10_10_10_REV,
   /* ... */
 };
 
-struct ShaderAttribute {
-  std::string_view name{};
-  const Buffer& buffer;
+enum class IndexType {
+  UnsignedShort = GL_UNSIGNED_SHORT,
+  UnsignedInt = GL_UNSIGNED_INT,
+};
+
+// Locations of the vertex shader inputs. Shaders declare their inputs
+// with matching layout(location = ...) qualifiers, so vertex arrays can
+// be built without asking any program where its attributes are.
+enum class AttributeLocation : GLuint {
+  Position = 0,
+  Color = 1,
+  Normal = 2,
+  // Four locations, one per column.
+  Model = 3,
+  /* ... */
+};
+
+struct VertexAttribute {
+  AttributeLocation location{};
   GLint size{};
   AttributeType type{};
   GLboolean normalized{};
-  GLsizei stride{};
-  const GLvoid* pointer{};
-
-  ShaderAttribute(
-    std::string_view name, const Buffer& buffer, GLint size, AttributeType type,
-    GLboolean normalized, GLint stride, const GLvoid* pointer
-  );
-  ShaderAttribute() = delete;
+  // Matrix attributes occupy one location per column, each column being
+  // `size` components wide.
+  GLint columns{1};
+  // In bytes from the start of the vertex; see layoutAttributes().
+  std::size_t offset{};
 };
 
+// Offsets of interleaved attributes are rounded up to this, which some
+// drivers need to fetch them without a slow path.
+constexpr std::size_t attributeAlignment{4};
+
+constexpr auto getAttributeColumnSize(AttributeType type, GLint size)
+-> std::size_t;
+constexpr auto getAttributeSize(const VertexAttribute& attribute)
+-> std::size_t;
+// Assigns the attributes consecutive aligned offsets, in order.
+template<std::size_t N>
+constexpr auto layoutAttributes(std::array<VertexAttribute, N> attributes)
+-> std::array<VertexAttribute, N>;
+template<std::size_t N>
+constexpr auto getLayoutSize(const std::array<VertexAttribute, N>& attributes)
+-> std::size_t;
+
+// Describes a vertex struct to GL. Specializations provide a constexpr
+// std::array<VertexAttribute, N> named `attributes`, usually built with
+// layoutAttributes() and checked against the struct with static_assert.
+template<typename Vertex>
+struct VertexLayout;
+
 class VertexArray;
 
 class VertexArrayBuilder {
 public:
-  VertexArrayBuilder(ShaderProgram& program);
-  VertexArrayBuilder() = delete;
+  VertexArrayBuilder() = default;
   VertexArrayBuilder(const VertexArrayBuilder&) = delete;
   VertexArrayBuilder(VertexArrayBuilder&&) = delete;
   auto operator=(const VertexArrayBuilder&) = delete;
   auto operator=(VertexArrayBuilder&&) = delete;
-  friend auto operator<<(VertexArrayBuilder&, ShaderAttribute*)
-  -> VertexArrayBuilder&;
-  friend auto operator<<(VertexArrayBuilder&, Buffer*)
+  friend auto operator<<(VertexArrayBuilder&, const Buffer*)
   -> VertexArrayBuilder&;
   auto setIndexCount(GLint indexCount) -> void;
+  // Sources the attributes of VertexLayout<Vertex> from buffer, which
+  // holds an array of Vertex. A non-zero divisor advances them once per
+  // that many instances instead of once per vertex.
+  template<typename Vertex>
+  auto addVertexBuffer(const Buffer& buffer, GLuint divisor = 0) -> void;
   auto build() -> VertexArray;
 
 private:
-  ShaderProgram& _program;
-  std::vector<ShaderAttribute*> _attributes{};
-  Buffer* _indexBuffer{nullptr};
+  struct VertexBinding {
+    const Buffer* buffer{};
+    const VertexAttribute* attributes{};
+    std::size_t attributeCount{};
+    GLsizei stride{};
+    GLuint divisor{};
+  };
+
+  std::vector<VertexBinding> _bindings{};
+  const Buffer* _indexBuffer{nullptr};
   GLint _indexCount{-1};
 };
 
-auto operator<<(VertexArrayBuilder& builder, ShaderAttribute* attribute)
--> VertexArrayBuilder&;
-auto operator<<(VertexArrayBuilder& builder, Buffer* buffer)
+auto operator<<(VertexArrayBuilder& builder, const Buffer* buffer)
 -> VertexArrayBuilder&;
 
 class VertexArray {
@@ -135,6 +192,23 @@ public:
   auto bind() const -> void;
   auto unbind() const -> void;
   auto drawTriangles() const -> void;
+  auto drawTrianglesInstanced(GLsizei instanceCount) const -> void;
+  // Range variants for vertex arrays that hold several meshes in shared
+  // buffers; indexOffset is in bytes. Every mesh in a multi-draw has to
+  // use the same index type.
+  auto drawTriangles(
+    IndexType indexType, GLsizei indexCount, GLsizeiptr indexOffset,
+    GLint baseVertex
+  ) const -> void;
+  auto drawTrianglesInstanced(
+    IndexType indexType, GLsizei indexCount, GLsizeiptr indexOffset,
+    GLint baseVertex, GLsizei instanceCount
+  ) const -> void;
+  auto multiDrawTriangles(
+    IndexType indexType, const GLsizei* indexCounts,
+    const GLvoid* const* indexOffsets, const GLint* baseVertices,
+    GLsizei drawCount
+  ) const -> void;
 
 private:
   GLuint _id{};
@@ -198,16 +272,89 @@ private:
   bool _valid{true};
 };
 
+template<>
+auto Uniform::setData(const GLfloat& data) const -> void;
+template<>
+auto Uniform::setData(const GLint& data) const -> void;
+template<>
+auto Uniform::setData(const GLuint& data) const -> void;
+template<>
+auto Uniform::setData(const glm::vec2& data) const -> void;
+template<>
+auto Uniform::setData(const glm::vec3& data) const -> void;
+template<>
+auto Uniform::setData(const glm::vec4& data) const -> void;
+template<>
+auto Uniform::setData(const glm::ivec2& data) const -> void;
+template<>
+auto Uniform::setData(const glm::ivec3& data) const -> void;
+template<>
+auto Uniform::setData(const glm::ivec4& data) const -> void;
+template<>
+auto Uniform::setData(const glm::mat3& data) const -> void;
 template<>
 auto Uniform::setData(const glm::mat4& data) const -> void;
+template<>
+auto Uniform::setData(const std::vector<GLfloat>& data) const -> void;
+template<>
+auto Uniform::setData(const std::vector<GLint>& data) const -> void;
+template<>
+auto Uniform::setData(const std::vector<glm::vec2>& data) const -> void;
+template<>
+auto Uniform::setData(const std::vector<glm::vec3>& data) const -> void;
+template<>
+auto Uniform::setData(const std::vector<glm::vec4>& data) const -> void;
+template<>
+auto Uniform::setData(const std::vector<glm::mat4>& data) const -> void;
 
 #ifdef DEBUG
 auto operator<<(std::ostream& out, const Uniform& uniform) -> std::ostream&;
 #endif // DEBUG
 
+// A std140 uniform block's storage, attached to a fixed binding point so
+// every program that binds its block there shares it. Keeps a copy of
+// the last upload and skips uploads of identical data.
+class UniformBlock {
+public:
+  UniformBlock(GLuint binding, GLsizeiptr size);
+  UniformBlock() = delete;
+  UniformBlock(const UniformBlock&) = delete;
+  UniformBlock(UniformBlock&& block) = default;
+  auto operator=(const UniformBlock&) -> UniformBlock& = delete;
+  auto operator=(UniformBlock&& block) -> UniformBlock& = default;
+  ~UniformBlock() noexcept = default;
+#ifdef DEBUG
+  friend auto operator<<(std::ostream&, const UniformBlock&) -> std::ostream&;
+#endif // DEBUG
+  auto getBinding() const -> GLuint;
+  auto update(const GLvoid* data, GLsizeiptr size) -> bool;
+  template<typename T>
+  auto setData(const T& data) -> bool;
+
+private:
+  Buffer _buffer;
+  GLuint _binding;
+  std::vector<unsigned char> _contents;
+  bool _uploaded{false};
+};
+
+#ifdef DEBUG
+auto operator<<(std::ostream& out, const UniformBlock& block) -> std::ostream&;
+#endif // DEBUG
+
+// A linked program as the driver stores it; only the same driver, at the
+// same version, can be expected to take it back.
+struct ProgramBinary {
+  GLenum format{};
+  std::vector<std::byte> data{};
+};
+
 class ShaderProgram {
 public:
   ShaderProgram(const Shader& vertex, const Shader& fragment);
+  // Fails if the driver no longer accepts the binary, as after an update.
+  static auto fromBinary(GLenum format, const GLvoid* binary, GLsizei length)
+  -> std::optional<ShaderProgram>;
   ShaderProgram() = delete;
   ShaderProgram(const ShaderProgram&) = delete;
   ShaderProgram(ShaderProgram&& program);
@@ -224,14 +371,21 @@ public:
   auto getVertexArrays() -> std::vector<VertexArray>&;
   auto getUniforms() const -> const std::vector<Uniform>&;
   auto getUniforms() -> std::vector<Uniform>&;
+  auto bindUniformBlock(std::string_view name, GLuint binding) const -> void;
   auto use() const -> void;
+  // Needs GL_ARB_get_program_binary; empty if the driver has no formats.
+  auto getBinary() const -> std::optional<ProgramBinary>;
 
 private:
   GLuint _id;
-  VertexArrayBuilder _vertexArrayBuilder{*this};
+  VertexArrayBuilder _vertexArrayBuilder{};
   std::vector<VertexArray> _vertexArrays{};
   std::vector<Uniform> _uniforms{};
   bool _valid{true};
+
+  ShaderProgram(GLuint id);
+
+  friend class ProgramBuild;
 };
 
 #ifdef DEBUG
@@ -239,19 +393,124 @@ auto operator<<(std::ostream& out, const ShaderProgram& program)
 -> std::ostream&;
 #endif // DEBUG
 
+// A program compiled and linked without waiting on it. With
+// GL_KHR_parallel_shader_compile the driver does the work on its own
+// threads and isComplete() says when it is done; without, it is always
+// complete, and finish() waits for whatever the driver has deferred.
+class ProgramBuild {
+public:
+  ProgramBuild(std::string_view vertexSource, std::string_view fragmentSource);
+  ProgramBuild() = delete;
+  ProgramBuild(const ProgramBuild&) = delete;
+  ProgramBuild(ProgramBuild&&) = delete;
+  auto operator=(const ProgramBuild&) -> ProgramBuild& = delete;
+  auto operator=(ProgramBuild&&) -> ProgramBuild& = delete;
+  ~ProgramBuild() noexcept;
+
+  auto isComplete() const -> bool;
+  // Empty if either shader failed to compile or the program to link.
+  // Only the first call returns the program.
+  auto finish() -> std::optional<ShaderProgram>;
+
+private:
+  Shader _vertexShader;
+  Shader _fragmentShader;
+  GLuint _id;
+  bool _finished{};
+};
+
 } // namespace my
 
 /*
  * Definitions.
  */
 
+constexpr auto my::getAttributeColumnSize(AttributeType type, GLint size)
+-> std::size_t {
+  const auto components{static_cast<std::size_t>(size)};
+  switch (type) {
+    case AttributeType::Byte:
+    case AttributeType::UnsignedByte: {
+      return components;
+    }
+    case AttributeType::Short:
+    case AttributeType::UnsignedShort:
+    case AttributeType::HalfFloat: {
+      return 2*components;
+    }
+    case AttributeType::Int:
+    case AttributeType::UnsignedInt:
+    case AttributeType::Float: {
+      return 4*components;
+    }
+    case AttributeType::Double: {
+      return 8*components;
+    }
+    // All four components share one 32-bit word.
+    case AttributeType::Int2101010Rev:
+    case AttributeType::UnsignedInt2101010Rev: {
+      return 4;
+    }
+    default: {
+      return 0;
+    }
+  }
+}
+
+constexpr auto my::getAttributeSize(const VertexAttribute& attribute)
+-> std::size_t {
+  return getAttributeColumnSize(attribute.type, attribute.size)
+    *static_cast<std::size_t>(attribute.columns);
+}
+
+template<std::size_t N>
+constexpr auto my::layoutAttributes(std::array<VertexAttribute, N> attributes)
+-> std::array<VertexAttribute, N> {
+  std::size_t offset{};
+  for (auto& attribute : attributes) {
+    attribute.offset = offset;
+    offset += (getAttributeSize(attribute) + attributeAlignment - 1)
+      / attributeAlignment*attributeAlignment;
+  }
+  return attributes;
+}
+
+template<std::size_t N>
+constexpr auto my::getLayoutSize(
+  const std::array<VertexAttribute, N>& attributes
+) -> std::size_t {
+  if constexpr (N == 0) {
+    return 0;
+  } else {
+    const VertexAttribute& last{attributes[N - 1]};
+    return (last.offset + getAttributeSize(last) + attributeAlignment - 1)
+      / attributeAlignment*attributeAlignment;
+  }
+}
+
+template<typename Vertex>
+auto my::VertexArrayBuilder::addVertexBuffer(
+  const Buffer& buffer, GLuint divisor
+) -> void {
+  constexpr auto& attributes{VertexLayout<Vertex>::attributes};
+  static_assert(getLayoutSize(attributes) <= sizeof(Vertex));
+  _bindings.push_back({
+    &buffer, attributes.data(), attributes.size(),
+    static_cast<GLsizei>(sizeof(Vertex)), divisor
+  });
+}
+
 template<typename T>
 auto my::Uniform::setData(const T&) const -> void {
-#ifdef DEBUG
-  throw std::runtime_error{
-    "Attempt to set unimplemented data type on uniform"
-  };
-#endif // DEBUG
+  static_assert(
+    !std::is_same_v<T, T>, "Attempt to set unimplemented data type on uniform"
+  );
+}
+
+template<typename T>
+auto my::UniformBlock::setData(const T& data) -> bool {
+  static_assert(std::is_trivially_copyable_v<T>);
+  return update(&data, sizeof(T));
 }
 
 #endif // GRAPHICS_TYPES_HXX
@@ -0,0 +1,330 @@
+#include "index-optimizer.hxx"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// FIFO post-transform cache, kept as the time each vertex went in.
+class VertexCache {
+public:
+  VertexCache(std::size_t vertexCount);
+
+  // True if the vertex had to be transformed.
+  auto access(GLuint vertex) -> bool;
+  auto isCached(GLuint vertex) const -> bool;
+  auto getAge(GLuint vertex) const -> std::size_t;
+  auto flush() -> void;
+
+private:
+  std::vector<std::size_t> _times;
+  // Starts past the cache size so that nothing is cached at first.
+  std::size_t _time{my::vertexCacheSize + 1};
+};
+
+// Triangles around each vertex, packed one vertex after another.
+struct Adjacency {
+  std::vector<std::size_t> offsets{};
+  std::vector<std::uint32_t> triangles{};
+
+  Adjacency(const std::vector<GLuint>& indices, std::size_t vertexCount);
+};
+
+struct Cluster {
+  std::size_t first{};
+  std::size_t last{};
+  float sortKey{};
+};
+
+auto findClusters(
+  const std::vector<GLuint>& indices, std::size_t vertexCount,
+  float threshold
+) -> std::vector<Cluster>;
+auto getPosition(const GLfloat* positions, GLuint vertex) -> glm::vec3;
+
+constexpr auto noVertex{std::numeric_limits<GLuint>::max()};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::countVertexTransforms(
+  const GLuint* indices, std::size_t indexCount, std::size_t vertexCount
+) -> std::size_t {
+  VertexCache cache{vertexCount};
+  std::size_t transforms{};
+  for (std::size_t i{}; i < indexCount; i++) {
+    if (cache.access(indices[i])) {
+      transforms++;
+    }
+  }
+  return transforms;
+}
+
+auto my::optimizeVertexCache(
+  std::vector<GLuint>& indices, std::size_t vertexCount
+) -> void {
+  const std::size_t triangleCount{indices.size()/3};
+  const Adjacency adjacency{indices, vertexCount};
+  std::vector<std::uint32_t> liveTriangles(vertexCount);
+  for (std::size_t vertex{}; vertex < vertexCount; vertex++) {
+    liveTriangles[vertex] = static_cast<std::uint32_t>(
+      adjacency.offsets[vertex + 1] - adjacency.offsets[vertex]
+    );
+  }
+  std::vector<bool> emitted(triangleCount);
+  VertexCache cache{vertexCount};
+  // Recently used vertices, to pick up from when a fan runs dry.
+  std::vector<GLuint> deadEnds{};
+  std::vector<GLuint> candidates{};
+  std::vector<GLuint> ordered{};
+  ordered.reserve(triangleCount*3);
+  GLuint scan{};
+
+  const auto nextLive{[&]() -> GLuint {
+    while (!deadEnds.empty()) {
+      const GLuint vertex{deadEnds.back()};
+      deadEnds.pop_back();
+      if (liveTriangles[vertex] > 0) {
+        return vertex;
+      }
+    }
+    for (; scan < vertexCount; scan++) {
+      if (liveTriangles[scan] > 0) {
+        return scan;
+      }
+    }
+    return noVertex;
+  }};
+
+  GLuint fan{nextLive()};
+  while (fan != noVertex) {
+    candidates.clear();
+    for (
+      std::size_t i{adjacency.offsets[fan]}; i < adjacency.offsets[fan + 1];
+      i++
+    ) {
+      const std::uint32_t triangle{adjacency.triangles[i]};
+      if (emitted[triangle]) {
+        continue;
+      }
+      emitted[triangle] = true;
+      for (std::size_t corner{}; corner < 3; corner++) {
+        const GLuint vertex{indices[triangle*3 + corner]};
+        ordered.push_back(vertex);
+        deadEnds.push_back(vertex);
+        candidates.push_back(vertex);
+        liveTriangles[vertex]--;
+        cache.access(vertex);
+      }
+    }
+    // The best next fan is the oldest neighbor whose remaining triangles
+    // can be drawn before it leaves the cache.
+    fan = noVertex;
+    std::size_t bestAge{};
+    for (const auto vertex : candidates) {
+      if (liveTriangles[vertex] == 0) {
+        continue;
+      }
+      std::size_t age{};
+      if (
+        cache.isCached(vertex)
+        && cache.getAge(vertex) + 2*liveTriangles[vertex] <= vertexCacheSize
+      ) {
+        age = cache.getAge(vertex);
+      }
+      if (fan == noVertex || age > bestAge) {
+        fan = vertex;
+        bestAge = age;
+      }
+    }
+    if (fan == noVertex) {
+      fan = nextLive();
+    }
+  }
+  indices = std::move(ordered);
+}
+
+auto my::optimizeOverdraw(
+  std::vector<GLuint>& indices, const GLfloat* positions,
+  std::size_t vertexCount, float threshold
+) -> void {
+  std::vector<Cluster> clusters{findClusters(indices, vertexCount, threshold)};
+  if (clusters.size() < 2) {
+    return;
+  }
+  glm::vec3 meshCenter{};
+  for (const auto index : indices) {
+    meshCenter += getPosition(positions, index);
+  }
+  meshCenter /= static_cast<float>(indices.size());
+  for (auto& cluster : clusters) {
+    // Area-weighted, since cross products are twice the triangle area.
+    glm::vec3 center{};
+    glm::vec3 normal{};
+    float area{};
+    for (std::size_t i{cluster.first*3}; i < cluster.last*3; i += 3) {
+      const glm::vec3 a{getPosition(positions, indices[i])};
+      const glm::vec3 b{getPosition(positions, indices[i + 1])};
+      const glm::vec3 c{getPosition(positions, indices[i + 2])};
+      const glm::vec3 face{glm::cross(b - a, c - a)};
+      const float faceArea{glm::length(face)};
+      center += (a + b + c)*(faceArea/3.f);
+      normal += face;
+      area += faceArea;
+    }
+    const float normalLength{glm::length(normal)};
+    if (area > 0.f && normalLength > 0.f) {
+      cluster.sortKey =
+        glm::dot(center/area - meshCenter, normal/normalLength);
+    }
+  }
+  std::stable_sort(
+    clusters.begin(), clusters.end(),
+    [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; }
+  );
+  std::vector<GLuint> ordered{};
+  ordered.reserve(indices.size());
+  for (const auto& cluster : clusters) {
+    ordered.insert(
+      ordered.end(),
+      indices.begin() + static_cast<std::ptrdiff_t>(cluster.first*3),
+      indices.begin() + static_cast<std::ptrdiff_t>(cluster.last*3)
+    );
+  }
+  indices = std::move(ordered);
+}
+
+auto my::optimizeVertexFetch(
+  std::vector<GLuint>& indices, std::size_t vertexCount
+) -> std::vector<GLuint> {
+  std::vector<GLuint> remap(vertexCount, noVertex);
+  GLuint next{};
+  for (auto& index : indices) {
+    if (remap[index] == noVertex) {
+      remap[index] = next++;
+    }
+    index = remap[index];
+  }
+  for (auto& vertex : remap) {
+    if (vertex == noVertex) {
+      vertex = next++;
+    }
+  }
+  return remap;
+}
+
+namespace {
+
+VertexCache::VertexCache(std::size_t vertexCount) : _times(vertexCount) {}
+
+auto VertexCache::access(GLuint vertex) -> bool {
+  if (isCached(vertex)) {
+    return false;
+  }
+  _times[vertex] = _time++;
+  return true;
+}
+
+auto VertexCache::isCached(GLuint vertex) const -> bool {
+  return getAge(vertex) <= my::vertexCacheSize;
+}
+
+auto VertexCache::getAge(GLuint vertex) const -> std::size_t {
+  return _time - _times[vertex];
+}
+
+auto VertexCache::flush() -> void {
+  _time += my::vertexCacheSize + 1;
+}
+
+Adjacency::Adjacency(
+  const std::vector<GLuint>& indices, std::size_t vertexCount
+) : offsets(vertexCount + 1), triangles(indices.size()) {
+  for (const auto index : indices) {
+    offsets[index + 1]++;
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+  for (std::size_t i{}; i < indices.size(); i++) {
+    triangles[next[indices[i]]++] = static_cast<std::uint32_t>(i/3);
+  }
+}
+
+auto findClusters(
+  const std::vector<GLuint>& indices, std::size_t vertexCount,
+  float threshold
+) -> std::vector<Cluster> {
+  const std::size_t triangleCount{indices.size()/3};
+  // Hard boundaries: triangles none of whose vertices are still cached.
+  std::vector<std::size_t> starts{};
+  VertexCache cache{vertexCount};
+  for (std::size_t triangle{}; triangle < triangleCount; triangle++) {
+    std::size_t misses{};
+    for (std::size_t corner{}; corner < 3; corner++) {
+      if (cache.access(indices[triangle*3 + corner])) {
+        misses++;
+      }
+    }
+    if (misses == 3 || triangle == 0) {
+      starts.push_back(triangle);
+    }
+  }
+  starts.push_back(triangleCount);
+  const double limit{
+    static_cast<double>(my::countVertexTransforms(
+      indices.data(), indices.size(), vertexCount
+    ))
+      /static_cast<double>(std::max<std::size_t>(triangleCount, 1))
+      *threshold
+  };
+
+  // Soft boundaries: wherever the run since the last boundary has done
+  // as well as the whole mesh, a new one can start cold without raising
+  // the miss ratio much.
+  std::vector<Cluster> clusters{};
+  for (std::size_t hard{}; hard + 1 < starts.size(); hard++) {
+    std::size_t first{starts[hard]};
+    std::size_t misses{};
+    cache.flush();
+    for (std::size_t triangle{first}; triangle < starts[hard + 1]; triangle++) {
+      for (std::size_t corner{}; corner < 3; corner++) {
+        if (cache.access(indices[triangle*3 + corner])) {
+          misses++;
+        }
+      }
+      const auto triangles{static_cast<double>(triangle + 1 - first)};
+      if (
+        triangle + 1 < starts[hard + 1]
+        && static_cast<double>(misses)/triangles <= limit
+      ) {
+        clusters.push_back({first, triangle + 1});
+        first = triangle + 1;
+        misses = 0;
+        cache.flush();
+      }
+    }
+    clusters.push_back({first, starts[hard + 1]});
+  }
+  return clusters;
+}
+
+auto getPosition(const GLfloat* positions, GLuint vertex) -> glm::vec3 {
+  return {
+    positions[vertex*3], positions[vertex*3 + 1], positions[vertex*3 + 2]
+  };
+}
+
+} // namespace
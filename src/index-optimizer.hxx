@@ -0,0 +1,48 @@
+#ifndef INDEX_OPTIMIZER_HXX
+#define INDEX_OPTIMIZER_HXX
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Entries in the simulated post-transform vertex cache. Real caches are
+// at least this big; ordering for a smaller one than there is costs
+// little, while ordering for a bigger one falls apart.
+constexpr std::size_t vertexCacheSize{16};
+
+// Vertices a FIFO cache of vertexCacheSize entries transforms to draw
+// the triangles. Divided by the triangle count, this is the average
+// cache miss ratio (ACMR): 3 at worst, approaching .5 for a large grid.
+auto countVertexTransforms(
+  const GLuint* indices, std::size_t indexCount, std::size_t vertexCount
+) -> std::size_t;
+// Reorders triangles so vertices get reused while they are still cached
+// (Tipsify, by Sander, Nehab and Barczak): fans around one vertex at a
+// time, moving on to a neighbor that will still be in the cache.
+auto optimizeVertexCache(std::vector<GLuint>& indices, std::size_t vertexCount)
+-> void;
+// Reorders clusters of triangles from optimizeVertexCache() so that
+// those facing away from the middle of the mesh, which are the likeliest
+// to hide the rest from any direction, are drawn first. Clusters start
+// where the cache goes cold, and where a run is going well enough that
+// splitting it costs at most `threshold` times the mesh's ACMR.
+auto optimizeOverdraw(
+  std::vector<GLuint>& indices, const GLfloat* positions,
+  std::size_t vertexCount, float threshold = 1.05f
+) -> void;
+// Renumbers vertices in the order the indices first use them, so that
+// fetches walk the vertex buffer forwards. Returns the new number of
+// each vertex; unused vertices go last.
+auto optimizeVertexFetch(std::vector<GLuint>& indices, std::size_t vertexCount)
+-> std::vector<GLuint>;
+
+} // namespace my
+
+#endif // INDEX_OPTIMIZER_HXX
@@ -1,31 +1,294 @@
 #include "io.hxx"
 
+#include <algorithm>
+#include <cerrno>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <utility>
 
-#include "debug.hxx"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "logger.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto readWholeFile(std::string_view filePath) -> std::optional<std::string>;
+auto mapFile(std::string_view filePath)
+-> std::optional<std::pair<const std::byte*, std::size_t>>;
+auto unmapFile(const std::byte* data, std::size_t size) -> void;
+
+// What unsized files are first read into; doubled as they run over.
+constexpr std::size_t readChunkSize{1 << 16};
+
+} // namespace
 
 /*
  * Definitions.
  */
 
 auto my::readFile(std::string_view filePath) -> std::optional<std::string> {
-  if (!std::filesystem::exists(filePath)) {
-    LOG_ERROR("File does not exist: " << filePath << '\n');
+  std::optional<std::string> contents{readWholeFile(filePath)};
+  if (!contents) {
+    LOG_ERROR("Failed to read file: {}", filePath);
+  }
+  return contents;
+}
+
+auto my::writeFile(
+  std::string_view filePath, const void* data, std::size_t size
+) -> bool {
+  const std::string path{filePath};
+  const std::string temporaryPath{path + ".tmp"};
+  std::ofstream out{temporaryPath, std::ios::binary | std::ios::trunc};
+  out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+  out.close();
+  if (!out) {
+    LOG_ERROR("Failed to write file: {}", temporaryPath);
+    return false;
+  }
+  std::error_code error{};
+  std::filesystem::rename(temporaryPath, path, error);
+  if (error) {
+    LOG_ERROR("Failed to replace file: {}", filePath);
+    std::filesystem::remove(temporaryPath, error);
+    return false;
+  }
+  return true;
+}
+
+auto my::readFilesAsync(
+  ThreadPool& pool, const std::vector<std::string>& filePaths
+) -> std::vector<std::future<std::optional<std::string>>> {
+  std::vector<std::future<std::optional<std::string>>> contents{};
+  contents.reserve(filePaths.size());
+  for (const auto& filePath : filePaths) {
+    contents.push_back(pool.submit([filePath]() {
+      return my::readFile(filePath);
+    }));
+  }
+  return contents;
+}
+
+auto my::MappedFile::open(std::string_view filePath)
+-> std::optional<MappedFile> {
+  const auto mapping{mapFile(filePath)};
+  if (!mapping) {
+    LOG_ERROR("Failed to map file: {}", filePath);
     return {};
   }
-  try {
-    std::ifstream streamIn{filePath.data()};
-    std::ostringstream streamOut{};
-    std::string lineBuffer{};
-    while (std::getline(streamIn, lineBuffer)) {
-      streamOut << lineBuffer << '\n';
+  return MappedFile{mapping->first, mapping->second};
+}
+
+my::MappedFile::MappedFile(const std::byte* data, std::size_t size)
+: _data{data}, _size{size} {}
+
+my::MappedFile::MappedFile(MappedFile&& file)
+: _data{std::exchange(file._data, nullptr)},
+  _size{std::exchange(file._size, 0)} {}
+
+auto my::MappedFile::operator=(MappedFile&& file) -> MappedFile& {
+  if (this != &file) {
+    unmap();
+    _data = std::exchange(file._data, nullptr);
+    _size = std::exchange(file._size, 0);
+  }
+  return *this;
+}
+
+my::MappedFile::~MappedFile() {
+  unmap();
+}
+
+auto my::MappedFile::getData() const -> const std::byte* {
+  return _data;
+}
+
+auto my::MappedFile::getSize() const -> std::size_t {
+  return _size;
+}
+
+auto my::MappedFile::unmap() -> void {
+  if (_data) {
+    unmapFile(_data, _size);
+    _data = nullptr;
+    _size = 0;
+  }
+}
+
+namespace {
+
+#ifdef _WIN32
+
+auto readWholeFile(std::string_view filePath) -> std::optional<std::string> {
+  const std::string path{filePath};
+  const HANDLE file{CreateFileA(
+    path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+  )};
+  if (file == INVALID_HANDLE_VALUE) {
+    return {};
+  }
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return {};
+  }
+  std::string contents(static_cast<std::size_t>(size.QuadPart), '\0');
+  std::size_t offset{};
+  while (offset < contents.size()) {
+    // ReadFile() takes at most 4 GB at a time.
+    const auto request{static_cast<DWORD>(
+      std::min<std::size_t>(contents.size() - offset, 0xffffffffu)
+    )};
+    DWORD count{};
+    if (!ReadFile(file, contents.data() + offset, request, &count, nullptr)) {
+      CloseHandle(file);
+      return {};
+    }
+    if (count == 0) {
+      break;
+    }
+    offset += count;
+  }
+  CloseHandle(file);
+  contents.resize(offset);
+  return contents;
+}
+
+auto mapFile(std::string_view filePath)
+-> std::optional<std::pair<const std::byte*, std::size_t>> {
+  const std::string path{filePath};
+  const HANDLE file{CreateFileA(
+    path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, nullptr
+  )};
+  if (file == INVALID_HANDLE_VALUE) {
+    return {};
+  }
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return {};
+  }
+  if (size.QuadPart == 0) {
+    // Empty files can't be mapped; there is nothing to view anyway.
+    CloseHandle(file);
+    return std::pair<const std::byte*, std::size_t>{nullptr, 0};
+  }
+  // The view keeps the mapping alive, so both handles can go right away.
+  const HANDLE mapping{
+    CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+  };
+  CloseHandle(file);
+  if (!mapping) {
+    return {};
+  }
+  const void* data{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+  CloseHandle(mapping);
+  if (!data) {
+    return {};
+  }
+  return std::pair{
+    static_cast<const std::byte*>(data),
+    static_cast<std::size_t>(size.QuadPart)
+  };
+}
+
+auto unmapFile(const std::byte* data, std::size_t) -> void {
+  UnmapViewOfFile(data);
+}
+
+#else
+
+auto readWholeFile(std::string_view filePath) -> std::optional<std::string> {
+  const std::string path{filePath};
+  const int file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (file < 0) {
+    return {};
+  }
+  struct stat status{};
+  if (fstat(file, &status) != 0) {
+    close(file);
+    return {};
+  }
+  // A regular file is read into a string of its size with one read(),
+  // short reads aside. Pipes and the like, and files that say they are
+  // empty without being so, are read until the end in growing chunks.
+  const bool sized{S_ISREG(status.st_mode) && status.st_size > 0};
+  std::string contents(
+    sized ? static_cast<std::size_t>(status.st_size) : readChunkSize, '\0'
+  );
+  std::size_t size{};
+  while (true) {
+    const ssize_t count{
+      ::read(file, contents.data() + size, contents.size() - size)
+    };
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(file);
+      return {};
     }
-    return streamOut.str();
-  } catch (const std::exception& ex) {
-    LOG_ERROR("Error reading from file: " << filePath << '\n');
-    LOG_ERROR("Caught error: " << ex.what() << '\n');
+    size += static_cast<std::size_t>(count);
+    if (count == 0 || (sized && size == contents.size())) {
+      break;
+    }
+    if (size == contents.size()) {
+      contents.resize(size*2);
+    }
+  }
+  close(file);
+  contents.resize(size);
+  return contents;
+}
+
+auto mapFile(std::string_view filePath)
+-> std::optional<std::pair<const std::byte*, std::size_t>> {
+  const std::string path{filePath};
+  const int file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (file < 0) {
     return {};
   }
+  struct stat status{};
+  if (fstat(file, &status) != 0) {
+    close(file);
+    return {};
+  }
+  const auto size{static_cast<std::size_t>(status.st_size)};
+  if (size == 0) {
+    // Empty files can't be mapped; there is nothing to view anyway.
+    close(file);
+    return std::pair<const std::byte*, std::size_t>{nullptr, 0};
+  }
+  // The mapping holds its own reference to the file.
+  void* data{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0)};
+  close(file);
+  if (data == MAP_FAILED) {
+    return {};
+  }
+  // Start reading ahead now rather than a page fault at a time.
+  madvise(data, size, MADV_WILLNEED);
+  return std::pair{static_cast<const std::byte*>(data), size};
 }
+
+auto unmapFile(const std::byte* data, std::size_t size) -> void {
+  munmap(const_cast<std::byte*>(data), size);
+}
+
+#endif // _WIN32
+
+} // namespace
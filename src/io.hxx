@@ -1,9 +1,13 @@
 #ifndef IO_HXX
 #define IO_HXX
 
+#include <cstddef>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include "thread-pool.hxx"
 
 /*
  * Declarations.
@@ -11,7 +15,41 @@
 
 namespace my {
 
+// Reads the whole file as is, into a string sized to it up front.
 auto readFile(std::string_view filePath) -> std::optional<std::string>;
+// Writes the data to a temporary file next to the path and renames it
+// over the path, so that readers never see the file half written.
+auto writeFile(std::string_view filePath, const void* data, std::size_t size)
+-> bool;
+// Reads each file with readFile() on the pool's threads, so that the
+// reads overlap; the futures come back in the order of the paths.
+auto readFilesAsync(
+  ThreadPool& pool, const std::vector<std::string>& filePaths
+) -> std::vector<std::future<std::optional<std::string>>>;
+
+// Read-only view of a whole file mapped into memory. Pages are read in
+// as they are first touched, so opening copies nothing, and the data
+// stays where it is when the view is moved.
+class MappedFile {
+public:
+  static auto open(std::string_view filePath) -> std::optional<MappedFile>;
+  MappedFile() = delete;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& file);
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+  auto operator=(MappedFile&& file) -> MappedFile&;
+  ~MappedFile() noexcept;
+
+  auto getData() const -> const std::byte*;
+  auto getSize() const -> std::size_t;
+
+private:
+  const std::byte* _data{};
+  std::size_t _size{};
+
+  MappedFile(const std::byte* data, std::size_t size);
+  auto unmap() -> void;
+};
 
 } // namespace my
 
@@ -0,0 +1,451 @@
+#include "logger.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Records are laid out one after another, each starting on an 8-byte
+// boundary: this prefix, a RecordBody unless the prefix is padding,
+// then each argument as its type and value.
+struct RecordPrefix {
+  // Bytes from here to the next record.
+  std::uint32_t size{};
+  // Off for padding, which skips to the start of the ring when a record
+  // wouldn't fit before its end.
+  my::LogLevel level{};
+  std::uint8_t argumentCount{};
+};
+
+struct RecordBody {
+  std::int64_t time{};
+  const char* format{};
+};
+
+struct LogEntry {
+  std::int64_t time{};
+  my::LogLevel level{};
+  std::string message{};
+};
+
+// Written by one thread, read by whichever thread flushes, under the
+// flush lock.
+class LogQueue {
+public:
+  LogQueue();
+  LogQueue(const LogQueue&) = delete;
+  LogQueue(LogQueue&&) = delete;
+  auto operator=(const LogQueue&) -> LogQueue& = delete;
+  auto operator=(LogQueue&&) -> LogQueue& = delete;
+
+  auto push(
+    my::LogLevel level, const char* format,
+    const my::LogArgument* arguments, std::size_t argumentCount
+  ) -> void;
+  auto pop(std::vector<LogEntry>& entries) -> void;
+  auto takeDropped() -> std::uint64_t;
+
+private:
+  static constexpr std::size_t _capacity{1 << 16};
+  std::unique_ptr<std::byte[]> _data;
+  // Total bytes ever written and read; only the writer moves the head
+  // and only the reader moves the tail.
+  std::atomic<std::uint64_t> _head{};
+  std::atomic<std::uint64_t> _tail{};
+  std::atomic<std::uint64_t> _dropped{};
+};
+
+auto getQueue() -> LogQueue&;
+auto now() -> std::int64_t;
+auto getText(const my::LogArgument& argument) -> std::string_view;
+auto getEncodedSize(const my::LogArgument& argument) -> std::size_t;
+auto encode(std::byte* out, const my::LogArgument& argument) -> std::byte*;
+auto appendArgument(std::string& message, const std::byte*& in) -> void;
+auto formatMessage(
+  const char* format, const std::byte* arguments, std::size_t argumentCount
+) -> std::string;
+auto getLevelName(my::LogLevel level) -> const char*;
+auto writeEntry(std::ostream& out, const LogEntry& entry) -> void;
+
+constexpr std::size_t recordAlignment{8};
+constexpr std::chrono::milliseconds flushInterval{10};
+const std::int64_t startTime{now()};
+
+thread_local LogQueue* threadQueue{};
+// Never shrinks, so that queues outlive the threads they belong to.
+std::mutex queuesMutex{};
+std::vector<std::unique_ptr<LogQueue>> queues{};
+// Guards reading the queues and the sinks.
+std::mutex flushMutex{};
+std::ofstream logFile{};
+std::vector<LogEntry> pendingEntries{};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::parseLogLevel(std::string_view name) -> std::optional<LogLevel> {
+  if (name == "debug") {
+    return LogLevel::Debug;
+  } else if (name == "info") {
+    return LogLevel::Info;
+  } else if (name == "warning") {
+    return LogLevel::Warning;
+  } else if (name == "error") {
+    return LogLevel::Error;
+  } else if (name == "off") {
+    return LogLevel::Off;
+  }
+  return {};
+}
+
+auto my::Logger::setLevel(LogLevel level) -> void {
+  _level.store(level, std::memory_order_relaxed);
+}
+
+auto my::Logger::setFile(const std::string& filePath) -> bool {
+  const std::lock_guard<std::mutex> lock{flushMutex};
+  logFile.close();
+  logFile.clear();
+  logFile.open(filePath);
+  return logFile.is_open();
+}
+
+auto my::Logger::flush() -> void {
+  const std::lock_guard<std::mutex> lock{flushMutex};
+  std::uint64_t dropped{};
+  {
+    const std::lock_guard<std::mutex> queuesLock{queuesMutex};
+    for (const auto& queue : queues) {
+      queue->pop(pendingEntries);
+      dropped += queue->takeDropped();
+    }
+  }
+  if (dropped > 0) {
+    pendingEntries.push_back({
+      now(), LogLevel::Warning,
+      "Dropped " + std::to_string(dropped) + " log messages"
+    });
+  }
+  if (pendingEntries.empty()) {
+    return;
+  }
+  std::stable_sort(
+    pendingEntries.begin(), pendingEntries.end(),
+    [](const LogEntry& a, const LogEntry& b) { return a.time < b.time; }
+  );
+  for (const auto& entry : pendingEntries) {
+    writeEntry(entry.level >= LogLevel::Warning ? std::cerr : std::cout, entry);
+    if (logFile.is_open()) {
+      writeEntry(logFile, entry);
+    }
+  }
+  pendingEntries.clear();
+  std::cout.flush();
+  if (logFile.is_open()) {
+    logFile.flush();
+  }
+}
+
+auto my::Logger::submit(
+  LogLevel level, const char* format, const LogArgument* arguments,
+  std::size_t argumentCount
+) -> void {
+  getQueue().push(level, format, arguments, argumentCount);
+}
+
+my::LogThread::LogThread() : _thread{&LogThread::run, this} {}
+
+my::LogThread::~LogThread() {
+  {
+    const std::lock_guard<std::mutex> lock{_mutex};
+    _stopping = true;
+  }
+  _condition.notify_one();
+  _thread.join();
+  Logger::flush();
+}
+
+auto my::LogThread::run() -> void {
+  std::unique_lock<std::mutex> lock{_mutex};
+  while (!_condition.wait_for(
+    lock, flushInterval, [this]() { return _stopping; }
+  )) {
+    lock.unlock();
+    Logger::flush();
+    lock.lock();
+  }
+}
+
+namespace {
+
+LogQueue::LogQueue() : _data{std::make_unique<std::byte[]>(_capacity)} {}
+
+auto LogQueue::push(
+  my::LogLevel level, const char* format, const my::LogArgument* arguments,
+  std::size_t argumentCount
+) -> void {
+  std::size_t size{sizeof(RecordPrefix) + sizeof(RecordBody)};
+  for (std::size_t i{}; i < argumentCount; i++) {
+    size += getEncodedSize(arguments[i]);
+  }
+  size = (size + recordAlignment - 1)/recordAlignment*recordAlignment;
+
+  const std::uint64_t head{_head.load(std::memory_order_relaxed)};
+  const std::size_t offset{static_cast<std::size_t>(head % _capacity)};
+  const std::size_t contiguous{_capacity - offset};
+  const std::size_t needed{size <= contiguous ? size : contiguous + size};
+  const std::uint64_t used{head - _tail.load(std::memory_order_acquire)};
+  if (needed > _capacity - used) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  std::byte* out{_data.get() + offset};
+  if (size > contiguous) {
+    const RecordPrefix padding{
+      static_cast<std::uint32_t>(contiguous), my::LogLevel::Off, 0
+    };
+    std::memcpy(out, &padding, sizeof(padding));
+    out = _data.get();
+  }
+  const RecordPrefix prefix{
+    static_cast<std::uint32_t>(size), level,
+    static_cast<std::uint8_t>(argumentCount)
+  };
+  std::memcpy(out, &prefix, sizeof(prefix));
+  out += sizeof(prefix);
+  const RecordBody body{now(), format};
+  std::memcpy(out, &body, sizeof(body));
+  out += sizeof(body);
+  for (std::size_t i{}; i < argumentCount; i++) {
+    out = encode(out, arguments[i]);
+  }
+  _head.store(head + needed, std::memory_order_release);
+}
+
+auto LogQueue::pop(std::vector<LogEntry>& entries) -> void {
+  const std::uint64_t head{_head.load(std::memory_order_acquire)};
+  std::uint64_t tail{_tail.load(std::memory_order_relaxed)};
+  while (tail < head) {
+    const std::byte* in{_data.get() + tail % _capacity};
+    RecordPrefix prefix{};
+    std::memcpy(&prefix, in, sizeof(prefix));
+    tail += prefix.size;
+    if (prefix.level == my::LogLevel::Off) {
+      continue;
+    }
+    RecordBody body{};
+    std::memcpy(&body, in + sizeof(prefix), sizeof(body));
+    entries.push_back({
+      body.time, prefix.level, formatMessage(
+        body.format, in + sizeof(prefix) + sizeof(body), prefix.argumentCount
+      )
+    });
+  }
+  _tail.store(tail, std::memory_order_release);
+}
+
+auto LogQueue::takeDropped() -> std::uint64_t {
+  return _dropped.exchange(0, std::memory_order_relaxed);
+}
+
+auto getQueue() -> LogQueue& {
+  if (!threadQueue) {
+    auto queue{std::make_unique<LogQueue>()};
+    threadQueue = queue.get();
+    const std::lock_guard<std::mutex> lock{queuesMutex};
+    queues.push_back(std::move(queue));
+  }
+  return *threadQueue;
+}
+
+auto now() -> std::int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()
+  ).count();
+}
+
+auto getText(const my::LogArgument& argument) -> std::string_view {
+  if (!argument.description.empty()) {
+    return argument.description;
+  }
+  return argument.text;
+}
+
+auto getEncodedSize(const my::LogArgument& argument) -> std::size_t {
+  using Type = my::LogArgument::Type;
+  switch (argument.type) {
+    case Type::Boolean:
+    case Type::Character: {
+      return 2;
+    }
+    case Type::Text: {
+      return 1 + sizeof(std::uint32_t) + getText(argument).size();
+    }
+    default: {
+      return 1 + sizeof(std::uint64_t);
+    }
+  }
+}
+
+auto encode(std::byte* out, const my::LogArgument& argument) -> std::byte* {
+  using Type = my::LogArgument::Type;
+  *out++ = static_cast<std::byte>(argument.type);
+  switch (argument.type) {
+    case Type::Signed: {
+      std::memcpy(out, &argument.signedValue, sizeof(std::int64_t));
+      return out + sizeof(std::int64_t);
+    }
+    case Type::Unsigned: {
+      std::memcpy(out, &argument.unsignedValue, sizeof(std::uint64_t));
+      return out + sizeof(std::uint64_t);
+    }
+    case Type::Float: {
+      std::memcpy(out, &argument.floatValue, sizeof(double));
+      return out + sizeof(double);
+    }
+    case Type::Pointer: {
+      std::memcpy(out, &argument.pointer, sizeof(const void*));
+      return out + sizeof(std::uint64_t);
+    }
+    case Type::Boolean: {
+      *out = static_cast<std::byte>(argument.unsignedValue);
+      return out + 1;
+    }
+    case Type::Character: {
+      *out = static_cast<std::byte>(argument.signedValue);
+      return out + 1;
+    }
+    case Type::Text: {
+      const std::string_view text{getText(argument)};
+      const auto length{static_cast<std::uint32_t>(text.size())};
+      std::memcpy(out, &length, sizeof(length));
+      out += sizeof(length);
+      std::memcpy(out, text.data(), text.size());
+      return out + text.size();
+    }
+  }
+  return out;
+}
+
+auto appendArgument(std::string& message, const std::byte*& in) -> void {
+  using Type = my::LogArgument::Type;
+  const auto type{static_cast<Type>(*in++)};
+  char buffer[32]{};
+  switch (type) {
+    case Type::Signed: {
+      std::int64_t value{};
+      std::memcpy(&value, in, sizeof(value));
+      in += sizeof(value);
+      const auto result{std::to_chars(buffer, buffer + sizeof(buffer), value)};
+      message.append(buffer, result.ptr);
+      break;
+    }
+    case Type::Unsigned: {
+      std::uint64_t value{};
+      std::memcpy(&value, in, sizeof(value));
+      in += sizeof(value);
+      const auto result{std::to_chars(buffer, buffer + sizeof(buffer), value)};
+      message.append(buffer, result.ptr);
+      break;
+    }
+    case Type::Float: {
+      double value{};
+      std::memcpy(&value, in, sizeof(value));
+      in += sizeof(value);
+      // As iostreams would write it.
+      std::snprintf(buffer, sizeof(buffer), "%g", value);
+      message += buffer;
+      break;
+    }
+    case Type::Pointer: {
+      const void* value{};
+      std::memcpy(&value, in, sizeof(value));
+      in += sizeof(std::uint64_t);
+      std::snprintf(buffer, sizeof(buffer), "%p", value);
+      message += buffer;
+      break;
+    }
+    case Type::Boolean: {
+      message += *in++ != std::byte{} ? "true" : "false";
+      break;
+    }
+    case Type::Character: {
+      message += static_cast<char>(*in++);
+      break;
+    }
+    case Type::Text: {
+      std::uint32_t length{};
+      std::memcpy(&length, in, sizeof(length));
+      in += sizeof(length);
+      message.append(reinterpret_cast<const char*>(in), length);
+      in += length;
+      break;
+    }
+  }
+}
+
+auto formatMessage(
+  const char* format, const std::byte* arguments, std::size_t argumentCount
+) -> std::string {
+  std::string message{};
+  std::size_t argument{};
+  for (const char* c{format}; *c; c++) {
+    if (c[0] == '{' && c[1] == '}' && argument < argumentCount) {
+      appendArgument(message, arguments);
+      argument++;
+      c++;
+    } else {
+      message += *c;
+    }
+  }
+  return message;
+}
+
+auto getLevelName(my::LogLevel level) -> const char* {
+  switch (level) {
+    case my::LogLevel::Debug: {
+      return "debug";
+    }
+    case my::LogLevel::Info: {
+      return "info";
+    }
+    case my::LogLevel::Warning: {
+      return "warning";
+    }
+    case my::LogLevel::Error: {
+      return "error";
+    }
+    default: {
+      return "?";
+    }
+  }
+}
+
+auto writeEntry(std::ostream& out, const LogEntry& entry) -> void {
+  char time[32]{};
+  std::snprintf(
+    time, sizeof(time), "[%10.3f] ",
+    static_cast<double>(entry.time - startTime)/1e9
+  );
+  out << time << getLevelName(entry.level) << ": " << entry.message;
+  if (entry.message.empty() || entry.message.back() != '\n') {
+    out << '\n';
+  }
+}
+
+} // namespace
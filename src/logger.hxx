@@ -0,0 +1,188 @@
+#ifndef LOGGER_HXX
+#define LOGGER_HXX
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "debug.hxx"
+
+// The format has to be a literal, with "{}" standing for each argument
+// in turn. Arguments are only evaluated when the level is enabled.
+#define LOG_AT(level, ...) \
+  do { \
+    if (my::Logger::isEnabled(level)) { \
+      my::Logger::write(level, __VA_ARGS__); \
+    } \
+  } while (false)
+#define LOG_DEBUG(...) LOG_AT(my::LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(my::LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(my::LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(my::LogLevel::Error, __VA_ARGS__)
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+enum class LogLevel : std::uint8_t {
+  Debug,
+  Info,
+  Warning,
+  Error,
+  Off,
+};
+
+// Accepts the lowercase level names.
+auto parseLogLevel(std::string_view name) -> std::optional<LogLevel>;
+
+// One argument as captured on the logging thread. Numbers and pointers
+// are formatted later, on the log thread; strings are copied into the
+// queue with them. Anything else that can be streamed is described on
+// the spot, since it may be gone by then.
+struct LogArgument {
+  enum class Type : std::uint8_t {
+    Signed,
+    Unsigned,
+    Float,
+    Boolean,
+    Character,
+    Pointer,
+    Text,
+  };
+
+  template<typename T>
+  LogArgument(const T& value);
+
+  Type type{};
+  std::int64_t signedValue{};
+  std::uint64_t unsignedValue{};
+  double floatValue{};
+  const void* pointer{};
+  std::string_view text{};
+  // Takes the place of text when not empty.
+  std::string description{};
+};
+
+// Messages go into a queue per thread, without locking, and are
+// formatted and written out on the log thread. A thread whose queue is
+// full drops messages rather than wait, and the drops are reported.
+class Logger {
+public:
+  Logger() = delete;
+
+  static auto isEnabled(LogLevel level) -> bool;
+  static auto setLevel(LogLevel level) -> void;
+  // Also writes every message to the file, replacing its contents.
+  static auto setFile(const std::string& filePath) -> bool;
+  template<typename... Arguments>
+  static auto write(
+    LogLevel level, const char* format, const Arguments&... arguments
+  ) -> void;
+  // Writes out what every thread has queued so far, in time order.
+  static auto flush() -> void;
+
+private:
+#ifdef DEBUG
+  static inline std::atomic<LogLevel> _level{LogLevel::Info};
+#else
+  static inline std::atomic<LogLevel> _level{LogLevel::Warning};
+#endif // DEBUG
+
+  static auto submit(
+    LogLevel level, const char* format, const LogArgument* arguments,
+    std::size_t argumentCount
+  ) -> void;
+};
+
+// Flushes the logger in the background while it lives, and once more on
+// the way out.
+class LogThread {
+public:
+  LogThread();
+  LogThread(const LogThread&) = delete;
+  LogThread(LogThread&&) = delete;
+  auto operator=(const LogThread&) -> LogThread& = delete;
+  auto operator=(LogThread&&) -> LogThread& = delete;
+  ~LogThread() noexcept;
+
+private:
+  std::mutex _mutex{};
+  std::condition_variable _condition{};
+  bool _stopping{};
+  std::thread _thread;
+
+  auto run() -> void;
+};
+
+} // namespace my
+
+/*
+ * Definitions.
+ */
+
+template<typename T>
+my::LogArgument::LogArgument(const T& value) {
+  using Pointee = std::remove_cv_t<std::remove_pointer_t<T>>;
+  if constexpr (std::is_same_v<T, bool>) {
+    type = Type::Boolean;
+    unsignedValue = value;
+  } else if constexpr (std::is_same_v<T, char>) {
+    type = Type::Character;
+    signedValue = value;
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    type = Type::Signed;
+    signedValue = value;
+  } else if constexpr (std::is_integral_v<T>) {
+    type = Type::Unsigned;
+    unsignedValue = value;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    type = Type::Float;
+    floatValue = static_cast<double>(value);
+  } else if constexpr (
+    std::is_pointer_v<T>
+    && (std::is_same_v<Pointee, char> || std::is_same_v<Pointee, unsigned char>)
+  ) {
+    // Including GL strings, which are unsigned.
+    type = Type::Text;
+    text = value ? reinterpret_cast<const char*>(value) : "(null)";
+  } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    type = Type::Text;
+    text = value;
+  } else if constexpr (std::is_pointer_v<T>) {
+    type = Type::Pointer;
+    pointer = value;
+  } else {
+    std::ostringstream stream{};
+    stream << value;
+    type = Type::Text;
+    description = stream.str();
+  }
+}
+
+inline auto my::Logger::isEnabled(LogLevel level) -> bool {
+  return level >= _level.load(std::memory_order_relaxed);
+}
+
+template<typename... Arguments>
+auto my::Logger::write(
+  LogLevel level, const char* format, const Arguments&... arguments
+) -> void {
+  static_assert(sizeof...(Arguments) < 256, "Too many log arguments");
+  const std::array<LogArgument, sizeof...(Arguments)> captured{
+    LogArgument{arguments}...
+  };
+  submit(level, format, captured.data(), captured.size());
+}
+
+#endif // LOGGER_HXX
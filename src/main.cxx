@@ -1,29 +1,128 @@
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
-#include "debug.hxx"
+#include "frame-timer.hxx"
 #include "game.hxx"
 #include "graphics-engine.hxx"
 #include "io.hxx"
+#include "logger.hxx"
+#include "mesh-file.hxx"
+#include "options.hxx"
+#include "profiler.hxx"
+#include "terrain.hxx"
+#include "thread-pool.hxx"
+#include "voxel-world.hxx"
 #include "window.hxx"
 
-auto main(int, char**) -> int {
+auto main(int argc, char** argv) -> int {
+  // Writes out what every thread logs, off the threads doing the work.
+  my::LogThread logThread{};
   try {
-    my::Game game{};
+    const auto startupStart{std::chrono::steady_clock::now()};
+    const my::Options options{my::parseOptions(argc, argv)};
+    if (options.logLevel) {
+      my::Logger::setLevel(*options.logLevel);
+    }
+    if (options.logFile && !my::Logger::setFile(*options.logFile)) {
+      throw std::runtime_error{"Failed to open log file: " + *options.logFile};
+    }
+    my::Profiler::nameThread("Main");
+    // Ctrl+T starts profiling, and again stops it and writes the trace.
+    const std::string tracePath{options.trace.value_or("trace.json")};
+    const auto saveTrace{[&tracePath]() {
+      my::Profiler::setEnabled(false);
+      if (my::Profiler::writeTrace(tracePath)) {
+        std::cout << "Trace written to " << tracePath << '\n';
+      } else {
+        std::cerr << "Failed to write trace: " << tracePath << '\n';
+      }
+    }};
+    if (options.trace) {
+      my::Profiler::setEnabled(true);
+    }
     my::WindowHandler window{};
-    my::GraphicsEngine graphics{};
-    graphics.setCamera(&game.getCamera());
+    my::RenderSettings renderSettings{};
+    renderSettings.instancing = options.instancing;
+    renderSettings.occlusion = options.occlusion;
+    renderSettings.levelsOfDetail = options.levelsOfDetail;
+    renderSettings.fog = options.fog;
+    renderSettings.shaderHotReload = options.shaderHotReload;
+    renderSettings.programCache = options.programCache;
+    // Shared by everything loaded or generated in the background.
+    my::ThreadPool workers{};
+    my::GraphicsEngine graphics{
+      window.getProcAddressLoader(), renderSettings, workers
+    };
+    std::size_t objectMesh{};
+    std::size_t meshFileBytes{};
+    double meshLoadMilliseconds{};
+    if (options.mesh) {
+      const auto loadStart{std::chrono::steady_clock::now()};
+      const std::optional<my::MeshFile> meshFile{
+        my::MeshFile::open(*options.mesh)
+      };
+      if (!meshFile) {
+        throw std::runtime_error{"Failed to load mesh file: " + *options.mesh};
+      }
+      objectMesh = graphics.addMesh(*meshFile);
+      meshFileBytes = meshFile->getSize();
+      const std::chrono::duration<double, std::milli> loadTime{
+        std::chrono::steady_clock::now() - loadStart
+      };
+      meshLoadMilliseconds = loadTime.count();
+    }
+    my::Game game{
+      options.objects, objectMesh, static_cast<float>(options.flySpeed)
+    };
+    std::optional<my::VoxelWorld> world{};
+    if (options.chunks) {
+      world.emplace(workers);
+      my::generateTestWorld(*world, options.chunks);
+    }
+    std::optional<my::TerrainStreamer> terrain{};
+    if (options.terrain) {
+      my::TerrainSettings settings{};
+      settings.loadRadius = options.terrain;
+      if (!options.levelsOfDetail) {
+        settings.levelsOfDetail = 0;
+      }
+      settings.memoryBudget =
+        static_cast<std::size_t>(options.terrainBudget) << 20;
+      terrain.emplace(settings, workers);
+    }
+    std::vector<my::ObjectState> staticObjects{};
+    std::optional<my::FrameTimer> frameTimer{};
+    if (options.frames) {
+      frameTimer.emplace(static_cast<std::size_t>(*options.frames));
+    }
     const my::WindowActions& actions{window.getActions()};
-    LOG("Begin main loop\n");
+    int frameCount{};
+    const std::chrono::duration<double, std::milli> startupTime{
+      std::chrono::steady_clock::now() - startupStart
+    };
+    LOG_INFO("Begin main loop");
+    game.start(options.tickRate);
     while (window.isActive()) {
-      if (actions.close) {
+      PROFILE_SCOPE("Frame");
+      if (actions.close || (options.frames && frameCount >= *options.frames)) {
         window.close();
         break;
       }
+      if (actions.toggleTrace) {
+        if (my::Profiler::isEnabled()) {
+          saveTrace();
+        } else {
+          my::Profiler::setEnabled(true);
+        }
+      }
       if (actions.resetSize) {
         window.resetSize();
       }
@@ -31,19 +130,133 @@ auto main(int, char**) -> int {
         const int width{window.getWidth()};
         const int height{window.getHeight()};
         graphics.resize(width, height);
-        game.getCamera().setAspectRatio(width, height);
+        game.setAspectRatio(width, height);
       }
       window.resetActions();
       window.preRender();
-      game.tick();
-      game.getCamera().update();
-      graphics.render();
+      if (frameTimer) {
+        frameTimer->beginFrame();
+      }
+      // Never waits on the simulation thread; this is whichever state it
+      // published most recently.
+      const my::GameState& state{game.getState()};
+      const float alpha{state.getAlpha(std::chrono::steady_clock::now())};
+      staticObjects.clear();
+      if (world) {
+        world->update(graphics);
+        const std::vector<my::ObjectState>& objects{world->getObjects()};
+        staticObjects.insert(
+          staticObjects.end(), objects.begin(), objects.end()
+        );
+      }
+      if (terrain) {
+        terrain->update(state.getCameraPosition(alpha), graphics);
+        const std::vector<my::ObjectState>& objects{terrain->getObjects()};
+        staticObjects.insert(
+          staticObjects.end(), objects.begin(), objects.end()
+        );
+      }
+      graphics.render(state, alpha, staticObjects);
+      if (frameTimer) {
+        frameTimer->endFrame();
+      }
       window.postRender();
+      frameCount++;
+    }
+    game.stop();
+    LOG_INFO("End main loop");
+    if (my::Profiler::isEnabled()) {
+      saveTrace();
+    }
+    if (frameTimer) {
+      frameTimer->finish();
+      frameTimer->report(std::cout);
+      const my::RenderStats& stats{graphics.getStats()};
+      std::cout << "Objects: " << stats.objects << " (";
+      std::cout << stats.visibleObjects << " visible, ";
+      std::cout << stats.culledObjects << " culled in ";
+      std::cout << stats.cullMilliseconds << " ms, ";
+      std::cout << stats.occludedObjects << " occluded in ";
+      std::cout << stats.occlusionMilliseconds << " ms)\n";
+      std::cout << "Draw calls per frame: " << stats.drawCalls << '\n';
+      std::cout << "Triangles per frame: " << stats.triangles << '\n';
+      std::cout << "GL state changes per frame: ";
+      std::cout << stats.stateChanges.issued << " issued, ";
+      std::cout << stats.stateChanges.elided << " elided\n";
+      std::cout << "Uniform block uploads (last frame): ";
+      std::cout << stats.uniformBlockUploads << '\n';
+      std::cout << "Stream buffer stalls: " << stats.streamStalls << '\n';
+      const my::MeshArenaStats& meshes{stats.meshes};
+      std::cout << "Mesh arena: " << meshes.meshes << " meshes, ";
+      std::cout << meshes.vertexBytesUsed << '/' << meshes.vertexBytesCapacity;
+      std::cout << " vertex bytes, ";
+      std::cout << meshes.indexBytesUsed << '/' << meshes.indexBytesCapacity;
+      std::cout << " index bytes, fragmentation ";
+      std::cout << meshes.vertexFragmentation << '/';
+      std::cout << meshes.indexFragmentation << ", ";
+      std::cout << meshes.defragmentations << " defragmentations\n";
+      if (options.mesh) {
+        std::cout << "Mesh file: " << meshFileBytes << " bytes loaded in ";
+        std::cout << meshLoadMilliseconds << " ms (";
+        std::cout << static_cast<double>(meshFileBytes)/1000.
+          /meshLoadMilliseconds;
+        std::cout << " MB/s)\n";
+      }
+      const my::ProgramCacheStats& programs{stats.programs};
+      std::cout << "Startup: " << startupTime.count() << " ms, of which ";
+      std::cout << programs.milliseconds << " ms building shader programs (";
+      std::cout << programs.loaded << " cached, " << programs.compiled;
+      std::cout << " compiled)\n";
+      const my::VertexCacheStats& vertexCache{stats.vertexCache};
+      const auto triangles{
+        static_cast<double>(std::max<std::size_t>(vertexCache.triangles, 1))
+      };
+      std::cout << "Vertex cache ACMR: ";
+      std::cout << static_cast<double>(vertexCache.transformsBefore)/triangles;
+      std::cout << " before, ";
+      std::cout << static_cast<double>(vertexCache.transformsAfter)/triangles;
+      std::cout << " after optimizing " << vertexCache.triangles;
+      std::cout << " triangles\n";
+      if (world) {
+        const my::VoxelWorldStats worldStats{world->getStats()};
+        std::cout << "Voxel world: " << worldStats.chunks << " chunks, ";
+        std::cout << worldStats.voxelBytes << " voxel bytes, ";
+        std::cout << worldStats.dirtyChunks + worldStats.meshingChunks;
+        std::cout << " waiting for meshes\n";
+        std::cout << "Chunk meshing: " << worldStats.chunksMeshed;
+        std::cout << " chunks on " << workers.getThreadCount();
+        std::cout << " threads, ";
+        // Nothing may have finished meshing yet in a short run.
+        std::cout << (
+          worldStats.meshingMilliseconds > 0.
+          ? static_cast<double>(worldStats.chunksMeshed)*1000.
+            /worldStats.meshingMilliseconds
+          : 0.
+        );
+        std::cout << " chunks/s per core\n";
+      }
+      if (terrain) {
+        const my::TerrainStats& terrainStats{terrain->getStats()};
+        std::cout << "Terrain: " << terrainStats.tilesLoaded;
+        std::cout << " tiles loaded, ";
+        std::cout << terrainStats.tilesGenerated << " generated at ";
+        // Nothing may have finished generating yet in a short run.
+        std::cout << (
+          terrainStats.generateMilliseconds > 0.
+          ? static_cast<double>(terrainStats.tilesGenerated)*1000.
+            /terrainStats.generateMilliseconds
+          : 0.
+        );
+        std::cout << " tiles/s per core on " << workers.getThreadCount();
+        std::cout << " threads, " << terrainStats.tilesUnloaded;
+        std::cout << " unloaded\n";
+        std::cout << "Terrain memory: " << terrainStats.memoryBytes;
+        std::cout << " bytes, peak " << terrainStats.peakMemoryBytes << '\n';
+      }
     }
-    LOG("End main loop\n");
   } catch (std::exception& ex) {
     std::cerr << ex.what() << '\n';
-    std::exit(EXIT_FAILURE);
+    return EXIT_FAILURE;
   }
-  LOG("Goodbye.\n");
+  LOG_INFO("Goodbye.");
 }
@@ -0,0 +1,292 @@
+#include "mesh-arena.hxx"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "graphics-state.hxx"
+#include "vertex-format.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto createBuffer(my::BufferTarget target, std::size_t size) -> my::Buffer;
+auto copyBufferRange(
+  const my::Buffer& source, const my::Buffer& destination,
+  std::size_t sourceOffset, std::size_t destinationOffset, std::size_t size
+) -> void;
+
+// The index allocator's unit; 32-bit indices take two.
+constexpr std::size_t indexUnit{sizeof(GLushort)};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::MeshArena::MeshArena(
+  std::size_t vertexSize, std::size_t vertexCapacity, std::size_t indexCapacity
+) : _vertexSize{vertexSize}, _vertexAllocator{vertexCapacity},
+    _indexAllocator{indexCapacity} {
+  _buffers.reserve(2);
+  _buffers.push_back(
+    createBuffer(BufferTarget::Array, vertexCapacity*_vertexSize)
+  );
+  _buffers.push_back(
+    createBuffer(BufferTarget::ElementArray, indexCapacity*indexUnit)
+  );
+}
+
+auto my::MeshArena::add(
+  const GLvoid* vertices, std::size_t vertexCount, const GLuint* indices,
+  std::size_t indexCount
+) -> std::uint32_t {
+  const IndexType indexType{getIndexType(vertexCount)};
+  if (indexType == IndexType::UnsignedInt) {
+    return add(vertices, vertexCount, indices, indexType, indexCount);
+  }
+  const std::vector<GLushort> narrowed(indices, indices + indexCount);
+  return add(vertices, vertexCount, narrowed.data(), indexType, indexCount);
+}
+
+auto my::MeshArena::add(
+  const GLvoid* vertices, std::size_t vertexCount, const GLvoid* indices,
+  IndexType indexType, std::size_t indexCount
+) -> std::uint32_t {
+  Entry entry{};
+  entry.vertexCount = vertexCount;
+  entry.firstVertex = allocateVertices(vertexCount);
+  const std::size_t indexSize{getIndexSize(indexType)};
+  // Indices have to start at a multiple of their size.
+  entry.indexUnits = indexCount*indexSize/indexUnit;
+  entry.firstIndex = allocateIndices(entry.indexUnits, indexSize/indexUnit);
+  entry.range = {
+    indexType, static_cast<GLsizei>(indexCount),
+    static_cast<GLsizeiptr>(entry.firstIndex*indexUnit),
+    static_cast<GLint>(entry.firstVertex)
+  };
+  entry.live = true;
+
+  _buffers.front().setSubData(
+    static_cast<GLintptr>(entry.firstVertex*_vertexSize), vertices,
+    static_cast<GLsizeiptr>(vertexCount*_vertexSize)
+  );
+  _buffers.back().setSubData(
+    entry.range.indexOffset, indices,
+    static_cast<GLsizeiptr>(indexCount*indexSize)
+  );
+
+  _meshCount++;
+  if (!_freeIDs.empty()) {
+    const std::uint32_t mesh{_freeIDs.back()};
+    _freeIDs.pop_back();
+    _entries[mesh] = entry;
+    return mesh;
+  }
+  _entries.push_back(entry);
+  return static_cast<std::uint32_t>(_entries.size() - 1);
+}
+
+auto my::MeshArena::remove(std::uint32_t mesh) -> void {
+  Entry& entry{_entries.at(mesh)};
+  if (!entry.live) {
+#ifdef DEBUG
+    throw std::runtime_error{"Attempt to remove mesh from arena twice"};
+#endif // DEBUG
+    return;
+  }
+  if (entry.vertexCount > 0) {
+    _vertexAllocator.free(entry.firstVertex);
+  }
+  if (entry.indexUnits > 0) {
+    _indexAllocator.free(entry.firstIndex);
+  }
+  entry.live = false;
+  _freeIDs.push_back(mesh);
+  _meshCount--;
+}
+
+auto my::MeshArena::defragment() -> void {
+  // Copies every live mesh to where the allocators pack its ranges, in a
+  // fresh set of buffers. GL doesn't allow overlapping copies within one
+  // buffer, so compacting in place would need a staging copy anyway.
+  std::vector<Buffer> buffers{};
+  buffers.reserve(_buffers.size());
+  buffers.push_back(createBuffer(
+    BufferTarget::Array, _vertexAllocator.getCapacity()*_vertexSize
+  ));
+  buffers.push_back(createBuffer(
+    BufferTarget::ElementArray, _indexAllocator.getCapacity()*indexUnit
+  ));
+  const auto vertexMoves{_vertexAllocator.compact()};
+  const auto indexMoves{_indexAllocator.compact()};
+  for (auto& entry : _entries) {
+    if (!entry.live) {
+      continue;
+    }
+    // Empty ranges were never allocated.
+    const std::size_t firstVertex{
+      entry.vertexCount > 0 ? vertexMoves.at(entry.firstVertex) : 0
+    };
+    const std::size_t firstIndex{
+      entry.indexUnits > 0 ? indexMoves.at(entry.firstIndex) : 0
+    };
+    const std::size_t indexOffset{firstIndex*indexUnit};
+    copyBufferRange(
+      _buffers.front(), buffers.front(), entry.firstVertex*_vertexSize,
+      firstVertex*_vertexSize, entry.vertexCount*_vertexSize
+    );
+    copyBufferRange(
+      _buffers.back(), buffers.back(),
+      static_cast<std::size_t>(entry.range.indexOffset), indexOffset,
+      entry.indexUnits*indexUnit
+    );
+    entry.firstVertex = firstVertex;
+    entry.firstIndex = firstIndex;
+    entry.range.indexOffset = static_cast<GLsizeiptr>(indexOffset);
+    entry.range.baseVertex = static_cast<GLint>(firstVertex);
+  }
+  _buffers = std::move(buffers);
+  _generation++;
+  _defragmentations++;
+}
+
+auto my::MeshArena::get(std::uint32_t mesh) const -> const MeshRange& {
+#ifdef DEBUG
+  if (!_entries.at(mesh).live) {
+    throw std::runtime_error{"Attempt to get removed mesh from arena"};
+  }
+#endif // DEBUG
+  return _entries[mesh].range;
+}
+
+auto my::MeshArena::getVertexBuffer() const -> const Buffer& {
+  return _buffers.front();
+}
+
+auto my::MeshArena::getIndexBuffer() const -> const Buffer& {
+  return _buffers.back();
+}
+
+auto my::MeshArena::getGeneration() const -> std::uint32_t {
+  return _generation;
+}
+
+auto my::MeshArena::getStats() const -> MeshArenaStats {
+  const RangeAllocatorStats vertices{_vertexAllocator.getStats()};
+  const RangeAllocatorStats indices{_indexAllocator.getStats()};
+  MeshArenaStats stats{};
+  stats.meshes = _meshCount;
+  stats.vertexBytesUsed = vertices.used*_vertexSize;
+  stats.vertexBytesCapacity = vertices.capacity*_vertexSize;
+  stats.indexBytesUsed = indices.used*indexUnit;
+  stats.indexBytesCapacity = indices.capacity*indexUnit;
+  stats.vertexFragmentation = vertices.fragmentation;
+  stats.indexFragmentation = indices.fragmentation;
+  stats.defragmentations = _defragmentations;
+  return stats;
+}
+
+auto my::MeshArena::allocateVertices(std::size_t count) -> std::size_t {
+  if (count == 0) {
+    return 0;
+  }
+  std::optional<std::size_t> first{_vertexAllocator.allocate(count)};
+  if (!first) {
+    const std::size_t capacity{_vertexAllocator.getCapacity()};
+    std::size_t newCapacity{std::max<std::size_t>(capacity, 1)};
+    while (newCapacity < capacity + count) {
+      newCapacity *= 2;
+    }
+    resize(newCapacity, _indexAllocator.getCapacity());
+    first = _vertexAllocator.allocate(count);
+  }
+  return *first;
+}
+
+auto my::MeshArena::allocateIndices(
+  std::size_t count, std::size_t alignment
+) -> std::size_t {
+  if (count == 0) {
+    return 0;
+  }
+  std::optional<std::size_t> first{
+    _indexAllocator.allocate(count, alignment)
+  };
+  if (!first) {
+    // The new space may need aligning too.
+    const std::size_t capacity{_indexAllocator.getCapacity()};
+    std::size_t newCapacity{std::max<std::size_t>(capacity, 1)};
+    while (newCapacity < capacity + count + alignment - 1) {
+      newCapacity *= 2;
+    }
+    resize(_vertexAllocator.getCapacity(), newCapacity);
+    first = _indexAllocator.allocate(count, alignment);
+  }
+  return *first;
+}
+
+auto my::MeshArena::resize(
+  std::size_t vertexCapacity, std::size_t indexCapacity
+) -> void {
+  // Buffers that change size are replaced by larger ones holding a copy
+  // of the old contents, so existing offsets stay valid.
+  std::vector<Buffer> buffers{};
+  buffers.reserve(_buffers.size());
+  const std::size_t oldVertexCapacity{_vertexAllocator.getCapacity()};
+  if (vertexCapacity == oldVertexCapacity) {
+    buffers.push_back(std::move(_buffers.front()));
+  } else {
+    buffers.push_back(
+      createBuffer(BufferTarget::Array, vertexCapacity*_vertexSize)
+    );
+    copyBufferRange(
+      _buffers.front(), buffers.back(), 0, 0, oldVertexCapacity*_vertexSize
+    );
+  }
+  const std::size_t oldIndexCapacity{_indexAllocator.getCapacity()};
+  if (indexCapacity == oldIndexCapacity) {
+    buffers.push_back(std::move(_buffers.back()));
+  } else {
+    buffers.push_back(
+      createBuffer(BufferTarget::ElementArray, indexCapacity*indexUnit)
+    );
+    copyBufferRange(
+      _buffers.back(), buffers.back(), 0, 0, oldIndexCapacity*indexUnit
+    );
+  }
+  _buffers = std::move(buffers);
+  _vertexAllocator.grow(vertexCapacity);
+  _indexAllocator.grow(indexCapacity);
+  _generation++;
+}
+
+namespace {
+
+auto createBuffer(my::BufferTarget target, std::size_t size) -> my::Buffer {
+  return {target, nullptr, static_cast<GLsizei>(size)};
+}
+
+auto copyBufferRange(
+  const my::Buffer& source, const my::Buffer& destination,
+  std::size_t sourceOffset, std::size_t destinationOffset, std::size_t size
+) -> void {
+  if (size == 0) {
+    return;
+  }
+  my::StateCache& cache{my::StateCache::current()};
+  cache.bindBuffer(GL_COPY_READ_BUFFER, source.getID());
+  cache.bindBuffer(GL_COPY_WRITE_BUFFER, destination.getID());
+  glCopyBufferSubData(
+    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+    static_cast<GLintptr>(sourceOffset),
+    static_cast<GLintptr>(destinationOffset), static_cast<GLsizeiptr>(size)
+  );
+}
+
+} // namespace
@@ -0,0 +1,111 @@
+#ifndef MESH_ARENA_HXX
+#define MESH_ARENA_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "graphics-types.hxx"
+#include "range-allocator.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Where a mesh lives in the arena's buffers.
+struct MeshRange {
+  IndexType indexType{IndexType::UnsignedShort};
+  GLsizei indexCount{};
+  // In bytes, as the draw calls take it.
+  GLsizeiptr indexOffset{};
+  GLint baseVertex{};
+};
+
+struct MeshArenaStats {
+  std::size_t meshes{};
+  std::size_t vertexBytesUsed{};
+  std::size_t vertexBytesCapacity{};
+  std::size_t indexBytesUsed{};
+  std::size_t indexBytesCapacity{};
+  double vertexFragmentation{};
+  double indexFragmentation{};
+  std::size_t defragmentations{};
+};
+
+// Keeps every mesh of one vertex format in one large vertex buffer and
+// one index buffer, so they can all be drawn from a single vertex
+// array. Each mesh gets a range of vertices and a range of indices,
+// narrowed to the mesh's index type (so one buffer mixes both); the
+// buffers grow when a mesh doesn't fit, and defragment() packs the live
+// meshes together again after removals.
+//
+// Growing or defragmenting replaces the buffers, which bumps the
+// generation; vertex arrays built against an older generation have to
+// be rebuilt.
+class MeshArena {
+public:
+  // Capacities are in vertices and 16-bit indices; vertexSize is the
+  // size in bytes of one (interleaved) vertex of the format.
+  MeshArena(
+    std::size_t vertexSize, std::size_t vertexCapacity,
+    std::size_t indexCapacity
+  );
+  MeshArena() = delete;
+  MeshArena(const MeshArena&) = delete;
+  MeshArena(MeshArena&&) = delete;
+  auto operator=(const MeshArena&) -> MeshArena& = delete;
+  auto operator=(MeshArena&&) -> MeshArena& = delete;
+
+  // Narrows the indices to getIndexType(vertexCount).
+  auto add(
+    const GLvoid* vertices, std::size_t vertexCount, const GLuint* indices,
+    std::size_t indexCount
+  ) -> std::uint32_t;
+  // Takes indices that are already of the given type, as from a file.
+  auto add(
+    const GLvoid* vertices, std::size_t vertexCount, const GLvoid* indices,
+    IndexType indexType, std::size_t indexCount
+  ) -> std::uint32_t;
+  auto remove(std::uint32_t mesh) -> void;
+  auto defragment() -> void;
+  auto get(std::uint32_t mesh) const -> const MeshRange&;
+  auto getVertexBuffer() const -> const Buffer&;
+  auto getIndexBuffer() const -> const Buffer&;
+  auto getGeneration() const -> std::uint32_t;
+  auto getStats() const -> MeshArenaStats;
+
+private:
+  struct Entry {
+    MeshRange range{};
+    std::size_t firstVertex{};
+    std::size_t vertexCount{};
+    // In 16-bit units; 32-bit indices start on an even one.
+    std::size_t firstIndex{};
+    std::size_t indexUnits{};
+    bool live{};
+  };
+
+  std::size_t _vertexSize;
+  RangeAllocator _vertexAllocator;
+  RangeAllocator _indexAllocator;
+  // The vertex buffer followed by the index buffer.
+  std::vector<Buffer> _buffers{};
+  std::vector<Entry> _entries{};
+  std::vector<std::uint32_t> _freeIDs{};
+  std::size_t _meshCount{};
+  std::uint32_t _generation{};
+  std::size_t _defragmentations{};
+
+  auto allocateVertices(std::size_t count) -> std::size_t;
+  auto allocateIndices(std::size_t count, std::size_t alignment)
+  -> std::size_t;
+  auto resize(std::size_t vertexCapacity, std::size_t indexCapacity) -> void;
+};
+
+} // namespace my
+
+#endif // MESH_ARENA_HXX
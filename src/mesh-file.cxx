@@ -0,0 +1,333 @@
+#include "mesh-file.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "logger.hxx"
+#include "vertex-format.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// On-disk layout, little-endian as written on the machines this runs on.
+struct FileHeader {
+  std::array<char, 4> magic{};
+  std::uint32_t version{};
+  std::uint32_t vertexSize{};
+  std::uint32_t levelCount{};
+  std::array<float, 3> boxCenter{};
+  std::array<float, 3> boxExtent{};
+  std::array<float, 3> sphereCenter{};
+  float sphereRadius{};
+  // Stored positions are (position - origin)/scale.
+  std::array<float, 3> origin{};
+  float scale{};
+};
+
+// Offsets are in bytes from the start of the file.
+struct FileLevel {
+  std::uint32_t vertexCount{};
+  std::uint32_t indexCount{};
+  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+  std::uint32_t indexType{};
+  std::uint32_t reserved{};
+  std::uint64_t vertexOffset{};
+  std::uint64_t indexOffset{};
+};
+
+static_assert(sizeof(FileHeader) == 72);
+static_assert(sizeof(FileLevel) == 32);
+
+auto countDistortedTriangles(const my::Geometry& geometry) -> std::size_t;
+auto isValidLevel(const FileLevel& level, std::size_t fileSize) -> bool;
+auto isValidRange(
+  std::uint64_t offset, std::uint64_t count, std::size_t elementSize,
+  std::size_t fileSize
+) -> bool;
+auto alignOffset(std::size_t offset) -> std::size_t;
+auto toArray(const glm::vec3& vector) -> std::array<float, 3>;
+auto toVector(const std::array<float, 3>& array) -> glm::vec3;
+
+constexpr std::array<char, 4> fileMagic{'W', '3', 'D', 'M'};
+constexpr std::size_t dataAlignment{64};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::MeshFile::open(std::string_view filePath)
+-> std::optional<MeshFile> {
+  std::optional<MappedFile> file{MappedFile::open(filePath)};
+  if (!file) {
+    return {};
+  }
+  const std::byte* data{file->getData()};
+  const std::size_t size{file->getSize()};
+  FileHeader header{};
+  if (size < sizeof(header)) {
+    LOG_ERROR("Mesh file is truncated: {}", filePath);
+    return {};
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (
+    header.magic != fileMagic || header.version != meshFileVersion
+    || header.vertexSize != sizeof(PackedVertex)
+  ) {
+    LOG_ERROR("Not a version {} mesh file: {}", meshFileVersion, filePath);
+    return {};
+  }
+  if (!(header.scale > 0.f)) {
+    LOG_ERROR("Mesh file is corrupt: {}", filePath);
+    return {};
+  }
+  if (
+    header.levelCount == 0
+    || header.levelCount > (size - sizeof(header))/sizeof(FileLevel)
+  ) {
+    LOG_ERROR("Mesh file is truncated: {}", filePath);
+    return {};
+  }
+  std::vector<MeshFileLevel> levels{};
+  levels.reserve(header.levelCount);
+  for (std::size_t i{}; i < header.levelCount; i++) {
+    FileLevel level{};
+    std::memcpy(
+      &level, data + sizeof(header) + i*sizeof(FileLevel), sizeof(level)
+    );
+    if (!isValidLevel(level, size)) {
+      LOG_ERROR("Mesh file is corrupt: {}", filePath);
+      return {};
+    }
+    levels.push_back({
+      data + level.vertexOffset, level.vertexCount, data + level.indexOffset,
+      level.indexCount, static_cast<IndexType>(level.indexType)
+    });
+  }
+  MeshBounds bounds{};
+  bounds.box = {toVector(header.boxCenter), toVector(header.boxExtent)};
+  bounds.sphere = {toVector(header.sphereCenter), header.sphereRadius};
+  const MeshPlacement placement{toVector(header.origin), header.scale};
+  return MeshFile{
+    std::move(*file), bounds, placement.getTransform(), std::move(levels)
+  };
+}
+
+my::MeshFile::MeshFile(
+  MappedFile file, const MeshBounds& bounds, const glm::mat4& transform,
+  std::vector<MeshFileLevel> levels
+) : _file{std::move(file)}, _bounds{bounds}, _transform{transform},
+  _levels{std::move(levels)} {}
+
+auto my::MeshFile::getBounds() const -> const MeshBounds& {
+  return _bounds;
+}
+
+auto my::MeshFile::getTransform() const -> const glm::mat4& {
+  return _transform;
+}
+
+auto my::MeshFile::getLevelCount() const -> std::size_t {
+  return _levels.size();
+}
+
+auto my::MeshFile::getLevel(std::size_t level) const -> const MeshFileLevel& {
+  return _levels.at(level);
+}
+
+auto my::MeshFile::getSize() const -> std::size_t {
+  return _file.getSize();
+}
+
+auto my::writeMeshFile(
+  std::string_view filePath, const Geometry& geometry,
+  const std::vector<MeshGeometry>& levels
+) -> bool {
+  const GLfloat* positions{geometry.getVertices()};
+  if (!std::all_of(
+    positions, positions + geometry.getVertexArraySize(),
+    [](GLfloat value) { return std::isfinite(value); }
+  )) {
+    LOG_ERROR("Mesh positions aren't finite: {}", filePath);
+    return false;
+  }
+  const MeshPlacement placement{computePlacement(geometry)};
+  if (!std::isfinite(placement.scale)) {
+    LOG_ERROR("Mesh is too large for its bounds to be stored: {}", filePath);
+    return false;
+  }
+
+  const MeshGeometry placed{placeGeometry(geometry, placement)};
+  if (const std::size_t distorted{countDistortedTriangles(placed)}) {
+    LOG_WARNING(
+      "{} triangles are distorted by half float precision in {}; the "
+      "model is too detailed for its size",
+      distorted, filePath
+    );
+  }
+  std::vector<PackedMesh> meshes{};
+  meshes.reserve(levels.size() + 1);
+  meshes.push_back(packMesh(placed));
+  for (const auto& level : levels) {
+    meshes.push_back(packMesh(placeGeometry(level, placement)));
+  }
+
+  const MeshBounds bounds{computeBounds(placed)};
+  FileHeader header{};
+  header.magic = fileMagic;
+  header.version = meshFileVersion;
+  header.vertexSize = sizeof(PackedVertex);
+  header.levelCount = static_cast<std::uint32_t>(meshes.size());
+  header.boxCenter = toArray(bounds.box.center);
+  header.boxExtent = toArray(bounds.box.extent);
+  header.sphereCenter = toArray(bounds.sphere.center);
+  header.sphereRadius = bounds.sphere.radius;
+  header.origin = toArray(placement.origin);
+  header.scale = placement.scale;
+  std::vector<FileLevel> table(meshes.size());
+  std::size_t offset{sizeof(header) + table.size()*sizeof(FileLevel)};
+  for (std::size_t i{}; i < meshes.size(); i++) {
+    const PackedMesh& mesh{meshes[i]};
+    const IndexType indexType{getIndexType(mesh.vertices.size())};
+    FileLevel& level{table[i]};
+    level.vertexCount = static_cast<std::uint32_t>(mesh.vertices.size());
+    level.indexCount = static_cast<std::uint32_t>(mesh.indices.size());
+    level.indexType = static_cast<std::uint32_t>(indexType);
+    offset = alignOffset(offset);
+    level.vertexOffset = offset;
+    offset += mesh.vertices.size()*sizeof(PackedVertex);
+    offset = alignOffset(offset);
+    level.indexOffset = offset;
+    offset += mesh.indices.size()*getIndexSize(indexType);
+  }
+
+  std::ofstream out{std::string{filePath}, std::ios::binary};
+  if (!out) {
+    LOG_ERROR("Failed to create mesh file: {}", filePath);
+    return false;
+  }
+  std::size_t written{};
+  const auto write{[&](const void* bytes, std::size_t count) {
+    out.write(static_cast<const char*>(bytes), static_cast<long>(count));
+    written += count;
+  }};
+  const auto padTo{[&](std::size_t start) {
+    constexpr std::array<char, dataAlignment> zeros{};
+    write(zeros.data(), start - written);
+  }};
+  write(&header, sizeof(header));
+  write(table.data(), table.size()*sizeof(FileLevel));
+  for (std::size_t i{}; i < meshes.size(); i++) {
+    const PackedMesh& mesh{meshes[i]};
+    padTo(table[i].vertexOffset);
+    write(mesh.vertices.data(), mesh.vertices.size()*sizeof(PackedVertex));
+    padTo(table[i].indexOffset);
+    if (table[i].indexType == GL_UNSIGNED_SHORT) {
+      const std::vector<GLushort> narrowed(
+        mesh.indices.begin(), mesh.indices.end()
+      );
+      write(narrowed.data(), narrowed.size()*sizeof(GLushort));
+    } else {
+      write(mesh.indices.data(), mesh.indices.size()*sizeof(GLuint));
+    }
+  }
+  return static_cast<bool>(out);
+}
+
+namespace {
+
+auto countDistortedTriangles(const my::Geometry& geometry) -> std::size_t {
+  const GLfloat* positions{geometry.getVertices()};
+  const GLuint* indices{geometry.getIndices()};
+  const auto getCorner{[positions](GLuint vertex) {
+    return glm::vec3{
+      positions[vertex*3], positions[vertex*3 + 1], positions[vertex*3 + 2]
+    };
+  }};
+  const auto round{[](const glm::vec3& corner) {
+    return glm::vec3{
+      my::unpackHalf(my::packHalf(corner.x)),
+      my::unpackHalf(my::packHalf(corner.y)),
+      my::unpackHalf(my::packHalf(corner.z))
+    };
+  }};
+  // Triangles with a corner that rounding to half floats moves by more
+  // than a quarter of their shortest edge, enough to visibly bend or
+  // flatten them.
+  std::size_t distorted{};
+  const auto indexCount{static_cast<std::size_t>(geometry.getIndexCount())};
+  for (std::size_t i{}; i + 2 < indexCount; i += 3) {
+    const std::array<glm::vec3, 3> corners{
+      getCorner(indices[i]), getCorner(indices[i + 1]),
+      getCorner(indices[i + 2])
+    };
+    float shortestEdge{std::numeric_limits<float>::max()};
+    float largestError{};
+    for (std::size_t corner{}; corner < 3; corner++) {
+      const glm::vec3& position{corners[corner]};
+      // Corners in the same place stay together when rounded.
+      const float edge{glm::distance(position, corners[(corner + 1) % 3])};
+      if (edge > 0.f) {
+        shortestEdge = std::min(shortestEdge, edge);
+      }
+      largestError = std::max(
+        largestError, glm::distance(position, round(position))
+      );
+    }
+    if (largestError > shortestEdge/4.f) {
+      distorted++;
+    }
+  }
+  return distorted;
+}
+
+auto isValidLevel(const FileLevel& level, std::size_t fileSize) -> bool {
+  if (
+    level.indexType != GL_UNSIGNED_SHORT && level.indexType != GL_UNSIGNED_INT
+  ) {
+    return false;
+  }
+  const std::size_t indexSize{
+    my::getIndexSize(static_cast<my::IndexType>(level.indexType))
+  };
+  return level.indexCount % 3 == 0
+    && level.vertexOffset % dataAlignment == 0
+    && level.indexOffset % dataAlignment == 0
+    && isValidRange(
+      level.vertexOffset, level.vertexCount, sizeof(my::PackedVertex),
+      fileSize
+    )
+    && isValidRange(level.indexOffset, level.indexCount, indexSize, fileSize);
+}
+
+auto isValidRange(
+  std::uint64_t offset, std::uint64_t count, std::size_t elementSize,
+  std::size_t fileSize
+) -> bool {
+  // Division keeps corrupt counts from overflowing.
+  return offset <= fileSize && count <= (fileSize - offset)/elementSize;
+}
+
+auto alignOffset(std::size_t offset) -> std::size_t {
+  return (offset + dataAlignment - 1)/dataAlignment*dataAlignment;
+}
+
+auto toArray(const glm::vec3& vector) -> std::array<float, 3> {
+  return {vector.x, vector.y, vector.z};
+}
+
+auto toVector(const std::array<float, 3>& array) -> glm::vec3 {
+  return {array[0], array[1], array[2]};
+}
+
+} // namespace
@@ -0,0 +1,87 @@
+#ifndef MESH_FILE_HXX
+#define MESH_FILE_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "bounds.hxx"
+#include "graphics-types.hxx"
+#include "io.hxx"
+#include "models.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Bumped whenever the layout or the vertex format changes; files of any
+// other version are rejected and have to be converted again.
+constexpr std::uint32_t meshFileVersion{2};
+
+// One level of detail, pointing into the file's mapping.
+struct MeshFileLevel {
+  const GLvoid* vertices{};
+  std::size_t vertexCount{};
+  const GLvoid* indices{};
+  std::size_t indexCount{};
+  IndexType indexType{};
+};
+
+// Mesh container written by world-3d-convert. A header with the bounds
+// and placement is followed by a table of levels of detail and then each
+// level's vertices, already packed (PackedVertex) and optimized, and its
+// indices, already narrowed. Every range starts 64-byte aligned, so the
+// mapped bytes go to the GPU exactly as they are on disk.
+//
+// Positions are half floats, so they are stored relative to the center
+// of the bounds, and scaled down by a power of two if they would still
+// overflow; the bounds are in those stored units. getTransform() puts
+// the mesh back where the source model had it.
+//
+// Only the layout is checked on open, not the indices themselves; files
+// are trusted the way shaders are.
+class MeshFile {
+public:
+  static auto open(std::string_view filePath) -> std::optional<MeshFile>;
+  MeshFile() = delete;
+  MeshFile(const MeshFile&) = delete;
+  MeshFile(MeshFile&&) = default;
+  auto operator=(const MeshFile&) -> MeshFile& = delete;
+  auto operator=(MeshFile&&) -> MeshFile& = default;
+
+  auto getBounds() const -> const MeshBounds&;
+  auto getTransform() const -> const glm::mat4&;
+  // Level 0 is full detail; see buildLevelsOfDetail() for the rest.
+  auto getLevelCount() const -> std::size_t;
+  auto getLevel(std::size_t level) const -> const MeshFileLevel&;
+  auto getSize() const -> std::size_t;
+
+private:
+  MappedFile _file;
+  MeshBounds _bounds;
+  glm::mat4 _transform;
+  std::vector<MeshFileLevel> _levels;
+
+  MeshFile(
+    MappedFile file, const MeshBounds& bounds, const glm::mat4& transform,
+    std::vector<MeshFileLevel> levels
+  );
+};
+
+// Fails on positions that aren't finite, and warns about triangles that
+// half floats are too coarse for.
+auto writeMeshFile(
+  std::string_view filePath, const Geometry& geometry,
+  const std::vector<MeshGeometry>& levels
+) -> bool;
+
+} // namespace my
+
+#endif // MESH_FILE_HXX
@@ -1,6 +1,7 @@
 #include "models.hxx"
 
 #include <array>
+#include <utility>
 
 /*
  * Declarations.
@@ -20,7 +21,7 @@ constexpr std::array<GLfloat, 3*3> BasicTriangle_colors{
   0., 0., 1.
 };
 
-constexpr std::array<GLushort, 3*1> BasicTriangle_indices{
+constexpr std::array<GLuint, 3*1> BasicTriangle_indices{
   0, 1, 2
 };
 
@@ -41,7 +42,7 @@ auto my::Geometry::getColorMemorySize() const -> GLsizeiptr {
 }
 
 auto my::Geometry::getIndexMemorySize() const -> GLsizeiptr {
-  return getIndexArraySize()*sizeof(GLushort);
+  return getIndexArraySize()*sizeof(GLuint);
 }
 
 auto my::Geometry::getVertexCount() const -> GLint {
@@ -64,7 +65,7 @@ auto my::BasicTriangle::getColors() const -> const GLfloat* {
   return BasicTriangle_colors.data();
 }
 
-auto my::BasicTriangle::getIndices() const -> const GLushort* {
+auto my::BasicTriangle::getIndices() const -> const GLuint* {
   return BasicTriangle_indices.data();
 }
 
@@ -79,3 +80,34 @@ auto my::BasicTriangle::getColorArraySize() const -> GLint {
 auto my::BasicTriangle::getIndexArraySize() const -> GLint {
   return BasicTriangle_indices.size();
 }
+
+my::MeshGeometry::MeshGeometry(
+  std::vector<GLfloat> vertices, std::vector<GLfloat> colors,
+  std::vector<GLuint> indices
+)
+: _vertices{std::move(vertices)}, _colors{std::move(colors)},
+  _indices{std::move(indices)} {}
+
+auto my::MeshGeometry::getVertices() const -> const GLfloat* {
+  return _vertices.data();
+}
+
+auto my::MeshGeometry::getColors() const -> const GLfloat* {
+  return _colors.data();
+}
+
+auto my::MeshGeometry::getIndices() const -> const GLuint* {
+  return _indices.data();
+}
+
+auto my::MeshGeometry::getVertexArraySize() const -> GLint {
+  return static_cast<GLint>(_vertices.size());
+}
+
+auto my::MeshGeometry::getColorArraySize() const -> GLint {
+  return static_cast<GLint>(_colors.size());
+}
+
+auto my::MeshGeometry::getIndexArraySize() const -> GLint {
+  return static_cast<GLint>(_indices.size());
+}
@@ -2,6 +2,7 @@
 #define MODELS_HXX
 
 #include <cstddef>
+#include <vector>
 
 #include <glad/gl.h>
 
@@ -15,7 +16,7 @@ class Geometry {
 public:
   virtual auto getVertices() const -> const GLfloat* = 0;
   virtual auto getColors() const -> const GLfloat* = 0;
-  virtual auto getIndices() const -> const GLushort* = 0;
+  virtual auto getIndices() const -> const GLuint* = 0;
   virtual auto getVertexArraySize() const -> GLint = 0;
   virtual auto getColorArraySize() const -> GLint = 0;
   virtual auto getIndexArraySize() const -> GLint = 0;
@@ -32,12 +33,34 @@ class BasicTriangle : public Geometry {
 public:
   auto getVertices() const -> const GLfloat* final;
   auto getColors() const -> const GLfloat* final;
-  auto getIndices() const -> const GLushort* final;
+  auto getIndices() const -> const GLuint* final;
   auto getVertexArraySize() const -> GLint final;
   auto getColorArraySize() const -> GLint final;
   auto getIndexArraySize() const -> GLint final;
 };
 
+// Geometry built at run time, such as simplified levels of detail.
+class MeshGeometry : public Geometry {
+public:
+  MeshGeometry() = default;
+  MeshGeometry(
+    std::vector<GLfloat> vertices, std::vector<GLfloat> colors,
+    std::vector<GLuint> indices
+  );
+
+  auto getVertices() const -> const GLfloat* final;
+  auto getColors() const -> const GLfloat* final;
+  auto getIndices() const -> const GLuint* final;
+  auto getVertexArraySize() const -> GLint final;
+  auto getColorArraySize() const -> GLint final;
+  auto getIndexArraySize() const -> GLint final;
+
+private:
+  std::vector<GLfloat> _vertices{};
+  std::vector<GLfloat> _colors{};
+  std::vector<GLuint> _indices{};
+};
+
 } // namespace my
 
 #endif // MODELS_HXX
@@ -0,0 +1,317 @@
+#include "noise.hxx"
+
+#include <cmath>
+
+#include "simd.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto hash(std::int32_t x, std::int32_t y, std::uint32_t seed)
+-> std::uint32_t;
+auto fade(float t) -> float;
+auto gradient(std::uint32_t bits, float x, float y) -> float;
+auto gradientNoise(float x, float y, std::uint32_t seed) -> float;
+#ifdef USE_SSE
+auto multiply(__m128i a, __m128i b) -> __m128i;
+auto hash(__m128i x, __m128i y, std::uint32_t seed) -> __m128i;
+auto gradient(__m128i bits, __m128 x, __m128 y) -> __m128;
+auto gradientNoise(__m128 x, __m128 y, std::uint32_t seed) -> __m128;
+auto sampleFractal(const my::NoiseSettings& settings, __m128 x, __m128 y)
+-> __m128;
+#endif // USE_SSE
+#ifdef USE_AVX
+auto hash(__m256i x, __m256i y, std::uint32_t seed) -> __m256i;
+auto gradient(__m256i bits, __m256 x, __m256 y) -> __m256;
+auto gradientNoise(__m256 x, __m256 y, std::uint32_t seed) -> __m256;
+auto sampleFractal(const my::NoiseSettings& settings, __m256 x, __m256 y)
+-> __m256;
+#endif // USE_AVX
+
+constexpr std::uint32_t primeX{0x9e3779b1u};
+constexpr std::uint32_t primeY{0x85ebca77u};
+constexpr std::uint32_t mixer{0x27d4eb2du};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::sampleNoise(const NoiseSettings& settings, float x, float y)
+-> float {
+  float value{};
+  float amplitude{1.f};
+  float frequency{settings.frequency};
+  float total{};
+  for (int octave{}; octave < settings.octaves; octave++) {
+    const auto seed{settings.seed + static_cast<std::uint32_t>(octave)};
+    value += amplitude*gradientNoise(x*frequency, y*frequency, seed);
+    total += amplitude;
+    amplitude *= settings.gain;
+    frequency *= settings.lacunarity;
+  }
+  return value/total;
+}
+
+auto my::sampleNoiseGrid(
+  const NoiseSettings& settings, float x, float y, float spacing,
+  int width, int height, float* samples
+) -> void {
+  for (int row{}; row < height; row++) {
+    const float sampleY{y + static_cast<float>(row)*spacing};
+    float* rowSamples{samples + static_cast<std::ptrdiff_t>(row*width)};
+    int column{};
+#ifdef USE_AVX
+    for (; column + 8 <= width; column += 8) {
+      const __m256 columns{_mm256_cvtepi32_ps(_mm256_add_epi32(
+        _mm256_set1_epi32(column), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+      ))};
+      const __m256 sampleX{_mm256_add_ps(
+        _mm256_set1_ps(x), _mm256_mul_ps(columns, _mm256_set1_ps(spacing))
+      )};
+      _mm256_storeu_ps(
+        rowSamples + column,
+        sampleFractal(settings, sampleX, _mm256_set1_ps(sampleY))
+      );
+    }
+#endif // USE_AVX
+#ifdef USE_SSE
+    for (; column + 4 <= width; column += 4) {
+      const __m128 columns{_mm_cvtepi32_ps(_mm_add_epi32(
+        _mm_set1_epi32(column), _mm_setr_epi32(0, 1, 2, 3)
+      ))};
+      const __m128 sampleX{_mm_add_ps(
+        _mm_set1_ps(x), _mm_mul_ps(columns, _mm_set1_ps(spacing))
+      )};
+      _mm_storeu_ps(
+        rowSamples + column,
+        sampleFractal(settings, sampleX, _mm_set1_ps(sampleY))
+      );
+    }
+#endif // USE_SSE
+    for (; column < width; column++) {
+      rowSamples[column] = sampleNoise(
+        settings, x + static_cast<float>(column)*spacing, sampleY
+      );
+    }
+  }
+}
+
+namespace {
+
+auto hash(std::int32_t x, std::int32_t y, std::uint32_t seed)
+-> std::uint32_t {
+  std::uint32_t result{
+    seed ^ static_cast<std::uint32_t>(x)*primeX
+    ^ static_cast<std::uint32_t>(y)*primeY
+  };
+  result *= mixer;
+  return result ^ result >> 15;
+}
+
+auto fade(float t) -> float {
+  return t*t*t*(t*(t*6.f - 15.f) + 10.f);
+}
+
+auto gradient(std::uint32_t bits, float x, float y) -> float {
+  // One of the four diagonals, picked by the two low bits.
+  return (bits & 1 ? -x : x) + (bits & 2 ? -y : y);
+}
+
+auto gradientNoise(float x, float y, std::uint32_t seed) -> float {
+  const float floorX{std::floor(x)};
+  const float floorY{std::floor(y)};
+  const auto cellX{static_cast<std::int32_t>(floorX)};
+  const auto cellY{static_cast<std::int32_t>(floorY)};
+  const float dx{x - floorX};
+  const float dy{y - floorY};
+  const float n00{gradient(hash(cellX, cellY, seed), dx, dy)};
+  const float n10{gradient(hash(cellX + 1, cellY, seed), dx - 1.f, dy)};
+  const float n01{gradient(hash(cellX, cellY + 1, seed), dx, dy - 1.f)};
+  const float n11{
+    gradient(hash(cellX + 1, cellY + 1, seed), dx - 1.f, dy - 1.f)
+  };
+  const float u{fade(dx)};
+  const float v{fade(dy)};
+  const float bottom{n00 + u*(n10 - n00)};
+  const float top{n01 + u*(n11 - n01)};
+  return bottom + v*(top - bottom);
+}
+
+#ifdef USE_SSE
+auto multiply(__m128i a, __m128i b) -> __m128i {
+  // SSE2 has no 32-bit low multiply; do even and odd lanes as 64-bit
+  // products and interleave their low halves.
+  const __m128i even{_mm_mul_epu32(a, b)};
+  const __m128i odd{
+    _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32))
+  };
+  return _mm_unpacklo_epi32(
+    _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+  );
+}
+
+auto hash(__m128i x, __m128i y, std::uint32_t seed) -> __m128i {
+  __m128i result{_mm_xor_si128(
+    _mm_set1_epi32(static_cast<int>(seed)),
+    _mm_xor_si128(
+      multiply(x, _mm_set1_epi32(static_cast<int>(primeX))),
+      multiply(y, _mm_set1_epi32(static_cast<int>(primeY)))
+    )
+  )};
+  result = multiply(result, _mm_set1_epi32(static_cast<int>(mixer)));
+  return _mm_xor_si128(result, _mm_srli_epi32(result, 15));
+}
+
+auto gradient(__m128i bits, __m128 x, __m128 y) -> __m128 {
+  const __m128 signX{_mm_castsi128_ps(_mm_slli_epi32(bits, 31))};
+  const __m128 signY{
+    _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(bits, 1), 31))
+  };
+  return _mm_add_ps(_mm_xor_ps(x, signX), _mm_xor_ps(y, signY));
+}
+
+auto gradientNoise(__m128 x, __m128 y, std::uint32_t seed) -> __m128 {
+  const __m128 one{_mm_set1_ps(1.f)};
+  // Floor by truncating and stepping down where that rounded up.
+  __m128 floorX{_mm_cvtepi32_ps(_mm_cvttps_epi32(x))};
+  floorX = _mm_sub_ps(floorX, _mm_and_ps(_mm_cmpgt_ps(floorX, x), one));
+  __m128 floorY{_mm_cvtepi32_ps(_mm_cvttps_epi32(y))};
+  floorY = _mm_sub_ps(floorY, _mm_and_ps(_mm_cmpgt_ps(floorY, y), one));
+  const __m128i cellX{_mm_cvttps_epi32(floorX)};
+  const __m128i cellY{_mm_cvttps_epi32(floorY)};
+  const __m128i nextX{_mm_add_epi32(cellX, _mm_set1_epi32(1))};
+  const __m128i nextY{_mm_add_epi32(cellY, _mm_set1_epi32(1))};
+  const __m128 dx{_mm_sub_ps(x, floorX)};
+  const __m128 dy{_mm_sub_ps(y, floorY)};
+  const __m128 dx1{_mm_sub_ps(dx, one)};
+  const __m128 dy1{_mm_sub_ps(dy, one)};
+  const __m128 n00{gradient(hash(cellX, cellY, seed), dx, dy)};
+  const __m128 n10{gradient(hash(nextX, cellY, seed), dx1, dy)};
+  const __m128 n01{gradient(hash(cellX, nextY, seed), dx, dy1)};
+  const __m128 n11{gradient(hash(nextX, nextY, seed), dx1, dy1)};
+  const auto smooth{[](__m128 t) {
+    const __m128 inner{_mm_add_ps(
+      _mm_mul_ps(
+        t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.f)), _mm_set1_ps(15.f))
+      ),
+      _mm_set1_ps(10.f)
+    )};
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+  }};
+  const __m128 u{smooth(dx)};
+  const __m128 v{smooth(dy)};
+  const __m128 bottom{_mm_add_ps(n00, _mm_mul_ps(u, _mm_sub_ps(n10, n00)))};
+  const __m128 top{_mm_add_ps(n01, _mm_mul_ps(u, _mm_sub_ps(n11, n01)))};
+  return _mm_add_ps(bottom, _mm_mul_ps(v, _mm_sub_ps(top, bottom)));
+}
+
+auto sampleFractal(const my::NoiseSettings& settings, __m128 x, __m128 y)
+-> __m128 {
+  __m128 value{_mm_setzero_ps()};
+  float amplitude{1.f};
+  float frequency{settings.frequency};
+  float total{};
+  for (int octave{}; octave < settings.octaves; octave++) {
+    const __m128 scale{_mm_set1_ps(frequency)};
+    const __m128 noise{gradientNoise(
+      _mm_mul_ps(x, scale), _mm_mul_ps(y, scale),
+      settings.seed + static_cast<std::uint32_t>(octave)
+    )};
+    value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(amplitude), noise));
+    total += amplitude;
+    amplitude *= settings.gain;
+    frequency *= settings.lacunarity;
+  }
+  return _mm_div_ps(value, _mm_set1_ps(total));
+}
+#endif // USE_SSE
+
+#ifdef USE_AVX
+auto hash(__m256i x, __m256i y, std::uint32_t seed) -> __m256i {
+  __m256i result{_mm256_xor_si256(
+    _mm256_set1_epi32(static_cast<int>(seed)),
+    _mm256_xor_si256(
+      _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(primeX))),
+      _mm256_mullo_epi32(y, _mm256_set1_epi32(static_cast<int>(primeY)))
+    )
+  )};
+  result = _mm256_mullo_epi32(
+    result, _mm256_set1_epi32(static_cast<int>(mixer))
+  );
+  return _mm256_xor_si256(result, _mm256_srli_epi32(result, 15));
+}
+
+auto gradient(__m256i bits, __m256 x, __m256 y) -> __m256 {
+  const __m256 signX{_mm256_castsi256_ps(_mm256_slli_epi32(bits, 31))};
+  const __m256 signY{_mm256_castsi256_ps(
+    _mm256_slli_epi32(_mm256_srli_epi32(bits, 1), 31)
+  )};
+  return _mm256_add_ps(_mm256_xor_ps(x, signX), _mm256_xor_ps(y, signY));
+}
+
+auto gradientNoise(__m256 x, __m256 y, std::uint32_t seed) -> __m256 {
+  const __m256 one{_mm256_set1_ps(1.f)};
+  const __m256 floorX{_mm256_floor_ps(x)};
+  const __m256 floorY{_mm256_floor_ps(y)};
+  const __m256i cellX{_mm256_cvttps_epi32(floorX)};
+  const __m256i cellY{_mm256_cvttps_epi32(floorY)};
+  const __m256i nextX{_mm256_add_epi32(cellX, _mm256_set1_epi32(1))};
+  const __m256i nextY{_mm256_add_epi32(cellY, _mm256_set1_epi32(1))};
+  const __m256 dx{_mm256_sub_ps(x, floorX)};
+  const __m256 dy{_mm256_sub_ps(y, floorY)};
+  const __m256 dx1{_mm256_sub_ps(dx, one)};
+  const __m256 dy1{_mm256_sub_ps(dy, one)};
+  const __m256 n00{gradient(hash(cellX, cellY, seed), dx, dy)};
+  const __m256 n10{gradient(hash(nextX, cellY, seed), dx1, dy)};
+  const __m256 n01{gradient(hash(cellX, nextY, seed), dx, dy1)};
+  const __m256 n11{gradient(hash(nextX, nextY, seed), dx1, dy1)};
+  const auto smooth{[](__m256 t) {
+    const __m256 inner{_mm256_add_ps(
+      _mm256_mul_ps(t, _mm256_sub_ps(
+        _mm256_mul_ps(t, _mm256_set1_ps(6.f)), _mm256_set1_ps(15.f)
+      )),
+      _mm256_set1_ps(10.f)
+    )};
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+  }};
+  const __m256 u{smooth(dx)};
+  const __m256 v{smooth(dy)};
+  const __m256 bottom{
+    _mm256_add_ps(n00, _mm256_mul_ps(u, _mm256_sub_ps(n10, n00)))
+  };
+  const __m256 top{
+    _mm256_add_ps(n01, _mm256_mul_ps(u, _mm256_sub_ps(n11, n01)))
+  };
+  return _mm256_add_ps(bottom, _mm256_mul_ps(v, _mm256_sub_ps(top, bottom)));
+}
+
+auto sampleFractal(const my::NoiseSettings& settings, __m256 x, __m256 y)
+-> __m256 {
+  __m256 value{_mm256_setzero_ps()};
+  float amplitude{1.f};
+  float frequency{settings.frequency};
+  float total{};
+  for (int octave{}; octave < settings.octaves; octave++) {
+    const __m256 scale{_mm256_set1_ps(frequency)};
+    const __m256 noise{gradientNoise(
+      _mm256_mul_ps(x, scale), _mm256_mul_ps(y, scale),
+      settings.seed + static_cast<std::uint32_t>(octave)
+    )};
+    value = _mm256_add_ps(
+      value, _mm256_mul_ps(_mm256_set1_ps(amplitude), noise)
+    );
+    total += amplitude;
+    amplitude *= settings.gain;
+    frequency *= settings.lacunarity;
+  }
+  return _mm256_div_ps(value, _mm256_set1_ps(total));
+}
+#endif // USE_AVX
+
+} // namespace
@@ -0,0 +1,35 @@
+#ifndef NOISE_HXX
+#define NOISE_HXX
+
+#include <cstdint>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct NoiseSettings {
+  std::uint32_t seed{};
+  // Cycles per world unit of the first octave.
+  float frequency{1.f/128.f};
+  int octaves{5};
+  // Each octave's frequency and amplitude relative to the one before.
+  float lacunarity{2.f};
+  float gain{.5f};
+};
+
+// Fractal sum of 2D gradient (Perlin) noise, within [-1, 1]. Gradients
+// come from hashing the lattice coordinates rather than a permutation
+// table, so the SIMD paths need no gathers and agree with this one.
+auto sampleNoise(const NoiseSettings& settings, float x, float y) -> float;
+// Fills width x height samples, row by row, spaced `spacing` apart from
+// (x, y); rows are computed 8 (AVX2) or 4 (SSE2) samples at a time.
+auto sampleNoiseGrid(
+  const NoiseSettings& settings, float x, float y, float spacing,
+  int width, int height, float* samples
+) -> void;
+
+} // namespace my
+
+#endif // NOISE_HXX
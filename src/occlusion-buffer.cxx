@@ -0,0 +1,332 @@
+#include "occlusion-buffer.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+#include "simd.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto toWindow(const glm::vec4& clip, int width, int height) -> glm::vec3;
+auto isBehindNear(const glm::vec4& clip) -> bool;
+auto reduceMax(
+  const std::vector<float>& source, int sourceWidth, int sourceHeight,
+  std::vector<float>& destination, int width, int height
+) -> void;
+
+// Clip-space w below this counts as behind the eye.
+constexpr float minW{1e-5f};
+constexpr int simdAlignment{8};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::OcclusionBuffer::OcclusionBuffer(int width, int height)
+: _width{(width + simdAlignment - 1)/simdAlignment*simdAlignment},
+  _height{height} {
+  int levelWidth{_width};
+  int levelHeight{_height};
+  while (true) {
+    _levels.push_back({
+      levelWidth, levelHeight,
+      std::vector<float>(static_cast<std::size_t>(levelWidth*levelHeight), 1.f)
+    });
+    if (levelWidth == 1 && levelHeight == 1) {
+      break;
+    }
+    levelWidth = (levelWidth + 1)/2;
+    levelHeight = (levelHeight + 1)/2;
+  }
+}
+
+auto my::OcclusionBuffer::clear(const glm::mat4& viewProjection) -> void {
+  _viewProjection = viewProjection;
+  std::fill(_levels[0].depths.begin(), _levels[0].depths.end(), 1.f);
+}
+
+auto my::OcclusionBuffer::rasterize(
+  const std::vector<glm::vec3>& positions,
+  const std::vector<GLuint>& indices, const glm::mat4& modelMatrix
+) -> void {
+  const glm::mat4 transform{_viewProjection*modelMatrix};
+  _screenPositions.resize(positions.size());
+  _behindNear.resize(positions.size());
+  for (std::size_t i{}; i < positions.size(); i++) {
+    const glm::vec4 clip{transform*glm::vec4{positions[i], 1.f}};
+    _behindNear[i] = isBehindNear(clip);
+    if (!_behindNear[i]) {
+      _screenPositions[i] = toWindow(clip, _width, _height);
+    }
+  }
+  for (std::size_t i{}; i + 2 < indices.size(); i += 3) {
+    if (
+      _behindNear[indices[i]] || _behindNear[indices[i + 1]]
+      || _behindNear[indices[i + 2]]
+    ) {
+      continue;
+    }
+    rasterizeTriangle(
+      _screenPositions[indices[i]], _screenPositions[indices[i + 1]],
+      _screenPositions[indices[i + 2]]
+    );
+  }
+}
+
+auto my::OcclusionBuffer::buildHierarchy() -> void {
+  for (std::size_t i{1}; i < _levels.size(); i++) {
+    const Level& source{_levels[i - 1]};
+    Level& destination{_levels[i]};
+    reduceMax(
+      source.depths, source.width, source.height, destination.depths,
+      destination.width, destination.height
+    );
+  }
+}
+
+auto my::OcclusionBuffer::isOccluded(const BoundingBox& box) const -> bool {
+  glm::vec3 min{static_cast<float>(_width), static_cast<float>(_height), 1.f};
+  glm::vec3 max{0.f};
+  for (int corner{}; corner < 8; corner++) {
+    const glm::vec3 position{
+      box.center.x + (corner & 1 ? box.extent.x : -box.extent.x),
+      box.center.y + (corner & 2 ? box.extent.y : -box.extent.y),
+      box.center.z + (corner & 4 ? box.extent.z : -box.extent.z)
+    };
+    const glm::vec4 clip{_viewProjection*glm::vec4{position, 1.f}};
+    if (isBehindNear(clip)) {
+      return false;
+    }
+    const glm::vec3 window{toWindow(clip, _width, _height)};
+    min = glm::min(min, window);
+    max = glm::max(max, window);
+  }
+  const int x0{std::max(0, static_cast<int>(std::floor(min.x)))};
+  const int y0{std::max(0, static_cast<int>(std::floor(min.y)))};
+  const int x1{std::min(_width - 1, static_cast<int>(std::floor(max.x)))};
+  const int y1{std::min(_height - 1, static_cast<int>(std::floor(max.y)))};
+  if (x0 > x1 || y0 > y1) {
+    return false;
+  }
+  // Go up the pyramid until the rectangle spans at most 2x2 texels.
+  std::size_t level{};
+  while (
+    level + 1 < _levels.size()
+    && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+  ) {
+    level++;
+  }
+  const Level& hierarchy{_levels[level]};
+  for (int y{y0 >> level}; y <= y1 >> level; y++) {
+    for (int x{x0 >> level}; x <= x1 >> level; x++) {
+      if (hierarchy.depths[static_cast<std::size_t>(y*hierarchy.width + x)]
+        >= min.z) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+auto my::OcclusionBuffer::getWidth() const -> int {
+  return _width;
+}
+
+auto my::OcclusionBuffer::getHeight() const -> int {
+  return _height;
+}
+
+auto my::OcclusionBuffer::getLevelCount() const -> std::size_t {
+  return _levels.size();
+}
+
+auto my::OcclusionBuffer::getDepth(std::size_t level, int x, int y) const
+-> float {
+  const Level& hierarchy{_levels.at(level)};
+  return hierarchy.depths.at(static_cast<std::size_t>(y*hierarchy.width + x));
+}
+
+auto my::OcclusionBuffer::rasterizeTriangle(
+  glm::vec3 a, glm::vec3 b, glm::vec3 c
+) -> void {
+  float area{(b.x - a.x)*(c.y - a.y) - (b.y - a.y)*(c.x - a.x)};
+  if (area == 0.f) {
+    return;
+  }
+  // Occluders are treated as two-sided; wind everything one way.
+  if (area < 0.f) {
+    std::swap(b, c);
+    area = -area;
+  }
+  const int xStart{std::max(0, static_cast<int>(std::floor(
+    std::min({a.x, b.x, c.x})
+  )))};
+  const int yStart{std::max(0, static_cast<int>(std::floor(
+    std::min({a.y, b.y, c.y})
+  )))};
+  const int xEnd{std::min(_width - 1, static_cast<int>(std::ceil(
+    std::max({a.x, b.x, c.x})
+  )) - 1)};
+  const int yEnd{std::min(_height - 1, static_cast<int>(std::ceil(
+    std::max({a.y, b.y, c.y})
+  )) - 1)};
+  if (xStart > xEnd || yStart > yEnd) {
+    return;
+  }
+
+  // Edge functions e = A*x + B*y + C, positive inside, sampled at pixel
+  // centers so that triangles sharing an edge leave no gaps between them.
+  // Depth is taken at the far corner of the pixel, clamped to the
+  // triangle's far vertex.
+  const std::array<glm::vec3, 3> vertices{a, b, c};
+  std::array<float, 3> edgeA{};
+  std::array<float, 3> edgeB{};
+  std::array<float, 3> edgeC{};
+  for (std::size_t i{}; i < 3; i++) {
+    const glm::vec3& from{vertices[i]};
+    const glm::vec3& to{vertices[(i + 1) % 3]};
+    edgeA[i] = from.y - to.y;
+    edgeB[i] = to.x - from.x;
+    edgeC[i] = -(edgeA[i]*from.x + edgeB[i]*from.y);
+  }
+  const float depthX{
+    ((b.z - a.z)*(c.y - a.y) - (c.z - a.z)*(b.y - a.y))/area
+  };
+  const float depthY{
+    ((c.z - a.z)*(b.x - a.x) - (b.z - a.z)*(c.x - a.x))/area
+  };
+  const float depthOffset{.5f*(std::abs(depthX) + std::abs(depthY))};
+  const float maxDepth{std::max({a.z, b.z, c.z})};
+
+  std::vector<float>& depths{_levels[0].depths};
+  // Rows start on a multiple of four so the SIMD path can use aligned
+  // groups; the extra pixels fail the edge tests.
+  const int xBegin{xStart & ~3};
+  for (int y{yStart}; y <= yEnd; y++) {
+    const float pixelY{static_cast<float>(y) + .5f};
+    float* row{depths.data() + static_cast<std::size_t>(y*_width)};
+    const float firstX{static_cast<float>(xBegin) + .5f};
+    std::array<float, 3> rowEdge{};
+    for (std::size_t i{}; i < 3; i++) {
+      rowEdge[i] = edgeA[i]*firstX + edgeB[i]*pixelY + edgeC[i];
+    }
+    const float rowDepth{
+      a.z + depthX*(firstX - a.x) + depthY*(pixelY - a.y) + depthOffset
+    };
+#ifdef USE_SSE
+    const __m128 steps{_mm_set_ps(3.f, 2.f, 1.f, 0.f)};
+    // Plain arrays; std::array drops the vector type's alignment attribute.
+    __m128 edge[3];
+    __m128 edgeStep[3];
+    for (std::size_t i{}; i < 3; i++) {
+      edge[i] = _mm_add_ps(
+        _mm_set1_ps(rowEdge[i]), _mm_mul_ps(_mm_set1_ps(edgeA[i]), steps)
+      );
+      edgeStep[i] = _mm_set1_ps(4.f*edgeA[i]);
+    }
+    __m128 depth{_mm_add_ps(
+      _mm_set1_ps(rowDepth), _mm_mul_ps(_mm_set1_ps(depthX), steps)
+    )};
+    const __m128 depthStep{_mm_set1_ps(4.f*depthX)};
+    const __m128 farthest{_mm_set1_ps(maxDepth)};
+    const __m128 zero{_mm_setzero_ps()};
+    for (int x{xBegin}; x <= xEnd; x += 4) {
+      const __m128 covered{_mm_and_ps(
+        _mm_and_ps(
+          _mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)
+        ),
+        _mm_cmpge_ps(edge[2], zero)
+      )};
+      if (_mm_movemask_ps(covered)) {
+        const __m128 previous{_mm_load_ps(row + x)};
+        const __m128 nearer{
+          _mm_min_ps(previous, _mm_min_ps(depth, farthest))
+        };
+        _mm_store_ps(row + x, _mm_or_ps(
+          _mm_and_ps(covered, nearer), _mm_andnot_ps(covered, previous)
+        ));
+      }
+      for (std::size_t i{}; i < 3; i++) {
+        edge[i] = _mm_add_ps(edge[i], edgeStep[i]);
+      }
+      depth = _mm_add_ps(depth, depthStep);
+    }
+#else
+    for (int x{xBegin}; x <= xEnd; x++) {
+      const auto step{static_cast<float>(x - xBegin)};
+      bool covered{true};
+      for (std::size_t i{}; i < 3; i++) {
+        covered = covered && rowEdge[i] + edgeA[i]*step >= 0.f;
+      }
+      if (covered) {
+        row[x] = std::min(row[x], std::min(rowDepth + depthX*step, maxDepth));
+      }
+    }
+#endif // USE_SSE
+  }
+}
+
+namespace {
+
+auto toWindow(const glm::vec4& clip, int width, int height) -> glm::vec3 {
+  const float inverseW{1.f/clip.w};
+  return {
+    (clip.x*inverseW*.5f + .5f)*static_cast<float>(width),
+    (clip.y*inverseW*.5f + .5f)*static_cast<float>(height),
+    clip.z*inverseW*.5f + .5f
+  };
+}
+
+auto isBehindNear(const glm::vec4& clip) -> bool {
+  // GL clips anything in front of the near plane, so it can't occlude
+  // or be tested reliably either.
+  return clip.w < minW || clip.z < -clip.w;
+}
+
+auto reduceMax(
+  const std::vector<float>& source, int sourceWidth, int sourceHeight,
+  std::vector<float>& destination, int width, int height
+) -> void {
+  for (int y{}; y < height; y++) {
+    const float* top{
+      source.data() + static_cast<std::size_t>(2*y*sourceWidth)
+    };
+    const float* bottom{
+      2*y + 1 < sourceHeight ? top + sourceWidth : top
+    };
+    float* row{destination.data() + static_cast<std::size_t>(y*width)};
+    int x{};
+#ifdef USE_SSE
+    // Eight source texels from each of the two rows make four results.
+    for (; 2*x + 8 <= sourceWidth; x += 4) {
+      const __m128 left{_mm_max_ps(
+        _mm_loadu_ps(top + 2*x), _mm_loadu_ps(bottom + 2*x)
+      )};
+      const __m128 right{_mm_max_ps(
+        _mm_loadu_ps(top + 2*x + 4), _mm_loadu_ps(bottom + 2*x + 4)
+      )};
+      _mm_storeu_ps(row + x, _mm_max_ps(
+        _mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0)),
+        _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1))
+      ));
+    }
+#endif // USE_SSE
+    for (; x < width; x++) {
+      float depth{std::max(top[2*x], bottom[2*x])};
+      if (2*x + 1 < sourceWidth) {
+        depth = std::max({depth, top[2*x + 1], bottom[2*x + 1]});
+      }
+      row[x] = depth;
+    }
+  }
+}
+
+} // namespace
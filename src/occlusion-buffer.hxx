@@ -0,0 +1,74 @@
+#ifndef OCCLUSION_BUFFER_HXX
+#define OCCLUSION_BUFFER_HXX
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "bounds.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Low-resolution depth buffer rasterized on the CPU from a few large
+// occluders, with a max-depth pyramid (Hi-Z) over it for testing boxes.
+// Occluders are sampled at pixel centers like the GPU does, but write the
+// furthest depth they reach within each pixel, and boxes are tested
+// against the furthest depth over every texel they touch; short of
+// sub-pixel slivers at occluder silhouettes, a box is never reported
+// hidden when any part of it could be seen.
+//
+// Depths are window-space, 0 at the near plane and 1 at the far plane.
+class OcclusionBuffer {
+public:
+  // The width is rounded up to a multiple of 8 for the SIMD paths.
+  OcclusionBuffer(int width, int height);
+  OcclusionBuffer() = delete;
+  OcclusionBuffer(const OcclusionBuffer&) = delete;
+  OcclusionBuffer(OcclusionBuffer&&) = delete;
+  auto operator=(const OcclusionBuffer&) -> OcclusionBuffer& = delete;
+  auto operator=(OcclusionBuffer&&) -> OcclusionBuffer& = delete;
+
+  auto clear(const glm::mat4& viewProjection) -> void;
+  // Triangles crossing the near plane are skipped rather than clipped,
+  // which only ever loses occlusion.
+  auto rasterize(
+    const std::vector<glm::vec3>& positions,
+    const std::vector<GLuint>& indices, const glm::mat4& modelMatrix
+  ) -> void;
+  // Call after the last rasterize() and before testing.
+  auto buildHierarchy() -> void;
+  auto isOccluded(const BoundingBox& box) const -> bool;
+  auto getWidth() const -> int;
+  auto getHeight() const -> int;
+  // Levels of the pyramid, down to 1x1; each halves the one before,
+  // rounding up.
+  auto getLevelCount() const -> std::size_t;
+  auto getDepth(std::size_t level, int x, int y) const -> float;
+
+private:
+  struct Level {
+    int width{};
+    int height{};
+    std::vector<float> depths{};
+  };
+
+  int _width;
+  int _height;
+  glm::mat4 _viewProjection{1.};
+  // Level 0 is the depth buffer itself.
+  std::vector<Level> _levels{};
+  std::vector<glm::vec3> _screenPositions{};
+  std::vector<bool> _behindNear{};
+
+  auto rasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c) -> void;
+};
+
+} // namespace my
+
+#endif // OCCLUSION_BUFFER_HXX
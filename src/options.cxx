@@ -0,0 +1,142 @@
+#include "options.hxx"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+#ifdef USE_EGL
+// Offscreen rendering has no window to close, so it always runs a
+// fixed number of frames.
+constexpr int defaultHeadlessFrames{600};
+#endif // USE_EGL
+
+auto parsePositiveInt(std::string_view name, const char* value) -> int;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::parseOptions(int argc, char** argv) -> Options {
+  Options options{};
+  for (int i{1}; i < argc; i++) {
+    const std::string_view argument{argv[i]};
+    if (argument == "--frames") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --frames"};
+      }
+      options.frames = parsePositiveInt(argument, argv[++i]);
+    } else if (argument == "--tick-rate") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --tick-rate"};
+      }
+      options.tickRate = parsePositiveInt(argument, argv[++i]);
+    } else if (argument == "--objects") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --objects"};
+      }
+      options.objects = static_cast<std::size_t>(
+        parsePositiveInt(argument, argv[++i])
+      );
+    } else if (argument == "--chunks") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --chunks"};
+      }
+      options.chunks = parsePositiveInt(argument, argv[++i]);
+    } else if (argument == "--terrain") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --terrain"};
+      }
+      options.terrain = parsePositiveInt(argument, argv[++i]);
+    } else if (argument == "--mesh") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --mesh"};
+      }
+      options.mesh = argv[++i];
+    } else if (argument == "--terrain-budget") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --terrain-budget"};
+      }
+      options.terrainBudget = parsePositiveInt(argument, argv[++i]);
+    } else if (argument == "--fly") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --fly"};
+      }
+      options.flySpeed = parsePositiveInt(argument, argv[++i]);
+    } else if (argument == "--trace") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --trace"};
+      }
+      options.trace = argv[++i];
+    } else if (argument == "--log-level") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --log-level"};
+      }
+      options.logLevel = my::parseLogLevel(argv[++i]);
+      if (!options.logLevel) {
+        throw std::runtime_error{
+          "Invalid value for --log-level: " + std::string{argv[i]}
+        };
+      }
+    } else if (argument == "--log-file") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --log-file"};
+      }
+      options.logFile = argv[++i];
+    } else if (argument == "--program-cache") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error{"Missing value for --program-cache"};
+      }
+      options.programCache = argv[++i];
+    } else if (argument == "--no-program-cache") {
+      options.programCache.clear();
+    } else if (argument == "--fog") {
+      options.fog = true;
+    } else if (argument == "--hot-reload") {
+      options.shaderHotReload = true;
+    } else if (argument == "--no-instancing") {
+      options.instancing = false;
+    } else if (argument == "--no-lod") {
+      options.levelsOfDetail = false;
+    } else if (argument == "--no-occlusion") {
+      options.occlusion = false;
+    } else {
+      throw std::runtime_error{
+        "Unknown option: " + std::string{argument}
+      };
+    }
+  }
+#ifdef USE_EGL
+  if (!options.frames) {
+    options.frames = defaultHeadlessFrames;
+  }
+#endif // USE_EGL
+  return options;
+}
+
+namespace {
+
+auto parsePositiveInt(std::string_view name, const char* value) -> int {
+  std::size_t length{};
+  int result{};
+  try {
+    result = std::stoi(value, &length);
+  } catch (const std::exception&) {
+    length = 0;
+  }
+  if (length == 0 || value[length] != '\0' || result <= 0) {
+    throw std::runtime_error{
+      "Invalid value for " + std::string{name} + ": " + value
+    };
+  }
+  return result;
+}
+
+} // namespace
@@ -0,0 +1,58 @@
+#ifndef OPTIONS_HXX
+#define OPTIONS_HXX
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "logger.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct Options {
+  // Run this many frames, then exit and report frame timings.
+  std::optional<int> frames{};
+  // Simulation ticks per second, independent of the frame rate.
+  double tickRate{60.};
+  // Number of objects in the scene, for benchmarking larger scenes.
+  std::size_t objects{1};
+  // Mesh file to draw the objects with instead of the built-in triangle.
+  std::optional<std::string> mesh{};
+  // Draw repeated meshes with one instanced draw call each.
+  bool instancing{true};
+  // Skip objects hidden behind nearer ones, tested on the CPU.
+  bool occlusion{true};
+  // Draw distant meshes at their simplified levels of detail.
+  bool levelsOfDetail{true};
+  // Fade distant geometry into the background.
+  bool fog{};
+  // Rebuild the shaders whenever their files change.
+  bool shaderHotReload{};
+  // Directory to cache linked shader programs in; empty disables it.
+  std::string programCache{".program-cache"};
+  // Side length, in chunks, of a test voxel world; zero leaves it out.
+  int chunks{};
+  // Load radius, in tiles, of streamed terrain; zero leaves it out.
+  int terrain{};
+  // Memory budget for terrain tiles, in MiB.
+  int terrainBudget{64};
+  // Camera speed forward, in world units per second.
+  int flySpeed{};
+  // Profile from the start and write a trace here on exit.
+  std::optional<std::string> trace{};
+  // Least severe messages to log; by default, info in debug builds and
+  // warnings otherwise.
+  std::optional<LogLevel> logLevel{};
+  // Where to log to as well as the console.
+  std::optional<std::string> logFile{};
+};
+
+auto parseOptions(int argc, char** argv) -> Options;
+
+} // namespace my
+
+#endif // OPTIONS_HXX
@@ -0,0 +1,166 @@
+#include "profiler.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+
+/*
+ * Declarations.
+ */
+
+auto my::Profiler::writeTrace(const std::string& filePath) -> bool {
+  std::ofstream file{filePath};
+  if (!file) {
+    return false;
+  }
+  writeTrace(file);
+  file.close();
+  return !file.fail();
+}
+
+namespace {
+
+auto writeString(std::ostream& out, const char* string) -> void;
+
+thread_local my::ProfileTrack* threadTrack{};
+// Until the thread records anything, which is when its track is added.
+thread_local std::string threadName{};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::ProfileTrack::ProfileTrack(std::string name)
+: _name{std::move(name)}, _slots{std::make_unique<Slot[]>(_capacity)} {}
+
+auto my::ProfileTrack::record(
+  const char* name, std::int64_t start, std::int64_t end
+) -> void {
+  const std::uint64_t index{_count.load(std::memory_order_relaxed)};
+  Slot& slot{_slots[index % _capacity]};
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start.store(start, std::memory_order_relaxed);
+  slot.end.store(end, std::memory_order_relaxed);
+  _count.store(index + 1, std::memory_order_release);
+}
+
+auto my::ProfileTrack::read(std::vector<ProfileEvent>& events) const
+-> void {
+  const std::uint64_t count{_count.load(std::memory_order_acquire)};
+  const std::uint64_t first{count > _capacity ? count - _capacity : 0};
+  const std::size_t offset{events.size()};
+  for (std::uint64_t index{first}; index < count; index++) {
+    const Slot& slot{_slots[index % _capacity]};
+    events.push_back({
+      slot.name.load(std::memory_order_relaxed),
+      slot.start.load(std::memory_order_relaxed),
+      slot.end.load(std::memory_order_relaxed)
+    });
+  }
+  // Whatever the recording thread got to while this was reading, and
+  // the slot it may be writing now, may have been the oldest of those
+  // read; they go.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const std::uint64_t reused{_count.load(std::memory_order_relaxed) + 1};
+  if (reused - first > _capacity) {
+    const auto overwritten{static_cast<std::ptrdiff_t>(
+      std::min(reused - first - _capacity, count - first)
+    )};
+    const auto begin{events.begin() + static_cast<std::ptrdiff_t>(offset)};
+    events.erase(begin, begin + overwritten);
+  }
+}
+
+auto my::ProfileTrack::getName() const -> const std::string& {
+  return _name;
+}
+
+auto my::Profiler::setEnabled(bool enabled) -> void {
+  _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto my::Profiler::getThreadTrack() -> ProfileTrack& {
+  if (!threadTrack) {
+    std::string name{threadName};
+    if (name.empty()) {
+      const std::lock_guard<std::mutex> lock{_tracksMutex};
+      name = "Thread " + std::to_string(_tracks.size());
+    }
+    threadTrack = &addTrack(std::move(name));
+  }
+  return *threadTrack;
+}
+
+auto my::Profiler::addTrack(std::string name) -> ProfileTrack& {
+  auto track{std::make_unique<ProfileTrack>(std::move(name))};
+  ProfileTrack& added{*track};
+  const std::lock_guard<std::mutex> lock{_tracksMutex};
+  _tracks.push_back(std::move(track));
+  return added;
+}
+
+auto my::Profiler::nameThread(std::string name) -> void {
+  threadName = std::move(name);
+}
+
+auto my::Profiler::writeTrace(std::ostream& out) -> void {
+  std::vector<const ProfileTrack*> tracks{};
+  {
+    const std::lock_guard<std::mutex> lock{_tracksMutex};
+    for (const auto& track : _tracks) {
+      tracks.push_back(track.get());
+    }
+  }
+  std::vector<std::vector<ProfileEvent>> events(tracks.size());
+  std::int64_t origin{now()};
+  for (std::size_t i{}; i < tracks.size(); i++) {
+    tracks[i]->read(events[i]);
+    for (const auto& event : events[i]) {
+      origin = std::min(origin, event.start);
+    }
+  }
+
+  // Complete ("X") events with times in microseconds, one thread of one
+  // process per track.
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  const char* separator{"\n"};
+  out << std::fixed << std::setprecision(3);
+  for (std::size_t i{}; i < tracks.size(); i++) {
+    out << separator << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << i;
+    out << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+    writeString(out, tracks[i]->getName().c_str());
+    out << "}}";
+    separator = ",\n";
+    for (const auto& event : events[i]) {
+      out << separator << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << i;
+      out << ",\"name\":";
+      writeString(out, event.name);
+      out << ",\"ts\":" << static_cast<double>(event.start - origin)/1e3;
+      out << ",\"dur\":" << static_cast<double>(event.end - event.start)/1e3;
+      out << '}';
+    }
+  }
+  out << "\n]}\n";
+  out << std::defaultfloat << std::setprecision(6);
+}
+
+namespace {
+
+auto writeString(std::ostream& out, const char* string) -> void {
+  out << '"';
+  for (const char* c{string}; c && *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      out << '\\' << *c;
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      out << ' ';
+    } else {
+      out << *c;
+    }
+  }
+  out << '"';
+}
+
+} // namespace
@@ -0,0 +1,200 @@
+#include "program-cache.hxx"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "io.hxx"
+#include "logger.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Precedes the binary in each cache file.
+struct FileHeader {
+  char magic[4];
+  std::uint32_t version;
+  // Checked against the file name, in case of a copied or renamed file.
+  std::uint64_t key;
+  std::uint32_t format;
+  std::uint32_t length;
+};
+
+// 64-bit FNV-1a, over the length and then the bytes, so that where one
+// string ends and the next begins is part of the hash.
+auto hashString(std::uint64_t hash, std::string_view string)
+-> std::uint64_t;
+auto getDriverString() -> std::string;
+
+constexpr char fileMagic[4]{'W', '3', 'D', 'P'};
+constexpr std::uint32_t fileVersion{1};
+constexpr std::uint64_t hashBasis{0xcbf29ce484222325};
+constexpr std::uint64_t hashPrime{0x100000001b3};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::ProgramCache::ProgramCache(std::string directory)
+: _directory{std::move(directory)} {
+  if (_directory.empty()) {
+    return;
+  }
+  GLint formatCount{};
+  if (GLAD_GL_ARB_get_program_binary) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  }
+  std::error_code error{};
+  std::filesystem::create_directories(_directory, error);
+  if (formatCount == 0 || error) {
+    LOG_WARNING("Shader program cache unavailable");
+    _directory.clear();
+    return;
+  }
+  _driver = getDriverString();
+}
+
+auto my::ProgramCache::build(
+  std::string_view vertexSource, std::string_view fragmentSource
+) -> ShaderProgram {
+  const auto start{std::chrono::steady_clock::now()};
+  const auto finish{[&]() {
+    const std::chrono::duration<double, std::milli> time{
+      std::chrono::steady_clock::now() - start
+    };
+    _stats.milliseconds += time.count();
+  }};
+  const std::uint64_t key{getKey(vertexSource, fragmentSource)};
+  if (!_directory.empty()) {
+    std::optional<ShaderProgram> program{load(key)};
+    if (program) {
+      _stats.loaded++;
+      finish();
+      return std::move(*program);
+    }
+  }
+  const Shader vertexShader{ShaderType::Vertex, vertexSource};
+  const Shader fragmentShader{ShaderType::Fragment, fragmentSource};
+  ShaderProgram program{vertexShader, fragmentShader};
+  if (!_directory.empty()) {
+    store(key, program);
+  }
+  _stats.compiled++;
+  finish();
+  return program;
+}
+
+auto my::ProgramCache::getStats() const -> const ProgramCacheStats& {
+  return _stats;
+}
+
+auto my::ProgramCache::getKey(
+  std::string_view vertexSource, std::string_view fragmentSource
+) const -> std::uint64_t {
+  std::uint64_t hash{hashBasis};
+  hash = hashString(hash, _driver);
+  hash = hashString(hash, vertexSource);
+  hash = hashString(hash, fragmentSource);
+  return hash;
+}
+
+auto my::ProgramCache::getPath(std::uint64_t key) const -> std::string {
+  constexpr char digits[]{"0123456789abcdef"};
+  std::string name(16, '0');
+  for (std::size_t i{}; i < name.size(); i++) {
+    name[name.size() - 1 - i] = digits[(key >> (i*4)) & 0xf];
+  }
+  return _directory + '/' + name + ".bin";
+}
+
+auto my::ProgramCache::load(std::uint64_t key) const
+-> std::optional<ShaderProgram> {
+  const std::string path{getPath(key)};
+  std::error_code error{};
+  if (!std::filesystem::exists(path, error)) {
+    return {};
+  }
+  const std::optional<std::string> contents{readFile(path)};
+  if (!contents || contents->size() < sizeof(FileHeader)) {
+    return {};
+  }
+  FileHeader header{};
+  std::memcpy(&header, contents->data(), sizeof(header));
+  if (
+    std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0
+    || header.version != fileVersion || header.key != key
+    || header.length != contents->size() - sizeof(header)
+  ) {
+    LOG_WARNING("Ignoring malformed program cache file: {}", path);
+    return {};
+  }
+  // A driver that changed without saying so in its version string is
+  // the one case the key misses; the binary is then just rejected.
+  std::optional<ShaderProgram> program{ShaderProgram::fromBinary(
+    header.format, contents->data() + sizeof(header),
+    static_cast<GLsizei>(header.length)
+  )};
+  if (!program) {
+    LOG_INFO("Driver rejected cached program: {}", path);
+  }
+  return program;
+}
+
+auto my::ProgramCache::store(std::uint64_t key, const ShaderProgram& program)
+const -> void {
+  const std::optional<ProgramBinary> binary{program.getBinary()};
+  if (!binary) {
+    return;
+  }
+  FileHeader header{};
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version = fileVersion;
+  header.key = key;
+  header.format = binary->format;
+  header.length = static_cast<std::uint32_t>(binary->data.size());
+  std::vector<std::byte> contents(sizeof(header) + binary->data.size());
+  std::memcpy(contents.data(), &header, sizeof(header));
+  std::memcpy(
+    contents.data() + sizeof(header), binary->data.data(), binary->data.size()
+  );
+  writeFile(getPath(key), contents.data(), contents.size());
+}
+
+namespace {
+
+auto hashString(std::uint64_t hash, std::string_view string)
+-> std::uint64_t {
+  const auto hashByte{[&](unsigned char byte) {
+    hash = (hash ^ byte)*hashPrime;
+  }};
+  const std::uint64_t length{string.size()};
+  for (std::size_t i{}; i < sizeof(length); i++) {
+    hashByte(static_cast<unsigned char>(length >> (i*8)));
+  }
+  for (const char c : string) {
+    hashByte(static_cast<unsigned char>(c));
+  }
+  return hash;
+}
+
+auto getDriverString() -> std::string {
+  std::string driver{};
+  for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    const GLubyte* value{glGetString(name)};
+    if (value) {
+      driver += reinterpret_cast<const char*>(value);
+    }
+    driver += '\n';
+  }
+  return driver;
+}
+
+} // namespace
@@ -0,0 +1,62 @@
+#ifndef PROGRAM_CACHE_HXX
+#define PROGRAM_CACHE_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "graphics-types.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Programs built so far, and the time spent building them: compiling
+// when the cache is cold, loading binaries when it is warm.
+struct ProgramCacheStats {
+  std::size_t loaded{};
+  std::size_t compiled{};
+  double milliseconds{};
+};
+
+// Linked shader programs kept on disk between runs, as the driver's own
+// binaries. Each is keyed by a hash of its sources, defines included,
+// and of the driver, so edits and driver updates both miss. Without
+// GL_ARB_get_program_binary, or binary formats to use with it, every
+// program gets compiled.
+class ProgramCache {
+public:
+  // The directory is created if need be; empty turns the cache off.
+  ProgramCache(std::string directory);
+  ProgramCache() = delete;
+  ProgramCache(const ProgramCache&) = delete;
+  ProgramCache(ProgramCache&&) = delete;
+  auto operator=(const ProgramCache&) -> ProgramCache& = delete;
+  auto operator=(ProgramCache&&) -> ProgramCache& = delete;
+
+  // Loads the binary cached for these sources, or compiles and links
+  // them and caches the result.
+  auto build(std::string_view vertexSource, std::string_view fragmentSource)
+  -> ShaderProgram;
+  auto getStats() const -> const ProgramCacheStats&;
+
+private:
+  std::string _directory;
+  // Vendor, renderer and version.
+  std::string _driver{};
+  ProgramCacheStats _stats{};
+
+  auto getKey(std::string_view vertexSource, std::string_view fragmentSource)
+  const -> std::uint64_t;
+  auto getPath(std::uint64_t key) const -> std::string;
+  auto load(std::uint64_t key) const -> std::optional<ShaderProgram>;
+  auto store(std::uint64_t key, const ShaderProgram& program) const -> void;
+};
+
+} // namespace my
+
+#endif // PROGRAM_CACHE_HXX
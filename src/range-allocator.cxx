@@ -0,0 +1,185 @@
+#include "range-allocator.hxx"
+
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "debug.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto alignOffset(std::size_t offset, std::size_t alignment) -> std::size_t;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::RangeAllocator::RangeAllocator(std::size_t capacity)
+: _capacity{capacity} {
+  reset();
+}
+
+auto my::RangeAllocator::allocate(std::size_t size, std::size_t alignment)
+-> std::optional<std::size_t> {
+  if (size == 0 || alignment == 0) {
+    return {};
+  }
+  // A block that is big enough may still start too far from an aligned
+  // offset, so look on through larger ones.
+  for (auto fit{_freeBySize.lower_bound(size)}; fit != _freeBySize.end();
+       fit++) {
+    const std::size_t blockSize{fit->first};
+    const std::size_t blockOffset{fit->second};
+    const std::size_t offset{alignOffset(blockOffset, alignment)};
+    const std::size_t blockEnd{blockOffset + blockSize};
+    if (offset + size > blockEnd) {
+      continue;
+    }
+    eraseFree(_freeBlocks.find(blockOffset));
+    if (offset > blockOffset) {
+      insertFree(blockOffset, offset - blockOffset);
+    }
+    if (blockEnd > offset + size) {
+      insertFree(offset + size, blockEnd - offset - size);
+    }
+    _allocations.emplace(offset, Allocation{size, alignment});
+    _used += size;
+    return offset;
+  }
+  return {};
+}
+
+auto my::RangeAllocator::free(std::size_t offset) -> void {
+  const auto allocation{_allocations.find(offset)};
+  if (allocation == _allocations.end()) {
+#ifdef DEBUG
+    throw std::runtime_error{"Attempt to free unallocated range"};
+#endif // DEBUG
+    return;
+  }
+  std::size_t start{offset};
+  std::size_t size{allocation->second.size};
+  _used -= size;
+  _allocations.erase(allocation);
+
+  // Merge with the free neighbours on either side.
+  auto next{_freeBlocks.lower_bound(start)};
+  if (next != _freeBlocks.begin()) {
+    const auto previous{std::prev(next)};
+    if (previous->first + previous->second == start) {
+      start = previous->first;
+      size += previous->second;
+      eraseFree(previous);
+    }
+  }
+  next = _freeBlocks.lower_bound(start);
+  if (next != _freeBlocks.end() && start + size == next->first) {
+    size += next->second;
+    eraseFree(next);
+  }
+  insertFree(start, size);
+}
+
+auto my::RangeAllocator::grow(std::size_t capacity) -> void {
+  if (capacity <= _capacity) {
+    return;
+  }
+  // Extend a free block that runs up to the old end, if there is one.
+  std::size_t start{_capacity};
+  if (!_freeBlocks.empty()) {
+    const auto last{std::prev(_freeBlocks.end())};
+    if (last->first + last->second == _capacity) {
+      start = last->first;
+      eraseFree(last);
+    }
+  }
+  insertFree(start, capacity - start);
+  _capacity = capacity;
+}
+
+auto my::RangeAllocator::reset() -> void {
+  _used = 0;
+  _freeBlocks.clear();
+  _allocations.clear();
+  _freeBySize.clear();
+  if (_capacity > 0) {
+    insertFree(0, _capacity);
+  }
+}
+
+auto my::RangeAllocator::compact() -> std::map<std::size_t, std::size_t> {
+  // Ranges only ever move towards the front, so they stay in capacity.
+  std::map<std::size_t, std::size_t> moves{};
+  std::map<std::size_t, Allocation> allocations{};
+  _freeBlocks.clear();
+  _freeBySize.clear();
+  std::size_t end{};
+  for (const auto& [offset, allocation] : _allocations) {
+    const std::size_t newOffset{alignOffset(end, allocation.alignment)};
+    if (newOffset > end) {
+      insertFree(end, newOffset - end);
+    }
+    moves.emplace(offset, newOffset);
+    allocations.emplace(newOffset, allocation);
+    end = newOffset + allocation.size;
+  }
+  if (end < _capacity) {
+    insertFree(end, _capacity - end);
+  }
+  _allocations = std::move(allocations);
+  return moves;
+}
+
+auto my::RangeAllocator::getCapacity() const -> std::size_t {
+  return _capacity;
+}
+
+auto my::RangeAllocator::getStats() const -> RangeAllocatorStats {
+  RangeAllocatorStats stats{};
+  stats.capacity = _capacity;
+  stats.used = _used;
+  stats.freeBlocks = _freeBlocks.size();
+  if (!_freeBySize.empty()) {
+    stats.largestFreeBlock = std::prev(_freeBySize.end())->first;
+  }
+  const std::size_t freeSpace{_capacity - _used};
+  if (freeSpace > 0) {
+    stats.fragmentation = 1.
+      - static_cast<double>(stats.largestFreeBlock)
+      / static_cast<double>(freeSpace);
+  }
+  return stats;
+}
+
+auto my::RangeAllocator::insertFree(std::size_t offset, std::size_t size)
+-> void {
+  _freeBlocks.emplace(offset, size);
+  _freeBySize.emplace(size, offset);
+}
+
+auto my::RangeAllocator::eraseFree(
+  std::map<std::size_t, std::size_t>::iterator block
+) -> void {
+  auto [first, last]{_freeBySize.equal_range(block->second)};
+  for (; first != last; first++) {
+    if (first->second == block->first) {
+      _freeBySize.erase(first);
+      break;
+    }
+  }
+  _freeBlocks.erase(block);
+}
+
+namespace {
+
+auto alignOffset(std::size_t offset, std::size_t alignment) -> std::size_t {
+  return (offset + alignment - 1)/alignment*alignment;
+}
+
+} // namespace
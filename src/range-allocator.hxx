@@ -0,0 +1,65 @@
+#ifndef RANGE_ALLOCATOR_HXX
+#define RANGE_ALLOCATOR_HXX
+
+#include <cstddef>
+#include <map>
+#include <optional>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct RangeAllocatorStats {
+  std::size_t capacity{};
+  std::size_t used{};
+  std::size_t freeBlocks{};
+  std::size_t largestFreeBlock{};
+  // 0 when all free space is one block, approaching 1 as it splinters.
+  double fragmentation{};
+};
+
+// Hands out ranges of a fixed-capacity address space (in caller-chosen
+// units), keeping free space in a free list that is coalesced on every
+// free. Allocation is best-fit to keep large blocks intact, and
+// compact() packs the live ranges together again. Knows nothing about
+// what the ranges address, so it can be used for GPU buffers.
+class RangeAllocator {
+public:
+  RangeAllocator(std::size_t capacity);
+  RangeAllocator() = delete;
+
+  // The range starts at a multiple of alignment.
+  auto allocate(std::size_t size, std::size_t alignment = 1)
+  -> std::optional<std::size_t>;
+  auto free(std::size_t offset) -> void;
+  auto grow(std::size_t capacity) -> void;
+  auto reset() -> void;
+  // Moves every allocated range to the front, in offset order and keeping
+  // its alignment; returns each range's new offset keyed by its old one.
+  auto compact() -> std::map<std::size_t, std::size_t>;
+  auto getCapacity() const -> std::size_t;
+  auto getStats() const -> RangeAllocatorStats;
+
+private:
+  struct Allocation {
+    std::size_t size{};
+    std::size_t alignment{};
+  };
+
+  std::size_t _capacity;
+  std::size_t _used{};
+  // Keyed by offset.
+  std::map<std::size_t, std::size_t> _freeBlocks{};
+  std::map<std::size_t, Allocation> _allocations{};
+  // Size to offset, for best-fit lookups.
+  std::multimap<std::size_t, std::size_t> _freeBySize{};
+
+  auto insertFree(std::size_t offset, std::size_t size) -> void;
+  auto eraseFree(std::map<std::size_t, std::size_t>::iterator block) -> void;
+};
+
+} // namespace my
+
+#endif // RANGE_ALLOCATOR_HXX
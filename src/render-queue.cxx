@@ -0,0 +1,107 @@
+#include "render-queue.hxx"
+
+#include <array>
+#include <cstddef>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+constexpr unsigned int programShift{56};
+constexpr unsigned int vertexArrayShift{44};
+constexpr unsigned int materialShift{32};
+constexpr unsigned int transformedShift{31};
+constexpr unsigned int meshShift{16};
+constexpr std::uint64_t programMask{0xff};
+constexpr std::uint64_t vertexArrayMask{0xfff};
+constexpr std::uint64_t materialMask{0xfff};
+constexpr std::uint64_t meshMask{0x7fff};
+constexpr std::uint64_t depthMask{0xffff};
+
+constexpr std::size_t radixBits{8};
+constexpr std::size_t radixBuckets{1 << radixBits};
+constexpr std::size_t radixPasses{64 / radixBits};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::SortKey::pack() const -> std::uint64_t {
+  return (program & programMask) << programShift
+    | (vertexArray & vertexArrayMask) << vertexArrayShift
+    | (material & materialMask) << materialShift
+    | static_cast<std::uint64_t>(transformed) << transformedShift
+    | (mesh & meshMask) << meshShift
+    | (depth & depthMask);
+}
+
+auto my::SortKey::unpack(std::uint64_t key) -> SortKey {
+  return {
+    static_cast<std::uint32_t>(key >> programShift & programMask),
+    static_cast<std::uint32_t>(key >> vertexArrayShift & vertexArrayMask),
+    static_cast<std::uint32_t>(key >> materialShift & materialMask),
+    static_cast<bool>(key >> transformedShift & 1),
+    static_cast<std::uint32_t>(key >> meshShift & meshMask),
+    static_cast<std::uint32_t>(key & depthMask)
+  };
+}
+
+auto my::SortKey::getBatch(std::uint64_t key) -> std::uint64_t {
+  return key & ~depthMask;
+}
+
+auto my::RenderQueue::clear() -> void {
+  _items.clear();
+}
+
+auto my::RenderQueue::reserve(std::size_t count) -> void {
+  _items.reserve(count);
+  _scratch.reserve(count);
+}
+
+auto my::RenderQueue::push(const DrawItem& item) -> void {
+  _items.push_back(item);
+}
+
+auto my::RenderQueue::sort() -> void {
+  // LSD radix sort, one byte per pass. All histograms are built in a
+  // single read over the keys; passes where every key shares the same
+  // byte (typically program, vertex array and material) are skipped.
+  std::array<std::array<std::size_t, radixBuckets>, radixPasses> counts{};
+  for (const auto& item : _items) {
+    for (std::size_t pass{}; pass < radixPasses; pass++) {
+      counts[pass][item.key >> (pass*radixBits) & (radixBuckets - 1)]++;
+    }
+  }
+  _scratch.resize(_items.size());
+  for (std::size_t pass{}; pass < radixPasses; pass++) {
+    std::array<std::size_t, radixBuckets>& offsets{counts[pass]};
+    bool trivial{false};
+    std::size_t total{};
+    for (auto& count : offsets) {
+      if (count == _items.size()) {
+        trivial = true;
+        break;
+      }
+      const std::size_t bucketCount{count};
+      count = total;
+      total += bucketCount;
+    }
+    if (trivial) {
+      continue;
+    }
+    for (const auto& item : _items) {
+      _scratch[offsets[item.key >> (pass*radixBits) & (radixBuckets - 1)]++]
+        = item;
+    }
+    _items.swap(_scratch);
+  }
+}
+
+auto my::RenderQueue::getItems() const -> const std::vector<DrawItem>& {
+  return _items;
+}
@@ -0,0 +1,72 @@
+#ifndef RENDER_QUEUE_HXX
+#define RENDER_QUEUE_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Sort keys pack the state a draw needs from most to least expensive to
+// change, so sorting by key puts draws that can share state next to
+// each other:
+//
+//   63      56 55       44 43       32  31  30        16 15         0
+//   [program ] [ vertex  ] [material ] [S] [  mesh    ] [  depth    ]
+//              [ array   ]
+//
+// S is set for draws that need a per-object transform. Draws without
+// one sort first within their material, since they can be merged into a
+// single multi-draw call. Mesh comes before depth so that copies of the
+// same mesh end up adjacent and can be instanced. Only the low 15 bits
+// of the mesh ID fit, so meshes far enough apart can share a group;
+// the draw item carries the whole ID, and the key is only for ordering.
+struct SortKey {
+  std::uint32_t program{};
+  std::uint32_t vertexArray{};
+  std::uint32_t material{};
+  bool transformed{};
+  std::uint32_t mesh{};
+  std::uint32_t depth{};
+
+  auto pack() const -> std::uint64_t;
+  static auto unpack(std::uint64_t key) -> SortKey;
+  // Equal for keys that differ only in depth, i.e. draws with the same
+  // state of meshes in the same group.
+  static auto getBatch(std::uint64_t key) -> std::uint64_t;
+};
+
+struct DrawItem {
+  std::uint64_t key{};
+  // Index of the object in the game state this draw came from.
+  std::uint32_t object{};
+  // Mesh to draw, with its whole ID; the key only has the low bits.
+  std::uint32_t mesh{};
+};
+
+class RenderQueue {
+public:
+  RenderQueue() = default;
+  RenderQueue(const RenderQueue&) = delete;
+  RenderQueue(RenderQueue&&) = delete;
+  auto operator=(const RenderQueue&) -> RenderQueue& = delete;
+  auto operator=(RenderQueue&&) -> RenderQueue& = delete;
+
+  auto clear() -> void;
+  auto reserve(std::size_t count) -> void;
+  auto push(const DrawItem& item) -> void;
+  auto sort() -> void;
+  auto getItems() const -> const std::vector<DrawItem>&;
+
+private:
+  std::vector<DrawItem> _items{};
+  std::vector<DrawItem> _scratch{};
+};
+
+} // namespace my
+
+#endif // RENDER_QUEUE_HXX
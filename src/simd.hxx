@@ -0,0 +1,19 @@
+#ifndef SIMD_HXX
+#define SIMD_HXX
+
+// Selects the SIMD code paths to compile. Every user keeps a scalar
+// fallback, built when the target lacks the instruction set or when
+// NO_SIMD is defined (USE_SIMD=False in CMake).
+#if !defined(NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define USE_SSE
+#include <emmintrin.h>
+#endif
+
+// AVX2 paths are wider versions of SSE ones, for builds that target it
+// (e.g. -march=native or /arch:AVX2).
+#if !defined(NO_SIMD) && defined(__AVX2__)
+#define USE_AVX
+#include <immintrin.h>
+#endif
+
+#endif // SIMD_HXX
@@ -0,0 +1,388 @@
+#include "simplify.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Sum of squared distances to a set of planes, as the upper triangle of
+// a symmetric 4x4 matrix.
+struct Quadric {
+  std::array<double, 10> terms{};
+
+  static auto fromPlane(const glm::dvec3& normal, double offset, double weight)
+  -> Quadric;
+  auto operator+=(const Quadric& other) -> Quadric&;
+  auto evaluate(const glm::dvec3& point) const -> double;
+};
+
+// Moves `from` onto `to` at `position`, removing `from`. The versions
+// tell whether either vertex changed since the cost was computed.
+struct Collapse {
+  double cost{};
+  std::uint32_t from{};
+  std::uint32_t to{};
+  std::uint32_t fromVersion{};
+  std::uint32_t toVersion{};
+  glm::dvec3 position{};
+
+  auto operator>(const Collapse& other) const -> bool;
+};
+
+class Simplifier {
+public:
+  Simplifier(const my::Geometry& geometry);
+
+  auto run(std::size_t targetTriangles) -> void;
+  auto getTriangleCount() const -> std::size_t;
+  auto build() const -> my::MeshGeometry;
+
+private:
+  using Triangle = std::array<std::uint32_t, 3>;
+
+  std::vector<glm::dvec3> _positions{};
+  std::vector<GLfloat> _colors{};
+  std::vector<Quadric> _quadrics{};
+  std::vector<bool> _locked{};
+  std::vector<bool> _removedVertices{};
+  std::vector<std::uint32_t> _versions{};
+  std::vector<Triangle> _triangles{};
+  std::vector<bool> _removedTriangles{};
+  std::vector<std::vector<std::uint32_t>> _vertexTriangles{};
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>>
+    _collapses{};
+  std::size_t _triangleCount{};
+  std::vector<std::uint32_t> _neighbors{};
+
+  auto pushCollapse(std::uint32_t a, std::uint32_t b) -> void;
+  auto isValid(const Collapse& collapse) const -> bool;
+  auto apply(const Collapse& collapse) -> void;
+  auto getNormal(const Triangle& triangle) const -> glm::dvec3;
+};
+
+// A level has to lose at least this share of the previous one's
+// triangles to be worth keeping.
+constexpr double minLevelReduction{.2};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::simplify(const Geometry& geometry, std::size_t targetTriangles)
+-> MeshGeometry {
+  Simplifier simplifier{geometry};
+  simplifier.run(targetTriangles);
+  return simplifier.build();
+}
+
+auto my::buildLevelsOfDetail(const Geometry& geometry, std::size_t count)
+-> std::vector<MeshGeometry> {
+  // Each level continues from the last one's collapses, which gives the
+  // same result as starting over but does the work only once.
+  std::vector<MeshGeometry> levels{};
+  Simplifier simplifier{geometry};
+  std::size_t triangles{simplifier.getTriangleCount()};
+  for (std::size_t level{}; level < count; level++) {
+    simplifier.run(triangles/2);
+    const std::size_t simplified{simplifier.getTriangleCount()};
+    if (
+      static_cast<double>(simplified)
+      > static_cast<double>(triangles)*(1. - minLevelReduction)
+    ) {
+      break;
+    }
+    levels.push_back(simplifier.build());
+    triangles = simplified;
+  }
+  return levels;
+}
+
+namespace {
+
+auto Quadric::fromPlane(
+  const glm::dvec3& normal, double offset, double weight
+) -> Quadric {
+  const std::array<double, 4> plane{normal.x, normal.y, normal.z, offset};
+  Quadric quadric{};
+  std::size_t term{};
+  for (std::size_t row{}; row < 4; row++) {
+    for (std::size_t column{row}; column < 4; column++) {
+      quadric.terms[term++] = plane[row]*plane[column]*weight;
+    }
+  }
+  return quadric;
+}
+
+auto Quadric::operator+=(const Quadric& other) -> Quadric& {
+  for (std::size_t term{}; term < terms.size(); term++) {
+    terms[term] += other.terms[term];
+  }
+  return *this;
+}
+
+auto Quadric::evaluate(const glm::dvec3& point) const -> double {
+  const std::array<double, 4> v{point.x, point.y, point.z, 1.};
+  double result{};
+  std::size_t term{};
+  for (std::size_t row{}; row < 4; row++) {
+    for (std::size_t column{row}; column < 4; column++) {
+      // Off-diagonal terms stand for both halves of the matrix.
+      const double factor{row == column ? 1. : 2.};
+      result += factor*terms[term++]*v[row]*v[column];
+    }
+  }
+  return result;
+}
+
+auto Collapse::operator>(const Collapse& other) const -> bool {
+  return cost > other.cost;
+}
+
+Simplifier::Simplifier(const my::Geometry& geometry) {
+  const auto vertexCount{static_cast<std::size_t>(geometry.getVertexCount())};
+  const GLfloat* vertices{geometry.getVertices()};
+  _positions.reserve(vertexCount);
+  for (std::size_t vertex{}; vertex < vertexCount; vertex++) {
+    _positions.push_back({
+      vertices[vertex*3], vertices[vertex*3 + 1], vertices[vertex*3 + 2]
+    });
+  }
+  _colors.assign(
+    geometry.getColors(), geometry.getColors() + geometry.getColorArraySize()
+  );
+  _quadrics.resize(vertexCount);
+  _locked.resize(vertexCount);
+  _removedVertices.resize(vertexCount);
+  _versions.resize(vertexCount);
+  _vertexTriangles.resize(vertexCount);
+
+  const GLuint* indices{geometry.getIndices()};
+  const auto indexCount{static_cast<std::size_t>(geometry.getIndexCount())};
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges{};
+  edges.reserve(indexCount);
+  for (std::size_t index{}; index + 2 < indexCount; index += 3) {
+    const Triangle triangle{
+      indices[index], indices[index + 1], indices[index + 2]
+    };
+    const auto id{static_cast<std::uint32_t>(_triangles.size())};
+    _triangles.push_back(triangle);
+    for (std::size_t corner{}; corner < 3; corner++) {
+      _vertexTriangles[triangle[corner]].push_back(id);
+      const std::uint32_t a{triangle[corner]};
+      const std::uint32_t b{triangle[(corner + 1) % 3]};
+      edges.push_back({std::min(a, b), std::max(a, b)});
+    }
+    const glm::dvec3 normal{getNormal(triangle)};
+    const double doubleArea{glm::length(normal)};
+    if (doubleArea > 0.) {
+      const glm::dvec3 unit{normal/doubleArea};
+      const Quadric plane{Quadric::fromPlane(
+        unit, -glm::dot(unit, _positions[triangle[0]]), doubleArea*.5
+      )};
+      for (const auto vertex : triangle) {
+        _quadrics[vertex] += plane;
+      }
+    }
+  }
+  _removedTriangles.resize(_triangles.size());
+  _triangleCount = _triangles.size();
+  // Edges used by a single triangle are open; their vertices stay put.
+  std::sort(edges.begin(), edges.end());
+  for (std::size_t first{}; first < edges.size();) {
+    std::size_t last{first + 1};
+    while (last < edges.size() && edges[last] == edges[first]) {
+      last++;
+    }
+    if (last - first == 1) {
+      _locked[edges[first].first] = true;
+      _locked[edges[first].second] = true;
+    }
+    first = last;
+  }
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  for (const auto& [a, b] : edges) {
+    pushCollapse(a, b);
+  }
+}
+
+auto Simplifier::run(std::size_t targetTriangles) -> void {
+  while (_triangleCount > targetTriangles && !_collapses.empty()) {
+    const Collapse collapse{_collapses.top()};
+    _collapses.pop();
+    if (
+      _removedVertices[collapse.from] || _removedVertices[collapse.to]
+      || _versions[collapse.from] != collapse.fromVersion
+      || _versions[collapse.to] != collapse.toVersion
+      || !isValid(collapse)
+    ) {
+      continue;
+    }
+    apply(collapse);
+  }
+}
+
+auto Simplifier::getTriangleCount() const -> std::size_t {
+  return _triangleCount;
+}
+
+auto Simplifier::build() const -> my::MeshGeometry {
+  constexpr auto unused{std::numeric_limits<std::uint32_t>::max()};
+  std::vector<std::uint32_t> remap(_positions.size(), unused);
+  std::vector<GLfloat> vertices{};
+  std::vector<GLfloat> colors{};
+  std::vector<GLuint> indices{};
+  indices.reserve(_triangleCount*3);
+  for (std::size_t triangle{}; triangle < _triangles.size(); triangle++) {
+    if (_removedTriangles[triangle]) {
+      continue;
+    }
+    for (const auto vertex : _triangles[triangle]) {
+      if (remap[vertex] == unused) {
+        remap[vertex] = static_cast<std::uint32_t>(vertices.size()/3);
+        const glm::dvec3& position{_positions[vertex]};
+        vertices.insert(vertices.end(), {
+          static_cast<GLfloat>(position.x), static_cast<GLfloat>(position.y),
+          static_cast<GLfloat>(position.z)
+        });
+        colors.insert(
+          colors.end(), _colors.begin() + vertex*3,
+          _colors.begin() + vertex*3 + 3
+        );
+      }
+      indices.push_back(static_cast<GLuint>(remap[vertex]));
+    }
+  }
+  return {std::move(vertices), std::move(colors), std::move(indices)};
+}
+
+auto Simplifier::pushCollapse(std::uint32_t a, std::uint32_t b) -> void {
+  if (_locked[a] && _locked[b]) {
+    return;
+  }
+  Quadric quadric{_quadrics[a]};
+  quadric += _quadrics[b];
+  Collapse collapse{};
+  if (_locked[a] || _locked[b]) {
+    // The free end moves onto the locked one.
+    collapse.from = _locked[a] ? b : a;
+    collapse.to = _locked[a] ? a : b;
+    collapse.position = _positions[collapse.to];
+    collapse.cost = quadric.evaluate(collapse.position);
+  } else {
+    // Best of the ends and the midpoint; cheaper and more robust than
+    // solving for the optimum, and never leaves the mesh's hull.
+    collapse.from = a;
+    collapse.to = b;
+    collapse.cost = std::numeric_limits<double>::max();
+    for (const auto& position : {
+      _positions[a], _positions[b], (_positions[a] + _positions[b])*.5
+    }) {
+      const double cost{quadric.evaluate(position)};
+      if (cost < collapse.cost) {
+        collapse.cost = cost;
+        collapse.position = position;
+      }
+    }
+  }
+  collapse.fromVersion = _versions[collapse.from];
+  collapse.toVersion = _versions[collapse.to];
+  _collapses.push(collapse);
+}
+
+auto Simplifier::isValid(const Collapse& collapse) const -> bool {
+  // Reject collapses that would fold a surviving triangle over.
+  for (const auto vertex : {collapse.from, collapse.to}) {
+    for (const auto id : _vertexTriangles[vertex]) {
+      if (_removedTriangles[id]) {
+        continue;
+      }
+      const Triangle& triangle{_triangles[id]};
+      if (
+        std::count(triangle.begin(), triangle.end(), collapse.from)
+        && std::count(triangle.begin(), triangle.end(), collapse.to)
+      ) {
+        continue;
+      }
+      const glm::dvec3 before{getNormal(triangle)};
+      std::array<glm::dvec3, 3> corners{};
+      for (std::size_t corner{}; corner < 3; corner++) {
+        corners[corner] = triangle[corner] == vertex
+          ? collapse.position : _positions[triangle[corner]];
+      }
+      const glm::dvec3 after{
+        glm::cross(corners[1] - corners[0], corners[2] - corners[0])
+      };
+      if (glm::dot(before, after) <= 0.) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+auto Simplifier::apply(const Collapse& collapse) -> void {
+  for (const auto id : _vertexTriangles[collapse.from]) {
+    if (_removedTriangles[id]) {
+      continue;
+    }
+    Triangle& triangle{_triangles[id]};
+    if (std::count(triangle.begin(), triangle.end(), collapse.to)) {
+      _removedTriangles[id] = true;
+      _triangleCount--;
+      continue;
+    }
+    std::replace(triangle.begin(), triangle.end(), collapse.from, collapse.to);
+    _vertexTriangles[collapse.to].push_back(id);
+  }
+  _vertexTriangles[collapse.from].clear();
+  _removedVertices[collapse.from] = true;
+  _positions[collapse.to] = collapse.position;
+  _quadrics[collapse.to] += _quadrics[collapse.from];
+  _versions[collapse.to]++;
+
+  std::vector<std::uint32_t>& triangles{_vertexTriangles[collapse.to]};
+  triangles.erase(
+    std::remove_if(
+      triangles.begin(), triangles.end(),
+      [this](std::uint32_t id) { return _removedTriangles[id]; }
+    ),
+    triangles.end()
+  );
+  // Every edge out of the moved vertex has a new cost; each neighbor
+  // shows up in two of its triangles.
+  _neighbors.clear();
+  for (const auto id : triangles) {
+    for (const auto vertex : _triangles[id]) {
+      if (vertex != collapse.to) {
+        _neighbors.push_back(vertex);
+      }
+    }
+  }
+  std::sort(_neighbors.begin(), _neighbors.end());
+  _neighbors.erase(
+    std::unique(_neighbors.begin(), _neighbors.end()), _neighbors.end()
+  );
+  for (const auto vertex : _neighbors) {
+    pushCollapse(collapse.to, vertex);
+  }
+}
+
+auto Simplifier::getNormal(const Triangle& triangle) const -> glm::dvec3 {
+  const glm::dvec3& a{_positions[triangle[0]]};
+  return glm::cross(_positions[triangle[1]] - a, _positions[triangle[2]] - a);
+}
+
+} // namespace
@@ -0,0 +1,29 @@
+#ifndef SIMPLIFY_HXX
+#define SIMPLIFY_HXX
+
+#include <cstddef>
+#include <vector>
+
+#include "models.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Reduces a mesh towards targetTriangles by repeatedly collapsing the
+// edge that adds the least quadric error (Garland and Heckbert). Vertices
+// on open edges never move, so meshes that tile, like terrain, keep
+// matching borders; a mesh that is all border doesn't simplify at all.
+auto simplify(const Geometry& geometry, std::size_t targetTriangles)
+-> MeshGeometry;
+// Up to `count` successively simplified copies, each with about half the
+// triangles of the one before, for levels of detail 1 and up. Stops
+// early once a level would barely shrink.
+auto buildLevelsOfDetail(const Geometry& geometry, std::size_t count)
+-> std::vector<MeshGeometry>;
+
+} // namespace my
+
+#endif // SIMPLIFY_HXX
@@ -0,0 +1,141 @@
+#include "stream-buffer.hxx"
+
+#include <stdexcept>
+
+#include "graphics-state.hxx"
+#include "logger.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+// Generous enough that only a hung GPU would trip it.
+constexpr GLuint64 fenceTimeoutNanoseconds{1'000'000'000};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::StreamBuffer::StreamBuffer(
+  BufferTarget target, GLsizeiptr frameSize, std::size_t frameCount
+) : _buffer{
+      target, nullptr,
+      static_cast<GLsizei>(frameSize*static_cast<GLsizeiptr>(frameCount)),
+      BufferUsage::StreamDraw
+    },
+    _frameSize{frameSize}, _fences(frameCount, nullptr) {}
+
+my::StreamBuffer::~StreamBuffer() {
+  if (_mapped) {
+    finishWrites();
+  }
+  clearFences();
+}
+
+auto my::StreamBuffer::getBuffer() const -> const Buffer& {
+  return _buffer;
+}
+
+auto my::StreamBuffer::getFrameSize() const -> GLsizeiptr {
+  return _frameSize;
+}
+
+auto my::StreamBuffer::getStallCount() const -> std::size_t {
+  return _stallCount;
+}
+
+auto my::StreamBuffer::reserve(GLsizeiptr frameSize) -> void {
+#ifdef DEBUG
+  if (_mapped) {
+    throw std::runtime_error{"Attempt to resize mapped stream buffer"};
+  }
+#endif // DEBUG
+  if (frameSize <= _frameSize) {
+    return;
+  }
+  // Grow geometrically so a slowly growing scene doesn't reallocate
+  // every frame. Respecifying the store orphans the old one, which
+  // draws in flight keep using, so the fences no longer apply.
+  while (_frameSize < frameSize) {
+    _frameSize *= 2;
+  }
+  clearFences();
+  _buffer.setData(
+    nullptr, _frameSize*static_cast<GLsizeiptr>(_fences.size())
+  );
+  LOG_DEBUG("Stream buffer grown to {} bytes per frame", _frameSize);
+}
+
+auto my::StreamBuffer::beginFrame() -> void {
+  GLsync& fence{_fences[_frame]};
+  if (fence) {
+    GLenum status{glClientWaitSync(fence, 0, 0)};
+    if (status == GL_TIMEOUT_EXPIRED) {
+      _stallCount++;
+      status = glClientWaitSync(
+        fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeoutNanoseconds
+      );
+    }
+    if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED) {
+      throw std::runtime_error{"Failed waiting for stream buffer fence"};
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, _buffer.getID());
+  _mapped = static_cast<unsigned char*>(glMapBufferRange(
+    GL_COPY_WRITE_BUFFER, getRegionOffset(), _frameSize,
+    GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT
+  ));
+  if (!_mapped) {
+    throw std::runtime_error{"Failed to map stream buffer"};
+  }
+  _used = 0;
+}
+
+auto my::StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+-> std::optional<StreamAllocation> {
+#ifdef DEBUG
+  if (!_mapped) {
+    throw std::runtime_error{"Attempt to allocate from unmapped stream buffer"};
+  }
+#endif // DEBUG
+  const GLsizeiptr start{(_used + alignment - 1) / alignment*alignment};
+  if (start + size > _frameSize) {
+    return {};
+  }
+  _used = start + size;
+  return StreamAllocation{_mapped + start, getRegionOffset() + start};
+}
+
+auto my::StreamBuffer::finishWrites() -> void {
+  StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, _buffer.getID());
+  if (_used > 0) {
+    glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, _used);
+  }
+  glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+  _mapped = nullptr;
+}
+
+auto my::StreamBuffer::endFrame() -> void {
+  _fences[_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  _frame = (_frame + 1) % _fences.size();
+}
+
+auto my::StreamBuffer::getRegionOffset() const -> GLintptr {
+  return _frameSize*static_cast<GLintptr>(_frame);
+}
+
+auto my::StreamBuffer::clearFences() -> void {
+  for (auto& fence : _fences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef STREAM_BUFFER_HXX
+#define STREAM_BUFFER_HXX
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "graphics-types.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct StreamAllocation {
+  // Write-only; valid until finishWrites.
+  GLvoid* data{};
+  // Byte offset into the buffer, e.g. for attribute pointers.
+  GLintptr offset{};
+};
+
+// A buffer split into one region per frame in flight, for data that is
+// rewritten every frame. Each frame maps its region without
+// synchronization and sub-allocates from it; a fence placed after the
+// frame's draws guards the region until the GPU has finished with it,
+// so writing never waits on draws from the frames in between.
+//
+// Per frame: beginFrame, allocate..., finishWrites, draw, endFrame.
+class StreamBuffer {
+public:
+  StreamBuffer(
+    BufferTarget target, GLsizeiptr frameSize, std::size_t frameCount = 3
+  );
+  StreamBuffer() = delete;
+  StreamBuffer(const StreamBuffer&) = delete;
+  StreamBuffer(StreamBuffer&&) = delete;
+  auto operator=(const StreamBuffer&) -> StreamBuffer& = delete;
+  auto operator=(StreamBuffer&&) -> StreamBuffer& = delete;
+  ~StreamBuffer() noexcept;
+
+  auto getBuffer() const -> const Buffer&;
+  auto getFrameSize() const -> GLsizeiptr;
+  auto getStallCount() const -> std::size_t;
+  auto reserve(GLsizeiptr frameSize) -> void;
+  auto beginFrame() -> void;
+  auto allocate(GLsizeiptr size, GLsizeiptr alignment = 16)
+  -> std::optional<StreamAllocation>;
+  auto finishWrites() -> void;
+  auto endFrame() -> void;
+
+private:
+  Buffer _buffer;
+  GLsizeiptr _frameSize;
+  std::vector<GLsync> _fences;
+  std::size_t _frame{};
+  GLsizeiptr _used{};
+  unsigned char* _mapped{nullptr};
+  std::size_t _stallCount{};
+
+  auto getRegionOffset() const -> GLintptr;
+  auto clearFences() -> void;
+};
+
+} // namespace my
+
+#endif // STREAM_BUFFER_HXX
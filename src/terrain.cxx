@@ -0,0 +1,321 @@
+#include "terrain.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "profiler.hxx"
+#include "simplify.hxx"
+#include "vertex-format.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto getTileKey(const glm::ivec2& coordinate) -> std::uint64_t;
+auto getRingDistance(const glm::ivec2& a, const glm::ivec2& b) -> int;
+auto getTerrainColor(float height) -> glm::vec3;
+auto getMeshBytes(const my::Geometry& geometry) -> std::size_t;
+
+// Bounds the GL work a frame spends on newly generated tiles.
+constexpr std::size_t maxUploadsPerFrame{2};
+// Jobs in flight per worker; more would only hold memory earlier.
+constexpr std::size_t jobsPerThread{2};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::TerrainGeometry::TerrainGeometry(
+  const std::vector<float>& heights, int samples,
+  const TerrainSettings& settings
+) {
+  const auto count{static_cast<std::size_t>(samples*samples)};
+  _vertices.reserve(count*3);
+  _colors.reserve(count*3);
+  for (int z{}; z < samples; z++) {
+    for (int x{}; x < samples; x++) {
+      const float height{heights[static_cast<std::size_t>(z*samples + x)]};
+      _vertices.insert(_vertices.end(), {
+        static_cast<float>(x)*settings.sampleSpacing, height,
+        static_cast<float>(z)*settings.sampleSpacing
+      });
+      const glm::vec3 color{getTerrainColor(
+        (height - settings.baseHeight)/settings.heightScale
+      )};
+      _colors.insert(_colors.end(), {color.x, color.y, color.z});
+    }
+  }
+  // Two triangles per cell, counter-clockwise from above.
+  const auto cells{static_cast<std::size_t>((samples - 1)*(samples - 1))};
+  _indices.reserve(cells*6);
+  for (int z{}; z + 1 < samples; z++) {
+    for (int x{}; x + 1 < samples; x++) {
+      const auto corner{static_cast<GLuint>(z*samples + x)};
+      const auto right{static_cast<GLuint>(corner + 1)};
+      const auto below{static_cast<GLuint>(corner + samples)};
+      const auto diagonal{static_cast<GLuint>(below + 1)};
+      _indices.insert(
+        _indices.end(), {corner, below, diagonal, corner, diagonal, right}
+      );
+    }
+  }
+}
+
+auto my::TerrainGeometry::getVertices() const -> const GLfloat* {
+  return _vertices.data();
+}
+
+auto my::TerrainGeometry::getColors() const -> const GLfloat* {
+  return _colors.data();
+}
+
+auto my::TerrainGeometry::getIndices() const -> const GLuint* {
+  return _indices.data();
+}
+
+auto my::TerrainGeometry::getVertexArraySize() const -> GLint {
+  return static_cast<GLint>(_vertices.size());
+}
+
+auto my::TerrainGeometry::getColorArraySize() const -> GLint {
+  return static_cast<GLint>(_colors.size());
+}
+
+auto my::TerrainGeometry::getIndexArraySize() const -> GLint {
+  return static_cast<GLint>(_indices.size());
+}
+
+my::TerrainStreamer::TerrainStreamer(
+  const TerrainSettings& settings, ThreadPool& pool
+)
+: _settings{settings}, _pool{pool},
+  _tileBytes{
+    static_cast<std::size_t>(settings.tileSamples*settings.tileSamples)
+      *sizeof(PackedVertex)
+    + static_cast<std::size_t>(
+      (settings.tileSamples - 1)*(settings.tileSamples - 1)*6
+    )*getIndexSize(getIndexType(static_cast<std::size_t>(
+      settings.tileSamples*settings.tileSamples
+    )))
+  } {
+  if (settings.tileSamples < 2) {
+    throw std::runtime_error{"Terrain tiles must have at least 2 samples"};
+  }
+}
+
+auto my::TerrainStreamer::update(
+  const glm::vec3& cameraPosition, GraphicsEngine& graphics
+) -> void {
+  const float tileSpan{
+    static_cast<float>(_settings.tileSamples - 1)*_settings.sampleSpacing
+  };
+  const glm::ivec2 center{
+    static_cast<int>(std::floor(cameraPosition.x/tileSpan)),
+    static_cast<int>(std::floor(cameraPosition.z/tileSpan))
+  };
+  collectTiles(graphics, center);
+  unloadTiles(graphics, center);
+  requestTiles(center);
+  if (_objectsChanged) {
+    _objects.clear();
+    for (const auto& [key, tile] : _tiles) {
+      const glm::mat4 modelMatrix{
+        glm::translate(glm::mat4{1.}, getTileOrigin(tile.coordinate))
+      };
+      _objects.push_back({tile.mesh, modelMatrix, modelMatrix});
+    }
+    _objectsChanged = false;
+  }
+  _stats.tilesLoaded = _tiles.size();
+  _stats.tilesPending = _jobs.size();
+  _stats.memoryBytes = getMemoryBytes();
+  _stats.peakMemoryBytes = std::max(
+    _stats.peakMemoryBytes, _stats.memoryBytes
+  );
+}
+
+auto my::TerrainStreamer::getObjects() const
+-> const std::vector<ObjectState>& {
+  return _objects;
+}
+
+auto my::TerrainStreamer::getStats() const -> const TerrainStats& {
+  return _stats;
+}
+
+auto my::TerrainStreamer::collectTiles(
+  GraphicsEngine& graphics, const glm::ivec2& center
+) -> void {
+  std::size_t uploaded{};
+  for (std::size_t i{}; i < _jobs.size() && uploaded < maxUploadsPerFrame;) {
+    TileJob& job{_jobs[i]};
+    if (
+      job.result.wait_for(std::chrono::seconds{0}) != std::future_status::ready
+    ) {
+      i++;
+      continue;
+    }
+    const TileResult result{job.result.get()};
+    _stats.tilesGenerated++;
+    _stats.generateMilliseconds += result.milliseconds;
+    // The camera may have moved on while this was generated.
+    if (getRingDistance(job.coordinate, center) <= _settings.loadRadius + 1) {
+      std::size_t bytes{getMeshBytes(result.geometry)};
+      for (const auto& level : result.levels) {
+        bytes += getMeshBytes(level);
+      }
+      _tiles[getTileKey(job.coordinate)] = {
+        job.coordinate, graphics.addMesh(result.geometry, result.levels), bytes
+      };
+      _loadedBytes += bytes;
+      _objectsChanged = true;
+      uploaded++;
+    }
+    _jobs[i] = std::move(_jobs.back());
+    _jobs.pop_back();
+  }
+}
+
+auto my::TerrainStreamer::unloadTiles(
+  GraphicsEngine& graphics, const glm::ivec2& center
+) -> void {
+  // Farthest first, so the budget trims the outer rings.
+  while (!_tiles.empty()) {
+    const auto farthest{std::max_element(
+      _tiles.begin(), _tiles.end(),
+      [&center](const auto& a, const auto& b) {
+        return getRingDistance(a.second.coordinate, center)
+          < getRingDistance(b.second.coordinate, center);
+      }
+    )};
+    if (
+      getRingDistance(farthest->second.coordinate, center)
+        <= _settings.loadRadius + 1
+      && getMemoryBytes() <= _settings.memoryBudget
+    ) {
+      break;
+    }
+    graphics.removeMesh(farthest->second.mesh);
+    _loadedBytes -= farthest->second.bytes;
+    _tiles.erase(farthest);
+    _stats.tilesUnloaded++;
+    _objectsChanged = true;
+  }
+}
+
+auto my::TerrainStreamer::requestTiles(const glm::ivec2& center) -> void {
+  const std::size_t maxJobs{_pool.getThreadCount()*jobsPerThread};
+  for (int ring{}; ring <= _settings.loadRadius; ring++) {
+    for (int z{-ring}; z <= ring; z++) {
+      // Only the edge of the square on the ring's middle rows.
+      const int step{std::abs(z) == ring ? 1 : 2*ring};
+      for (int x{-ring}; x <= ring; x += step) {
+        const glm::ivec2 coordinate{center.x + x, center.y + z};
+        if (
+          _tiles.count(getTileKey(coordinate))
+          || std::any_of(
+            _jobs.begin(), _jobs.end(),
+            [&coordinate](const TileJob& job) {
+              return job.coordinate == coordinate;
+            }
+          )
+        ) {
+          continue;
+        }
+        if (
+          _jobs.size() >= maxJobs
+          || getMemoryBytes() + 2*_tileBytes > _settings.memoryBudget
+        ) {
+          return;
+        }
+        const glm::vec3 origin{getTileOrigin(coordinate)};
+        _jobs.push_back({coordinate, _pool.submit(
+          [settings{_settings}, origin]() {
+            PROFILE_SCOPE("Generate tile");
+            const auto start{std::chrono::steady_clock::now()};
+            const int samples{settings.tileSamples};
+            std::vector<float> heights(
+              static_cast<std::size_t>(samples*samples)
+            );
+            sampleNoiseGrid(
+              settings.noise, origin.x, origin.z, settings.sampleSpacing,
+              samples, samples, heights.data()
+            );
+            for (auto& height : heights) {
+              height = settings.baseHeight + height*settings.heightScale;
+            }
+            TileResult result{{heights, samples, settings}, {}, 0.};
+            result.levels = buildLevelsOfDetail(
+              result.geometry, settings.levelsOfDetail
+            );
+            const std::chrono::duration<double, std::milli> time{
+              std::chrono::steady_clock::now() - start
+            };
+            result.milliseconds = time.count();
+            return result;
+          }
+        )});
+      }
+    }
+  }
+}
+
+auto my::TerrainStreamer::getTileOrigin(const glm::ivec2& coordinate) const
+-> glm::vec3 {
+  const float tileSpan{
+    static_cast<float>(_settings.tileSamples - 1)*_settings.sampleSpacing
+  };
+  return {
+    static_cast<float>(coordinate.x)*tileSpan, 0.f,
+    static_cast<float>(coordinate.y)*tileSpan
+  };
+}
+
+auto my::TerrainStreamer::getMemoryBytes() const -> std::size_t {
+  return _loadedBytes + _jobs.size()*2*_tileBytes;
+}
+
+namespace {
+
+auto getTileKey(const glm::ivec2& coordinate) -> std::uint64_t {
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(coordinate.x))
+    | static_cast<std::uint64_t>(static_cast<std::uint32_t>(coordinate.y))
+      << 32;
+}
+
+auto getRingDistance(const glm::ivec2& a, const glm::ivec2& b) -> int {
+  return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y));
+}
+
+auto getMeshBytes(const my::Geometry& geometry) -> std::size_t {
+  const auto vertexCount{static_cast<std::size_t>(geometry.getVertexCount())};
+  return vertexCount*sizeof(my::PackedVertex)
+    + static_cast<std::size_t>(geometry.getIndexCount())
+      *my::getIndexSize(my::getIndexType(vertexCount));
+}
+
+auto getTerrainColor(float height) -> glm::vec3 {
+  // Height in noise units, roughly -.3 to .3.
+  if (height > .2f) {
+    return {.95f, .95f, .97f}; // Snow.
+  }
+  if (height > .1f) {
+    return {.5f, .48f, .45f}; // Rock.
+  }
+  if (height > -.15f) {
+    return {.3f + height, .55f + height, .22f}; // Grass, lighter uphill.
+  }
+  return {.76f, .7f, .5f}; // Sand.
+}
+
+} // namespace
@@ -0,0 +1,135 @@
+#ifndef TERRAIN_HXX
+#define TERRAIN_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "game.hxx"
+#include "graphics-engine.hxx"
+#include "models.hxx"
+#include "noise.hxx"
+#include "thread-pool.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct TerrainSettings {
+  NoiseSettings noise{};
+  // Heights along each side of a tile. Neighbors share their edge rows,
+  // so a tile spans one fewer spacing than this.
+  int tileSamples{65};
+  float sampleSpacing{1.f};
+  float baseHeight{-20.f};
+  // World units per unit of noise.
+  float heightScale{48.f};
+  // Tiles within this many of the camera's tile, in square rings, are
+  // kept loaded; one more ring is tolerated before unloading.
+  int loadRadius{2};
+  // Bytes of tile meshes, loaded or being generated; the rings stop
+  // growing once it's reached.
+  std::size_t memoryBudget{std::size_t{64} << 20};
+  // Simplified levels of detail generated along with each tile.
+  std::size_t levelsOfDetail{4};
+};
+
+struct TerrainStats {
+  std::size_t tilesLoaded{};
+  std::size_t tilesPending{};
+  std::size_t tilesGenerated{};
+  std::size_t tilesUnloaded{};
+  // Worker time spent generating, summed over threads.
+  double generateMilliseconds{};
+  std::size_t memoryBytes{};
+  std::size_t peakMemoryBytes{};
+};
+
+// Grid mesh of one heightmap tile, in tile-local coordinates.
+class TerrainGeometry : public Geometry {
+public:
+  TerrainGeometry() = default;
+  TerrainGeometry(
+    const std::vector<float>& heights, int samples,
+    const TerrainSettings& settings
+  );
+
+  auto getVertices() const -> const GLfloat* final;
+  auto getColors() const -> const GLfloat* final;
+  auto getIndices() const -> const GLuint* final;
+  auto getVertexArraySize() const -> GLint final;
+  auto getColorArraySize() const -> GLint final;
+  auto getIndexArraySize() const -> GLint final;
+
+private:
+  std::vector<GLfloat> _vertices{};
+  std::vector<GLfloat> _colors{};
+  std::vector<GLuint> _indices{};
+};
+
+// Generates heightmap tiles from noise on a thread pool as the camera
+// moves, nearest rings first, and unloads them as it leaves. Owned by
+// the render thread, like VoxelWorld.
+class TerrainStreamer {
+public:
+  TerrainStreamer(const TerrainSettings& settings, ThreadPool& pool);
+  TerrainStreamer() = delete;
+  TerrainStreamer(const TerrainStreamer&) = delete;
+  TerrainStreamer(TerrainStreamer&&) = delete;
+  auto operator=(const TerrainStreamer&) -> TerrainStreamer& = delete;
+  auto operator=(TerrainStreamer&&) -> TerrainStreamer& = delete;
+
+  // Once per frame, before rendering; never waits on the workers.
+  auto update(const glm::vec3& cameraPosition, GraphicsEngine& graphics)
+  -> void;
+  // One per loaded tile, for GraphicsEngine::render().
+  auto getObjects() const -> const std::vector<ObjectState>&;
+  auto getStats() const -> const TerrainStats&;
+
+private:
+  struct Tile {
+    glm::ivec2 coordinate{};
+    std::uint32_t mesh{};
+    std::size_t bytes{};
+  };
+  struct TileResult {
+    TerrainGeometry geometry{};
+    std::vector<MeshGeometry> levels{};
+    double milliseconds{};
+  };
+  struct TileJob {
+    glm::ivec2 coordinate{};
+    std::future<TileResult> result{};
+  };
+
+  TerrainSettings _settings;
+  ThreadPool& _pool;
+  // Mesh bytes of a full-detail tile. Its levels of detail add less than
+  // as much again, so twice this is held for each tile being generated.
+  std::size_t _tileBytes;
+  std::size_t _loadedBytes{};
+  std::unordered_map<std::uint64_t, Tile> _tiles{};
+  std::vector<TileJob> _jobs{};
+  std::vector<ObjectState> _objects{};
+  bool _objectsChanged{};
+  TerrainStats _stats{};
+
+  auto collectTiles(GraphicsEngine& graphics, const glm::ivec2& center)
+  -> void;
+  auto unloadTiles(GraphicsEngine& graphics, const glm::ivec2& center)
+  -> void;
+  auto requestTiles(const glm::ivec2& center) -> void;
+  auto getTileOrigin(const glm::ivec2& coordinate) const -> glm::vec3;
+  auto getMemoryBytes() const -> std::size_t;
+};
+
+} // namespace my
+
+#endif // TERRAIN_HXX
@@ -0,0 +1,53 @@
+#include "thread-pool.hxx"
+
+#include <algorithm>
+#include <string>
+
+#include "profiler.hxx"
+
+/*
+ * Definitions.
+ */
+
+my::ThreadPool::ThreadPool(std::size_t threadCount) {
+  if (threadCount == 0) {
+    const std::size_t cores{std::thread::hardware_concurrency()};
+    threadCount = std::max<std::size_t>(cores, 2) - 1;
+  }
+  _threads.reserve(threadCount);
+  for (std::size_t i{}; i < threadCount; i++) {
+    _threads.emplace_back(&ThreadPool::run, this, i);
+  }
+}
+
+my::ThreadPool::~ThreadPool() {
+  {
+    const std::lock_guard<std::mutex> lock{_mutex};
+    _stopping = true;
+  }
+  _condition.notify_all();
+  for (auto& thread : _threads) {
+    thread.join();
+  }
+}
+
+auto my::ThreadPool::getThreadCount() const -> std::size_t {
+  return _threads.size();
+}
+
+auto my::ThreadPool::run(std::size_t index) -> void {
+  Profiler::nameThread("Worker " + std::to_string(index + 1));
+  while (true) {
+    std::function<void()> task{};
+    {
+      std::unique_lock<std::mutex> lock{_mutex};
+      _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty()) {
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop();
+    }
+    task();
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef THREAD_POOL_HXX
+#define THREAD_POOL_HXX
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Fixed set of worker threads running tasks in submission order. Results
+// come back through futures, which callers on a frame loop should poll
+// with wait_for(0) rather than get().
+class ThreadPool {
+public:
+  // Zero picks one thread per core, leaving one for the caller.
+  ThreadPool(std::size_t threadCount = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+  auto operator=(ThreadPool&&) -> ThreadPool& = delete;
+  // Finishes the queued tasks, then joins the workers.
+  ~ThreadPool() noexcept;
+
+  template<typename F>
+  auto submit(F&& task) -> std::future<std::invoke_result_t<F>>;
+  auto getThreadCount() const -> std::size_t;
+
+private:
+  std::vector<std::thread> _threads{};
+  std::queue<std::function<void()>> _tasks{};
+  std::mutex _mutex{};
+  std::condition_variable _condition{};
+  bool _stopping{};
+
+  auto run(std::size_t index) -> void;
+};
+
+} // namespace my
+
+/*
+ * Definitions.
+ */
+
+template<typename F>
+auto my::ThreadPool::submit(F&& task)
+-> std::future<std::invoke_result_t<F>> {
+  // std::function needs a copyable target, which packaged_task isn't.
+  using Result = std::invoke_result_t<F>;
+  const auto packaged{
+    std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task))
+  };
+  std::future<Result> future{packaged->get_future()};
+  {
+    const std::lock_guard<std::mutex> lock{_mutex};
+    _tasks.push([packaged]() { (*packaged)(); });
+  }
+  _condition.notify_one();
+  return future;
+}
+
+#endif // THREAD_POOL_HXX
@@ -0,0 +1,38 @@
+#include "timestep.hxx"
+
+/*
+ * Definitions.
+ */
+
+my::FixedTimestep::FixedTimestep(double ticksPerSecond, int maxTicksPerFrame)
+: _step{std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>{1. / ticksPerSecond}
+  )},
+  _maxTicksPerFrame{maxTicksPerFrame} {}
+
+auto my::FixedTimestep::advance() -> int {
+  const Clock::time_point now{Clock::now()};
+  _accumulator += now - _previousTime;
+  _previousTime = now;
+  auto ticks{_accumulator / _step};
+  if (ticks > _maxTicksPerFrame) {
+    // Drop the time we can't catch up on rather than spiralling: each
+    // extra tick would make the next frame later still.
+    ticks = _maxTicksPerFrame;
+    _accumulator = _step*ticks;
+  }
+  _accumulator -= _step*ticks;
+  return static_cast<int>(ticks);
+}
+
+auto my::FixedTimestep::getStep() const -> float {
+  return std::chrono::duration<float>{_step}.count();
+}
+
+auto my::FixedTimestep::getAlpha() const -> float {
+  return std::chrono::duration<float>{_accumulator}.count() / getStep();
+}
+
+auto my::FixedTimestep::getTimeToNextTick() const -> Clock::duration {
+  return _step - _accumulator - (Clock::now() - _previousTime);
+}
@@ -0,0 +1,36 @@
+#ifndef TIMESTEP_HXX
+#define TIMESTEP_HXX
+
+#include <chrono>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Accumulates wall-clock time and hands it out in fixed simulation
+// steps. A frame may run several steps or none; whatever is left over
+// is exposed as an interpolation factor for rendering.
+class FixedTimestep {
+public:
+  FixedTimestep(double ticksPerSecond, int maxTicksPerFrame = 8);
+  FixedTimestep() = delete;
+
+  auto advance() -> int;
+  auto getStep() const -> float;
+  auto getAlpha() const -> float;
+  auto getTimeToNextTick() const -> std::chrono::steady_clock::duration;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::duration _step;
+  Clock::time_point _previousTime{Clock::now()};
+  Clock::duration _accumulator{};
+  int _maxTicksPerFrame;
+};
+
+} // namespace my
+
+#endif // TIMESTEP_HXX
@@ -0,0 +1,78 @@
+#ifndef TRIPLE_BUFFER_HXX
+#define TRIPLE_BUFFER_HXX
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Hands values from one writer thread to one reader thread without
+// locks. The writer fills the back slot and publishes it; the reader
+// picks up the most recently published slot. Neither side ever waits
+// for the other, and the reader may skip values it was too slow to see.
+template<typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer(TripleBuffer&&) = delete;
+  auto operator=(const TripleBuffer&) -> TripleBuffer& = delete;
+  auto operator=(TripleBuffer&&) -> TripleBuffer& = delete;
+
+  auto getWriteBuffer() -> T&;
+  auto publish() -> void;
+  auto update() -> bool;
+  auto getReadBuffer() const -> const T&;
+
+private:
+  static constexpr std::uint8_t _indexMask{0b011};
+  static constexpr std::uint8_t _freshBit{0b100};
+
+  std::array<T, 3> _buffers{};
+  std::uint8_t _back{0};
+  std::atomic<std::uint8_t> _middle{1};
+  std::uint8_t _front{2};
+};
+
+} // namespace my
+
+/*
+ * Definitions.
+ */
+
+template<typename T>
+auto my::TripleBuffer<T>::getWriteBuffer() -> T& {
+  return _buffers[_back];
+}
+
+template<typename T>
+auto my::TripleBuffer<T>::publish() -> void {
+  const std::uint8_t previous{_middle.exchange(
+    static_cast<std::uint8_t>(_back | _freshBit), std::memory_order_acq_rel
+  )};
+  _back = previous & _indexMask;
+}
+
+template<typename T>
+auto my::TripleBuffer<T>::update() -> bool {
+  if (!(_middle.load(std::memory_order_relaxed) & _freshBit)) {
+    return false;
+  }
+  const std::uint8_t previous{
+    _middle.exchange(_front, std::memory_order_acq_rel)
+  };
+  _front = previous & _indexMask;
+  return true;
+}
+
+template<typename T>
+auto my::TripleBuffer<T>::getReadBuffer() const -> const T& {
+  return _buffers[_front];
+}
+
+#endif // TRIPLE_BUFFER_HXX
@@ -0,0 +1,223 @@
+#include "vertex-format.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bounds.hxx"
+#include "index-optimizer.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto computeNormals(const my::Geometry& geometry) -> std::vector<glm::vec3>;
+auto packSnorm10(GLfloat value) -> GLuint;
+
+// Largest finite half float.
+constexpr float maxHalf{65504.f};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::packHalf(GLfloat value) -> GLhalf {
+  std::uint32_t bits{};
+  std::memcpy(&bits, &value, sizeof(bits));
+  const std::uint32_t sign{bits >> 16 & 0x8000};
+  const std::uint32_t exponent{bits >> 23 & 0xff};
+  std::uint32_t mantissa{bits & 0x7fffff};
+  if (exponent == 0xff) {
+    // Infinity stays infinity; NaN stays a (quiet) NaN.
+    return static_cast<GLhalf>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+  const int halfExponent{static_cast<int>(exponent) - 127 + 15};
+  if (halfExponent >= 0x1f) {
+    return static_cast<GLhalf>(sign | 0x7c00);
+  }
+  std::uint32_t half{};
+  std::uint32_t remainder{};
+  std::uint32_t halfway{};
+  if (halfExponent <= 0) {
+    if (halfExponent < -10) {
+      return static_cast<GLhalf>(sign);
+    }
+    // Subnormal: shift the mantissa, implicit bit included, into place.
+    mantissa |= 0x800000;
+    const auto shift{static_cast<std::uint32_t>(14 - halfExponent)};
+    half = mantissa >> shift;
+    remainder = mantissa & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  } else {
+    half = static_cast<std::uint32_t>(halfExponent) << 10 | mantissa >> 13;
+    remainder = mantissa & 0x1fff;
+    halfway = 0x1000;
+  }
+  // Round to nearest even. A carry out of the mantissa correctly bumps
+  // the exponent, up to infinity.
+  if (remainder > halfway || (remainder == halfway && (half & 1))) {
+    half++;
+  }
+  return static_cast<GLhalf>(sign | half);
+}
+
+auto my::unpackHalf(GLhalf value) -> GLfloat {
+  const auto sign{static_cast<std::uint32_t>(value & 0x8000) << 16};
+  const std::uint32_t exponent{static_cast<std::uint32_t>(value) >> 10 & 0x1f};
+  const std::uint32_t mantissa{value & 0x3ffu};
+  GLfloat result{};
+  if (exponent == 0x1f) {
+    const std::uint32_t bits{sign | 0x7f800000 | mantissa << 13};
+    std::memcpy(&result, &bits, sizeof(result));
+  } else {
+    // Subnormals included, since a zero exponent scales like a one.
+    result = std::ldexp(
+      static_cast<GLfloat>(exponent ? mantissa | 0x400 : mantissa),
+      static_cast<int>(exponent ? exponent : 1) - 25
+    );
+    if (sign) {
+      result = -result;
+    }
+  }
+  return result;
+}
+
+auto my::packUnorm8(GLfloat value) -> GLubyte {
+  return static_cast<GLubyte>(std::lround(std::clamp(value, 0.f, 1.f)*255.f));
+}
+
+auto my::packSnorm1010102(const glm::vec3& value) -> GLuint {
+  return packSnorm10(value.x)
+    | packSnorm10(value.y) << 10
+    | packSnorm10(value.z) << 20;
+}
+
+auto my::MeshPlacement::getTransform() const -> glm::mat4 {
+  return glm::scale(glm::translate(glm::mat4{1.}, origin), glm::vec3{scale});
+}
+
+auto my::computePlacement(const Geometry& geometry) -> MeshPlacement {
+  const BoundingBox box{computeBounds(geometry).box};
+  // A power of two, so scaling loses nothing before the positions are
+  // rounded to half floats.
+  const float largest{std::max({box.extent.x, box.extent.y, box.extent.z})};
+  return {
+    box.center,
+    largest > maxHalf ? std::exp2(std::ceil(std::log2(largest/maxHalf))) : 1.f
+  };
+}
+
+auto my::placeGeometry(
+  const Geometry& geometry, const MeshPlacement& placement
+) -> MeshGeometry {
+  const GLfloat* vertices{geometry.getVertices()};
+  std::vector<GLfloat> positions(
+    vertices, vertices + geometry.getVertexArraySize()
+  );
+  for (std::size_t i{}; i < positions.size(); i++) {
+    positions[i] = (positions[i] - placement.origin[static_cast<int>(i % 3)])
+      /placement.scale;
+  }
+  const GLfloat* colors{geometry.getColors()};
+  const GLuint* indices{geometry.getIndices()};
+  return {
+    std::move(positions),
+    {colors, colors + geometry.getColorArraySize()},
+    {indices, indices + geometry.getIndexArraySize()}
+  };
+}
+
+auto my::packVertices(const Geometry& geometry) -> std::vector<PackedVertex> {
+  const auto vertexCount{static_cast<std::size_t>(geometry.getVertexCount())};
+  const GLfloat* positions{geometry.getVertices()};
+  const GLfloat* colors{geometry.getColors()};
+  const std::vector<glm::vec3> normals{computeNormals(geometry)};
+  std::vector<PackedVertex> vertices(vertexCount);
+  for (std::size_t i{}; i < vertexCount; i++) {
+    PackedVertex& vertex{vertices[i]};
+    for (std::size_t component{}; component < 3; component++) {
+      vertex.position[component] = packHalf(positions[i*3 + component]);
+      vertex.color[component] = packUnorm8(colors[i*3 + component]);
+    }
+    vertex.position[3] = packHalf(1.f);
+    vertex.color[3] = 255;
+    vertex.normal = packSnorm1010102(normals[i]);
+  }
+  return vertices;
+}
+
+auto my::packMesh(const Geometry& geometry) -> PackedMesh {
+  // Orders the triangles for the vertex cache first, then groups them
+  // against overdraw, which keeps most of that order, and finally the
+  // vertices by first use.
+  const std::vector<PackedVertex> vertices{packVertices(geometry)};
+  PackedMesh mesh{};
+  mesh.indices.assign(
+    geometry.getIndices(), geometry.getIndices() + geometry.getIndexCount()
+  );
+  optimizeVertexCache(mesh.indices, vertices.size());
+  optimizeOverdraw(mesh.indices, geometry.getVertices(), vertices.size());
+  const std::vector<GLuint> remap{
+    optimizeVertexFetch(mesh.indices, vertices.size())
+  };
+  mesh.vertices.resize(vertices.size());
+  for (std::size_t vertex{}; vertex < vertices.size(); vertex++) {
+    mesh.vertices[remap[vertex]] = vertices[vertex];
+  }
+  return mesh;
+}
+
+auto my::getIndexType(std::size_t vertexCount) -> IndexType {
+  return vertexCount <= (1 << 16) ? IndexType::UnsignedShort
+    : IndexType::UnsignedInt;
+}
+
+auto my::getIndexSize(IndexType type) -> std::size_t {
+  return type == IndexType::UnsignedShort ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+namespace {
+
+auto computeNormals(const my::Geometry& geometry) -> std::vector<glm::vec3> {
+  const auto vertexCount{static_cast<std::size_t>(geometry.getVertexCount())};
+  const auto indexCount{static_cast<std::size_t>(geometry.getIndexCount())};
+  const GLfloat* positions{geometry.getVertices()};
+  const GLuint* indices{geometry.getIndices()};
+  const auto position{[&](std::size_t vertex) {
+    return glm::vec3{
+      positions[vertex*3], positions[vertex*3 + 1], positions[vertex*3 + 2]
+    };
+  }};
+  // Unnormalized face normals are proportional to the face area, so
+  // bigger faces weigh more in the average.
+  std::vector<glm::vec3> normals(vertexCount);
+  for (std::size_t i{}; i + 2 < indexCount; i += 3) {
+    const glm::vec3 a{position(indices[i])};
+    const glm::vec3 b{position(indices[i + 1])};
+    const glm::vec3 c{position(indices[i + 2])};
+    const glm::vec3 face{glm::cross(b - a, c - a)};
+    normals[indices[i]] += face;
+    normals[indices[i + 1]] += face;
+    normals[indices[i + 2]] += face;
+  }
+  for (auto& normal : normals) {
+    const float length{glm::length(normal)};
+    normal = length > 0.f ? normal/length : glm::vec3{0.f, 0.f, 1.f};
+  }
+  return normals;
+}
+
+auto packSnorm10(GLfloat value) -> GLuint {
+  const long scaled{std::lround(std::clamp(value, -1.f, 1.f)*511.f)};
+  return static_cast<GLuint>(scaled) & 0x3ff;
+}
+
+} // namespace
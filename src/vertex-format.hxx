@@ -0,0 +1,113 @@
+#ifndef VERTEX_FORMAT_HXX
+#define VERTEX_FORMAT_HXX
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "graphics-types.hxx"
+#include "models.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Interleaved vertex as stored on the GPU. At 16 bytes it's less than
+// half the size of the same data as floats (36 bytes with the normal).
+struct PackedVertex {
+  // Half floats; w is always 1 and only pads the color to 4 bytes.
+  std::array<GLhalf, 4> position{};
+  // Unsigned normalized; alpha is always opaque.
+  std::array<GLubyte, 4> color{};
+  // Signed normalized 10_10_10_2, x in the low bits.
+  GLuint normal{};
+};
+
+// A mesh ready for upload: packed vertices, with the triangles in the
+// order the index optimizer picked and the vertices numbered to match.
+struct PackedMesh {
+  std::vector<PackedVertex> vertices{};
+  std::vector<GLuint> indices{};
+};
+
+// Where a mesh's packed positions sit in its own space: they are stored
+// as (position - origin)/scale.
+struct MeshPlacement {
+  glm::vec3 origin{};
+  float scale{1.f};
+
+  // Moves packed positions back to where the source geometry had them.
+  auto getTransform() const -> glm::mat4;
+};
+
+// Per-instance data of the instanced draw path.
+struct InstanceData {
+  glm::mat4 model{1.};
+};
+
+template<>
+struct VertexLayout<PackedVertex> {
+  static constexpr std::array attributes{layoutAttributes(std::array{
+    VertexAttribute{
+      AttributeLocation::Position, 4, AttributeType::HalfFloat, false
+    },
+    VertexAttribute{
+      AttributeLocation::Color, 4, AttributeType::UnsignedByte, true
+    },
+    VertexAttribute{
+      AttributeLocation::Normal, 4, AttributeType::Int2101010Rev, true
+    }
+  })};
+};
+
+template<>
+struct VertexLayout<InstanceData> {
+  static constexpr std::array attributes{layoutAttributes(std::array{
+    VertexAttribute{AttributeLocation::Model, 4, AttributeType::Float, false, 4}
+  })};
+};
+
+static_assert(sizeof(PackedVertex) == 16);
+static_assert(
+  getLayoutSize(VertexLayout<PackedVertex>::attributes) == sizeof(PackedVertex)
+);
+static_assert(
+  VertexLayout<PackedVertex>::attributes[1].offset
+  == offsetof(PackedVertex, color)
+);
+static_assert(
+  VertexLayout<PackedVertex>::attributes[2].offset
+  == offsetof(PackedVertex, normal)
+);
+static_assert(
+  getLayoutSize(VertexLayout<InstanceData>::attributes) == sizeof(InstanceData)
+);
+
+auto packHalf(GLfloat value) -> GLhalf;
+auto unpackHalf(GLhalf value) -> GLfloat;
+auto packUnorm8(GLfloat value) -> GLubyte;
+auto packSnorm1010102(const glm::vec3& value) -> GLuint;
+// Centers the positions on their bounds, where half floats are most
+// precise, and scales them down by a power of two if they would still
+// overflow. The scale is infinite for bounds too large to store.
+auto computePlacement(const Geometry& geometry) -> MeshPlacement;
+auto placeGeometry(const Geometry& geometry, const MeshPlacement& placement)
+-> MeshGeometry;
+// Normals are averaged from the faces around each vertex, since Geometry
+// doesn't carry any.
+auto packVertices(const Geometry& geometry) -> std::vector<PackedVertex>;
+// packVertices(), then the vertex cache, overdraw and vertex fetch
+// passes of the index optimizer.
+auto packMesh(const Geometry& geometry) -> PackedMesh;
+// Meshes with few enough vertices get 16-bit indices, the rest 32-bit.
+auto getIndexType(std::size_t vertexCount) -> IndexType;
+auto getIndexSize(IndexType type) -> std::size_t;
+
+} // namespace my
+
+#endif // VERTEX_FORMAT_HXX
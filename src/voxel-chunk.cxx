@@ -0,0 +1,119 @@
+#include "voxel-chunk.hxx"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto getPosition(int x, int y, int z) -> std::size_t;
+
+constexpr unsigned int wordBits{64};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto my::VoxelChunk::get(int x, int y, int z) const -> Voxel {
+  return _palette[getIndex(getPosition(x, y, z))];
+}
+
+auto my::VoxelChunk::set(int x, int y, int z, Voxel voxel) -> void {
+  const std::size_t position{getPosition(x, y, z)};
+  const auto entry{std::find(_palette.begin(), _palette.end(), voxel)};
+  const auto index{static_cast<std::size_t>(entry - _palette.begin())};
+  if (entry == _palette.end()) {
+    _palette.push_back(voxel);
+    // Widths stay powers of two so no index straddles two words.
+    unsigned int bitsPerIndex{std::max(_bitsPerIndex, 1u)};
+    while ((std::size_t{1} << bitsPerIndex) < _palette.size()) {
+      bitsPerIndex *= 2;
+    }
+    if (bitsPerIndex != _bitsPerIndex) {
+      widen(bitsPerIndex);
+    }
+  }
+  setIndex(position, index);
+}
+
+auto my::VoxelChunk::isEmpty() const -> bool {
+  if (_palette.size() == 1) {
+    return _palette[0] == emptyVoxel;
+  }
+  for (std::size_t position{}; position < volume; position++) {
+    if (_palette[getIndex(position)] != emptyVoxel) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto my::VoxelChunk::getPaletteSize() const -> std::size_t {
+  return _palette.size();
+}
+
+auto my::VoxelChunk::getMemorySize() const -> std::size_t {
+  return sizeof(VoxelChunk) + _palette.capacity()*sizeof(Voxel)
+    + _words.capacity()*sizeof(std::uint64_t);
+}
+
+auto my::VoxelChunk::getIndex(std::size_t position) const -> std::size_t {
+  if (_bitsPerIndex == 0) {
+    return 0;
+  }
+  const std::size_t bit{position*_bitsPerIndex};
+  const std::uint64_t mask{(std::uint64_t{1} << _bitsPerIndex) - 1};
+  return static_cast<std::size_t>(
+    (_words[bit/wordBits] >> (bit % wordBits)) & mask
+  );
+}
+
+auto my::VoxelChunk::setIndex(std::size_t position, std::size_t index)
+-> void {
+  if (_bitsPerIndex == 0) {
+    return;
+  }
+  const std::size_t bit{position*_bitsPerIndex};
+  const std::uint64_t mask{(std::uint64_t{1} << _bitsPerIndex) - 1};
+  std::uint64_t& word{_words[bit/wordBits]};
+  word &= ~(mask << (bit % wordBits));
+  word |= static_cast<std::uint64_t>(index) << (bit % wordBits);
+}
+
+auto my::VoxelChunk::widen(unsigned int bitsPerIndex) -> void {
+  if (bitsPerIndex > 16) {
+    throw std::runtime_error{"Voxel chunk palette overflow"};
+  }
+  VoxelChunk widened{};
+  widened._palette = _palette;
+  widened._bitsPerIndex = bitsPerIndex;
+  widened._words.resize(volume*bitsPerIndex/wordBits);
+  for (std::size_t position{}; position < volume; position++) {
+    widened.setIndex(position, getIndex(position));
+  }
+  *this = std::move(widened);
+}
+
+namespace {
+
+auto getPosition(int x, int y, int z) -> std::size_t {
+#ifdef DEBUG
+  constexpr int size{my::VoxelChunk::size};
+  if (
+    x < 0 || x >= size || y < 0 || y >= size || z < 0 || z >= size
+  ) {
+    throw std::runtime_error{"Voxel coordinates out of chunk bounds"};
+  }
+#endif // DEBUG
+  return static_cast<std::size_t>(
+    (z*my::VoxelChunk::size + y)*my::VoxelChunk::size + x
+  );
+}
+
+} // namespace
@@ -0,0 +1,50 @@
+#ifndef VOXEL_CHUNK_HXX
+#define VOXEL_CHUNK_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+// Material ID; 0 is empty space.
+using Voxel = std::uint16_t;
+constexpr Voxel emptyVoxel{0};
+
+// Cube of voxels stored as indices into a palette of the materials it
+// contains. Indices are bit-packed at the smallest power-of-two width
+// that fits the palette, so a uniform chunk takes no index storage at
+// all and one with a handful of materials a few bits per voxel.
+//
+// The palette only grows; a chunk that once held many materials keeps
+// its wider indices.
+class VoxelChunk {
+public:
+  static constexpr int size{32};
+  static constexpr std::size_t volume{size*size*size};
+
+  // Coordinates are local, 0 to size - 1 on each axis.
+  auto get(int x, int y, int z) const -> Voxel;
+  auto set(int x, int y, int z, Voxel voxel) -> void;
+  auto isEmpty() const -> bool;
+  auto getPaletteSize() const -> std::size_t;
+  auto getMemorySize() const -> std::size_t;
+
+private:
+  std::vector<Voxel> _palette{emptyVoxel};
+  std::vector<std::uint64_t> _words{};
+  // Zero while the palette has a single entry.
+  unsigned int _bitsPerIndex{};
+
+  auto getIndex(std::size_t position) const -> std::size_t;
+  auto setIndex(std::size_t position, std::size_t index) -> void;
+  auto widen(unsigned int bitsPerIndex) -> void;
+};
+
+} // namespace my
+
+#endif // VOXEL_CHUNK_HXX
@@ -0,0 +1,263 @@
+#include "voxel-world.hxx"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "profiler.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto getChunkKey(const glm::ivec3& coordinate) -> std::uint64_t;
+auto floorDivide(int value, int divisor) -> int;
+
+constexpr int chunkSize{my::VoxelChunk::size};
+// Bounds the GL work a frame spends on newly meshed chunks.
+constexpr std::size_t maxUploadsPerFrame{4};
+// Jobs in flight per worker; more would only copy chunks earlier.
+constexpr std::size_t jobsPerThread{2};
+constexpr std::array<glm::ivec3, 6> neighborOffsets{{
+  {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+}};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::VoxelWorld::VoxelWorld(ThreadPool& pool)
+: _pool{pool} {}
+
+auto my::VoxelWorld::getVoxel(const glm::ivec3& position) const -> Voxel {
+  const glm::ivec3 coordinate{
+    floorDivide(position.x, chunkSize), floorDivide(position.y, chunkSize),
+    floorDivide(position.z, chunkSize)
+  };
+  const auto chunk{_chunks.find(getChunkKey(coordinate))};
+  if (chunk == _chunks.end()) {
+    return emptyVoxel;
+  }
+  const glm::ivec3 local{position - coordinate*chunkSize};
+  return chunk->second.voxels.get(local.x, local.y, local.z);
+}
+
+auto my::VoxelWorld::setVoxel(const glm::ivec3& position, Voxel voxel)
+-> void {
+  const glm::ivec3 coordinate{
+    floorDivide(position.x, chunkSize), floorDivide(position.y, chunkSize),
+    floorDivide(position.z, chunkSize)
+  };
+  const std::uint64_t key{getChunkKey(coordinate)};
+  auto found{_chunks.find(key)};
+  if (found == _chunks.end()) {
+    if (voxel == emptyVoxel) {
+      return;
+    }
+    found = _chunks.emplace(key, Chunk{}).first;
+    found->second.coordinate = coordinate;
+  }
+  Chunk& chunk{found->second};
+  const glm::ivec3 local{position - coordinate*chunkSize};
+  if (chunk.voxels.get(local.x, local.y, local.z) == voxel) {
+    return;
+  }
+  chunk.voxels.set(local.x, local.y, local.z, voxel);
+  markDirty(coordinate);
+  // Faces on a border belong to the neighbor's mesh too.
+  for (int axis{}; axis < 3; axis++) {
+    if (local[axis] == 0 || local[axis] == chunkSize - 1) {
+      glm::ivec3 neighbor{coordinate};
+      neighbor[axis] += local[axis] == 0 ? -1 : 1;
+      markDirty(neighbor);
+    }
+  }
+}
+
+auto my::VoxelWorld::update(GraphicsEngine& graphics) -> void {
+  collectMeshes();
+  uploadMeshes(graphics);
+  scheduleMeshing();
+  if (_objectsChanged) {
+    _objects.clear();
+    for (const auto& [key, chunk] : _chunks) {
+      const glm::mat4 modelMatrix{glm::translate(
+        glm::mat4{1.}, glm::vec3{
+          static_cast<float>(chunk.coordinate.x*chunkSize),
+          static_cast<float>(chunk.coordinate.y*chunkSize),
+          static_cast<float>(chunk.coordinate.z*chunkSize)
+        }
+      )};
+      if (chunk.mesh) {
+        _objects.push_back({*chunk.mesh, modelMatrix, modelMatrix});
+      }
+    }
+    _objectsChanged = false;
+  }
+}
+
+auto my::VoxelWorld::getObjects() const -> const std::vector<ObjectState>& {
+  return _objects;
+}
+
+auto my::VoxelWorld::getStats() const -> VoxelWorldStats {
+  VoxelWorldStats stats{};
+  stats.chunks = _chunks.size();
+  stats.dirtyChunks = _dirtyChunks.size();
+  stats.meshingChunks = _jobs.size();
+  stats.chunksMeshed = _chunksMeshed;
+  stats.meshingMilliseconds = _meshingMilliseconds;
+  for (const auto& [key, chunk] : _chunks) {
+    stats.voxelBytes += chunk.voxels.getMemorySize();
+  }
+  return stats;
+}
+
+auto my::VoxelWorld::collectMeshes() -> void {
+  for (std::size_t i{}; i < _jobs.size();) {
+    MeshJob& job{_jobs[i]};
+    if (
+      job.result.wait_for(std::chrono::seconds{0}) != std::future_status::ready
+    ) {
+      i++;
+      continue;
+    }
+    MeshResult result{job.result.get()};
+    _chunksMeshed++;
+    _meshingMilliseconds += result.milliseconds;
+    Chunk& chunk{_chunks.at(job.chunk)};
+    chunk.meshing = false;
+    // Changed again while it was being meshed; show this mesh for now
+    // and build another.
+    if (chunk.revision != job.revision) {
+      _dirtyChunks.insert(job.chunk);
+    }
+    _uploads.push_back({
+      job.chunk, std::move(result.geometry), std::move(result.occluder)
+    });
+    _jobs[i] = std::move(_jobs.back());
+    _jobs.pop_back();
+  }
+}
+
+auto my::VoxelWorld::uploadMeshes(GraphicsEngine& graphics) -> void {
+  for (
+    std::size_t uploaded{};
+    uploaded < maxUploadsPerFrame && !_uploads.empty();
+    uploaded++
+  ) {
+    Upload& upload{_uploads.front()};
+    Chunk& chunk{_chunks.at(upload.chunk)};
+    if (chunk.mesh) {
+      graphics.removeMesh(*chunk.mesh);
+      chunk.mesh.reset();
+    }
+    if (upload.geometry) {
+      chunk.mesh = graphics.addMesh(
+        *upload.geometry, {}, upload.occluder ? &*upload.occluder : nullptr
+      );
+    }
+    _uploads.pop_front();
+    _objectsChanged = true;
+  }
+}
+
+auto my::VoxelWorld::scheduleMeshing() -> void {
+  const std::size_t maxJobs{_pool.getThreadCount()*jobsPerThread};
+  for (
+    auto dirty{_dirtyChunks.begin()};
+    dirty != _dirtyChunks.end() && _jobs.size() < maxJobs;
+  ) {
+    Chunk& chunk{_chunks.at(*dirty)};
+    // One job per chunk at a time; it stays dirty until that one is in.
+    if (chunk.meshing) {
+      ++dirty;
+      continue;
+    }
+    ChunkNeighborhood chunks{};
+    chunks.center = chunk.voxels;
+    for (std::size_t i{}; i < neighborOffsets.size(); i++) {
+      const auto neighbor{
+        _chunks.find(getChunkKey(chunk.coordinate + neighborOffsets[i]))
+      };
+      if (neighbor != _chunks.end()) {
+        chunks.neighbors[i] = neighbor->second.voxels;
+      }
+    }
+    chunk.meshing = true;
+    _jobs.push_back({*dirty, chunk.revision, _pool.submit(
+      [chunks{std::move(chunks)}]() {
+        PROFILE_SCOPE("Mesh chunk");
+        const auto start{std::chrono::steady_clock::now()};
+        MeshResult result{meshChunk(chunks)};
+        if (result.geometry) {
+          result.occluder = buildChunkOccluder(chunks.center);
+        }
+        const std::chrono::duration<double, std::milli> time{
+          std::chrono::steady_clock::now() - start
+        };
+        result.milliseconds = time.count();
+        return result;
+      }
+    )});
+    dirty = _dirtyChunks.erase(dirty);
+  }
+}
+
+auto my::VoxelWorld::markDirty(const glm::ivec3& coordinate) -> void {
+  const std::uint64_t key{getChunkKey(coordinate)};
+  const auto chunk{_chunks.find(key)};
+  if (chunk == _chunks.end()) {
+    return;
+  }
+  chunk->second.revision++;
+  _dirtyChunks.insert(key);
+}
+
+auto my::generateTestWorld(VoxelWorld& world, int side) -> void {
+  constexpr int groundLevel{-16};
+  constexpr int soilDepth{3};
+  const int halfWidth{side*chunkSize/2};
+  for (int z{-side*chunkSize}; z < 0; z++) {
+    for (int x{-halfWidth}; x < halfWidth; x++) {
+      const auto height{static_cast<int>(
+        6.f + 3.f*std::sin(static_cast<float>(x)*.15f)
+        + 3.f*std::cos(static_cast<float>(z)*.11f)
+      )};
+      const int top{groundLevel + height};
+      for (int y{groundLevel - soilDepth*2}; y <= top; y++) {
+        Voxel voxel{3}; // Stone.
+        if (y == top) {
+          voxel = top > groundLevel + 10 ? 5 : 1; // Snow or grass.
+        } else if (y > top - soilDepth) {
+          voxel = 2; // Dirt.
+        }
+        world.setVoxel({x, y, z}, voxel);
+      }
+    }
+  }
+}
+
+namespace {
+
+auto getChunkKey(const glm::ivec3& coordinate) -> std::uint64_t {
+  // 21 bits per axis, two's complement.
+  constexpr std::uint64_t mask{(std::uint64_t{1} << 21) - 1};
+  return (static_cast<std::uint64_t>(coordinate.x) & mask)
+    | (static_cast<std::uint64_t>(coordinate.y) & mask) << 21
+    | (static_cast<std::uint64_t>(coordinate.z) & mask) << 42;
+}
+
+auto floorDivide(int value, int divisor) -> int {
+  const int quotient{value/divisor};
+  return quotient*divisor > value ? quotient - 1 : quotient;
+}
+
+} // namespace
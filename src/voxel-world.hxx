@@ -0,0 +1,107 @@
+#ifndef VOXEL_WORLD_HXX
+#define VOXEL_WORLD_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk-mesher.hxx"
+#include "game.hxx"
+#include "graphics-engine.hxx"
+#include "thread-pool.hxx"
+#include "voxel-chunk.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace my {
+
+struct VoxelWorldStats {
+  std::size_t chunks{};
+  // Changed chunks waiting for a worker, and those being meshed.
+  std::size_t dirtyChunks{};
+  std::size_t meshingChunks{};
+  std::size_t chunksMeshed{};
+  // Worker time spent meshing, summed over threads.
+  double meshingMilliseconds{};
+  std::size_t voxelBytes{};
+};
+
+// Voxels in chunks of VoxelChunk::size on a side, meshed on a thread pool
+// and owned by the render thread. Chunk (0, 0, 0) spans world voxels 0
+// to VoxelChunk::size - 1 on each axis.
+class VoxelWorld {
+public:
+  VoxelWorld(ThreadPool& pool);
+  VoxelWorld() = delete;
+  VoxelWorld(const VoxelWorld&) = delete;
+  VoxelWorld(VoxelWorld&&) = delete;
+  auto operator=(const VoxelWorld&) -> VoxelWorld& = delete;
+  auto operator=(VoxelWorld&&) -> VoxelWorld& = delete;
+
+  auto getVoxel(const glm::ivec3& position) const -> Voxel;
+  auto setVoxel(const glm::ivec3& position, Voxel voxel) -> void;
+  // Once per frame, before rendering. Never waits on the workers: it
+  // picks up whichever meshes are done, swaps a few of them into the
+  // engine and hands chunks that changed to idle workers.
+  auto update(GraphicsEngine& graphics) -> void;
+  // One per chunk with a mesh, for GraphicsEngine::render().
+  auto getObjects() const -> const std::vector<ObjectState>&;
+  auto getStats() const -> VoxelWorldStats;
+
+private:
+  struct Chunk {
+    glm::ivec3 coordinate{};
+    VoxelChunk voxels{};
+    // Bumped on every change; meshes are built from a given revision.
+    std::uint32_t revision{};
+    bool meshing{};
+    std::optional<std::uint32_t> mesh{};
+  };
+  struct MeshResult {
+    std::optional<ChunkGeometry> geometry{};
+    std::optional<ChunkGeometry> occluder{};
+    double milliseconds{};
+  };
+  struct MeshJob {
+    std::uint64_t chunk{};
+    std::uint32_t revision{};
+    std::future<MeshResult> result{};
+  };
+  struct Upload {
+    std::uint64_t chunk{};
+    std::optional<ChunkGeometry> geometry{};
+    std::optional<ChunkGeometry> occluder{};
+  };
+
+  std::unordered_map<std::uint64_t, Chunk> _chunks{};
+  std::unordered_set<std::uint64_t> _dirtyChunks{};
+  std::vector<MeshJob> _jobs{};
+  std::deque<Upload> _uploads{};
+  std::vector<ObjectState> _objects{};
+  bool _objectsChanged{};
+  std::size_t _chunksMeshed{};
+  double _meshingMilliseconds{};
+  ThreadPool& _pool;
+
+  auto collectMeshes() -> void;
+  auto uploadMeshes(GraphicsEngine& graphics) -> void;
+  auto scheduleMeshing() -> void;
+  auto markDirty(const glm::ivec3& coordinate) -> void;
+};
+
+// Rolling hills of a few materials over a square of side by side chunks
+// in front of the camera, for exercising the world without a generator.
+auto generateTestWorld(VoxelWorld& world, int side) -> void;
+
+} // namespace my
+
+#endif // VOXEL_WORLD_HXX
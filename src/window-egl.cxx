@@ -0,0 +1,206 @@
+#ifdef USE_EGL
+
+#include "window.hxx"
+
+#include <stdexcept>
+#include <string_view>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/gl.h>
+
+#include "logger.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto hasExtensionEGL(const char* extensions, std::string_view name) -> bool;
+auto getDisplayEGL() -> EGLDisplay;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+my::WindowHandler::WindowHandler()
+: _display{getDisplayEGL()}, _width{_initialWidth}, _height{_initialHeight} {
+  if (_display == EGL_NO_DISPLAY) {
+    throw std::runtime_error{"Failed to get EGL display"};
+  }
+  EGLint versionMajor{};
+  EGLint versionMinor{};
+  if (!eglInitialize(_display, &versionMajor, &versionMinor)) {
+    throw std::runtime_error{"Failed to initialize EGL"};
+  }
+  LOG_INFO("EGL version: {}.{}", versionMajor, versionMinor);
+  const char* extensions{eglQueryString(_display, EGL_EXTENSIONS)};
+  if (!hasExtensionEGL(extensions, "EGL_KHR_surfaceless_context")) {
+    eglTerminate(_display);
+    throw std::runtime_error{"EGL surfaceless contexts are unavailable"};
+  }
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    eglTerminate(_display);
+    throw std::runtime_error{"Failed to bind OpenGL API"};
+  }
+  const EGLint configAttributes[]{
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_SURFACE_TYPE, 0,
+    EGL_NONE
+  };
+  EGLConfig config{};
+  EGLint configCount{};
+  if (
+    !eglChooseConfig(_display, configAttributes, &config, 1, &configCount)
+    || configCount < 1
+  ) {
+    eglTerminate(_display);
+    throw std::runtime_error{"Failed to choose EGL config"};
+  }
+  const EGLint contextAttributes[]{
+    EGL_CONTEXT_MAJOR_VERSION, glVersionMajor,
+    EGL_CONTEXT_MINOR_VERSION, glVersionMinor,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef DEBUG
+    EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif // DEBUG
+    EGL_NONE
+  };
+  _context = eglCreateContext(
+    _display, config, EGL_NO_CONTEXT /*share*/, contextAttributes
+  );
+  if (_context == EGL_NO_CONTEXT) {
+    eglTerminate(_display);
+    throw std::runtime_error{"Failed to create context"};
+  }
+  if (!eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context)) {
+    eglDestroyContext(_display, _context);
+    eglTerminate(_display);
+    throw std::runtime_error{"Failed to make context current"};
+  }
+  _actions.resize = true;
+}
+
+my::WindowHandler::~WindowHandler() {
+  // The framebuffer is only created once GL has been loaded, which
+  // happens after construction; see preRender.
+  if (_framebuffer) {
+    glDeleteFramebuffers(1, &_framebuffer);
+    glDeleteRenderbuffers(1, &_colorRenderbuffer);
+    glDeleteRenderbuffers(1, &_depthRenderbuffer);
+  }
+  eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(_display, _context);
+  eglTerminate(_display);
+}
+
+auto my::WindowHandler::getProcAddressLoader() const -> ProcAddressLoader {
+  return eglGetProcAddress;
+}
+
+auto my::WindowHandler::getActions() const -> const WindowActions& {
+  return _actions;
+}
+
+auto my::WindowHandler::getWidth() const -> int {
+  return _width;
+}
+
+auto my::WindowHandler::getHeight() const -> int {
+  return _height;
+}
+
+auto my::WindowHandler::isActive() const -> bool {
+  return _active;
+}
+
+auto my::WindowHandler::close() -> void {
+  _active = false;
+}
+
+auto my::WindowHandler::resetSize() -> void {
+  _width = _initialWidth;
+  _height = _initialHeight;
+}
+
+auto my::WindowHandler::preRender() -> void {
+  if (!_framebuffer) {
+    glGenRenderbuffers(1, &_colorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _colorRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, _width, _height);
+    glGenRenderbuffers(1, &_depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbuffer);
+    glRenderbufferStorage(
+      GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _width, _height
+    );
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glFramebufferRenderbuffer(
+      GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorRenderbuffer
+    );
+    glFramebufferRenderbuffer(
+      GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbuffer
+    );
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      throw std::runtime_error{"Failed to create offscreen framebuffer"};
+    }
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+}
+
+auto my::WindowHandler::postRender() -> void {
+  // There is no swap to pace the frame, so push the queued commands to
+  // the driver here instead.
+  glFlush();
+}
+
+auto my::WindowHandler::resetActions() -> void {
+  _actions.close = false;
+  _actions.resetSize = false;
+  _actions.resize = false;
+  _actions.pauseResume = false;
+  _actions.toggleTrace = false;
+}
+
+namespace {
+
+auto hasExtensionEGL(const char* extensions, std::string_view name) -> bool {
+  if (!extensions) {
+    return false;
+  }
+  std::string_view remaining{extensions};
+  while (!remaining.empty()) {
+    const std::size_t end{remaining.find(' ')};
+    if (remaining.substr(0, end) == name) {
+      return true;
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    remaining.remove_prefix(end + 1);
+  }
+  return false;
+}
+
+auto getDisplayEGL() -> EGLDisplay {
+  // Prefer Mesa's surfaceless platform, which needs neither a display
+  // server nor a GPU device node (e.g. llvmpipe on a build machine).
+  const char* clientExtensions{eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS)};
+  if (hasExtensionEGL(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+    const EGLDisplay display{eglGetPlatformDisplay(
+      EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr
+    )};
+    if (display != EGL_NO_DISPLAY) {
+      return display;
+    }
+  }
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+} // namespace
+
+#endif // USE_EGL
@@ -6,7 +6,7 @@
 
 #include <GLFW/glfw3.h>
 
-#include "debug.hxx"
+#include "logger.hxx"
 
 /*
  * Declarations.
@@ -61,6 +61,10 @@ auto my::WindowHandler::getWindow() -> GLFWwindow* {
   return _window;
 }
 
+auto my::WindowHandler::getProcAddressLoader() const -> ProcAddressLoader {
+  return glfwGetProcAddress;
+}
+
 auto my::WindowHandler::getActions() const -> const WindowActions& {
   return _actions;
 }
@@ -106,6 +110,7 @@ auto my::WindowHandler::resetActions() -> void {
   _actions.resetSize = false;
   _actions.resize = false;
   _actions.pauseResume = false;
+  _actions.toggleTrace = false;
 }
 
 auto my::WindowHandler::onKeyGLFW(
@@ -120,7 +125,7 @@ auto my::WindowHandler::onKeyGLFW(
 }
 
 auto my::WindowHandler::onKey(int key, int action, int mods) -> void {
-  // LOG("key=" << key << " action=" << action << " mods=" << mods << '\n');
+  // LOG_DEBUG("key={} action={} mods={}", key, action, mods);
   const bool closeKey1{
     action == GLFW_RELEASE && mods == GLFW_MOD_CONTROL && key == GLFW_KEY_Q
   };
@@ -136,6 +141,9 @@ auto my::WindowHandler::onKey(int key, int action, int mods) -> void {
   const bool pauseResumeKey{
     action == GLFW_RELEASE && mods == 0 && key == GLFW_KEY_SPACE
   };
+  const bool traceKey{
+    action == GLFW_RELEASE && mods == GLFW_MOD_CONTROL && key == GLFW_KEY_T
+  };
 
   if (closeKey1 || closeKey2 || closeKey3) {
     _actions.close = true;
@@ -144,6 +152,8 @@ auto my::WindowHandler::onKey(int key, int action, int mods) -> void {
     _actions.resize = true;
   } else if (pauseResumeKey) {
     _actions.pauseResume = true;
+  } else if (traceKey) {
+    _actions.toggleTrace = true;
   }
 }
 
@@ -151,7 +161,7 @@ namespace {
 
 #ifdef DEBUG
 auto errorCallbackGLFW(int, const char* description) -> void {
-  LOG_ERROR("GLFW error: " << description << '\n');
+  LOG_ERROR("GLFW error: {}", description);
 }
 #endif // DEBUG
 
@@ -13,11 +13,15 @@ struct GLFWwindow;
 
 namespace my {
 
+using ProcAddress = void (*)();
+using ProcAddressLoader = ProcAddress (*)(const char* name);
+
 struct WindowActions {
   bool close{false};
   bool resetSize{false};
   bool resize{false};
   bool pauseResume{false};
+  bool toggleTrace{false};
 };
 
 class WindowHandler {
@@ -32,6 +36,7 @@ public:
 #ifdef USE_GLFW
   auto getWindow() -> GLFWwindow*;
 #endif // USE_GLFW
+  auto getProcAddressLoader() const -> ProcAddressLoader;
   auto getActions() const -> const WindowActions&;
   auto getWidth() const -> int;
   auto getHeight() const -> int;
@@ -51,6 +56,16 @@ private:
 #ifdef USE_GLFW
   GLFWwindow* _window;
 #endif // USE_GLFW
+#ifdef USE_EGL
+  // EGL handles are opaque pointers; this keeps <EGL/egl.h> out of
+  // the header.
+  void* _display;
+  void* _context;
+  unsigned int _framebuffer{};
+  unsigned int _colorRenderbuffer{};
+  unsigned int _depthRenderbuffer{};
+  bool _active{true};
+#endif // USE_EGL
   WindowActions _actions{};
   int _width;
   int _height;
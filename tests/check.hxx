@@ -0,0 +1,33 @@
+#ifndef CHECK_HXX
+#define CHECK_HXX
+
+#include <cstdlib>
+#include <iostream>
+
+/*
+ * Declarations.
+ */
+
+namespace my::test {
+
+// Checks that have failed so far in this test executable.
+inline int failures{};
+
+inline auto getExitCode() -> int {
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace my::test
+
+// Reports a false expression along with where it is, then carries on so
+// that one run shows every failure.
+#define CHECK(expression) \
+  do { \
+    if (!(expression)) { \
+      std::cerr << __FILE__ << ':' << __LINE__; \
+      std::cerr << ": CHECK(" #expression ") failed\n"; \
+      my::test::failures++; \
+    } \
+  } while (false)
+
+#endif // CHECK_HXX
@@ -0,0 +1,132 @@
+#include "occlusion-buffer.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "bounds.hxx"
+#include "check.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto testRasterizesQuad() -> void;
+auto testBuildsMaxPyramid() -> void;
+auto testOccludesBoxBehind() -> void;
+auto testKeepsPartlyVisibleBox() -> void;
+auto rasterizeQuad(
+  my::OcclusionBuffer& buffer, float nearLeft, float nearRight
+) -> void;
+
+// With an identity view-projection, clip space is world space: x and y
+// from -1 to 1 span the buffer, and z maps to depth as z/2 + 1/2.
+constexpr int bufferWidth{64};
+constexpr int bufferHeight{24};
+const glm::mat4 identity{1.};
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto main() -> int {
+  testRasterizesQuad();
+  testBuildsMaxPyramid();
+  testOccludesBoxBehind();
+  testKeepsPartlyVisibleBox();
+  return my::test::getExitCode();
+}
+
+namespace {
+
+auto testRasterizesQuad() -> void {
+  my::OcclusionBuffer buffer{bufferWidth, bufferHeight};
+  buffer.clear(identity);
+  rasterizeQuad(buffer, 0.f, 0.f);
+  // The quad spans x from 16 to 48 and y from 6 to 18 in pixels; pixels
+  // count as covered when their centers are inside.
+  for (int y{}; y < bufferHeight; y++) {
+    for (int x{}; x < bufferWidth; x++) {
+      const bool inside{x >= 16 && x < 48 && y >= 6 && y < 18};
+      CHECK(buffer.getDepth(0, x, y) == (inside ? .5f : 1.f));
+    }
+  }
+}
+
+auto testBuildsMaxPyramid() -> void {
+  my::OcclusionBuffer buffer{bufferWidth, bufferHeight};
+  buffer.clear(identity);
+  // Sloped, so that neighboring texels differ.
+  rasterizeQuad(buffer, -.8f, .6f);
+  buffer.buildHierarchy();
+  CHECK(buffer.getLevelCount() == 7);
+  int width{bufferWidth};
+  int height{bufferHeight};
+  for (std::size_t level{1}; level < buffer.getLevelCount(); level++) {
+    const int sourceWidth{width};
+    const int sourceHeight{height};
+    width = (width + 1)/2;
+    height = (height + 1)/2;
+    for (int y{}; y < height; y++) {
+      for (int x{}; x < width; x++) {
+        // Texels past an odd edge repeat the last row or column.
+        const int right{std::min(2*x + 1, sourceWidth - 1)};
+        const int bottom{std::min(2*y + 1, sourceHeight - 1)};
+        const float expected{std::max({
+          buffer.getDepth(level - 1, 2*x, 2*y),
+          buffer.getDepth(level - 1, right, 2*y),
+          buffer.getDepth(level - 1, 2*x, bottom),
+          buffer.getDepth(level - 1, right, bottom)
+        })};
+        CHECK(buffer.getDepth(level, x, y) == expected);
+      }
+    }
+  }
+  CHECK(width == 1 && height == 1);
+  // Part of the buffer is still clear.
+  CHECK(buffer.getDepth(buffer.getLevelCount() - 1, 0, 0) == 1.f);
+}
+
+auto testOccludesBoxBehind() -> void {
+  my::OcclusionBuffer buffer{bufferWidth, bufferHeight};
+  buffer.clear(identity);
+  rasterizeQuad(buffer, 0.f, 0.f);
+  buffer.buildHierarchy();
+  CHECK(buffer.isOccluded({{0.f, 0.f, .5f}, {.2f, .2f, .1f}}));
+}
+
+auto testKeepsPartlyVisibleBox() -> void {
+  my::OcclusionBuffer buffer{bufferWidth, bufferHeight};
+  buffer.clear(identity);
+  rasterizeQuad(buffer, 0.f, 0.f);
+  buffer.buildHierarchy();
+  // Sticks out past the right edge of the quad.
+  CHECK(!buffer.isOccluded({{.5f, 0.f, .5f}, {.2f, .2f, .1f}}));
+  // Reaches in front of the quad.
+  CHECK(!buffer.isOccluded({{0.f, 0.f, .05f}, {.2f, .2f, .1f}}));
+  // Entirely in front of it.
+  CHECK(!buffer.isOccluded({{0.f, 0.f, -.5f}, {.2f, .2f, .1f}}));
+}
+
+// Quad over the middle half of the buffer, at the given z on its left
+// and right edges.
+auto rasterizeQuad(
+  my::OcclusionBuffer& buffer, float nearLeft, float nearRight
+) -> void {
+  const std::vector<glm::vec3> positions{
+    {-.5f, -.5f, nearLeft}, {.5f, -.5f, nearRight},
+    {.5f, .5f, nearRight}, {-.5f, .5f, nearLeft}
+  };
+  const std::vector<GLuint> indices{0, 1, 2, 0, 2, 3};
+  buffer.rasterize(positions, indices, identity);
+}
+
+} // namespace
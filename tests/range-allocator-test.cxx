@@ -0,0 +1,165 @@
+#include "range-allocator.hxx"
+
+#include <cstddef>
+#include <map>
+#include <optional>
+
+#include "check.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto testAllocatesInOrder() -> void;
+auto testCoalescesWithBothNeighbors() -> void;
+auto testAllocatesBestFit() -> void;
+auto testFailsWhenFull() -> void;
+auto testGrowsAndResets() -> void;
+auto testAligns() -> void;
+auto testCompactKeepsLiveRanges() -> void;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto main() -> int {
+  testAllocatesInOrder();
+  testCoalescesWithBothNeighbors();
+  testAllocatesBestFit();
+  testFailsWhenFull();
+  testGrowsAndResets();
+  testAligns();
+  testCompactKeepsLiveRanges();
+  return my::test::getExitCode();
+}
+
+namespace {
+
+auto testAllocatesInOrder() -> void {
+  my::RangeAllocator allocator{100};
+  CHECK(allocator.allocate(10) == 0u);
+  CHECK(allocator.allocate(20) == 10u);
+  CHECK(allocator.allocate(30) == 30u);
+  CHECK(!allocator.allocate(0));
+  const my::RangeAllocatorStats stats{allocator.getStats()};
+  CHECK(stats.capacity == 100);
+  CHECK(stats.used == 60);
+  CHECK(stats.freeBlocks == 1);
+  CHECK(stats.largestFreeBlock == 40);
+  CHECK(stats.fragmentation == 0.);
+}
+
+auto testCoalescesWithBothNeighbors() -> void {
+  my::RangeAllocator allocator{40};
+  for (std::size_t offset{}; offset < 40; offset += 10) {
+    CHECK(allocator.allocate(10) == offset);
+  }
+  allocator.free(0);
+  allocator.free(20);
+  my::RangeAllocatorStats stats{allocator.getStats()};
+  CHECK(stats.used == 20);
+  CHECK(stats.freeBlocks == 2);
+  CHECK(stats.largestFreeBlock == 10);
+  CHECK(stats.fragmentation == .5);
+  // Joins the blocks on either side into one.
+  allocator.free(10);
+  stats = allocator.getStats();
+  CHECK(stats.freeBlocks == 1);
+  CHECK(stats.largestFreeBlock == 30);
+  CHECK(allocator.allocate(30) == 0u);
+}
+
+auto testAllocatesBestFit() -> void {
+  my::RangeAllocator allocator{100};
+  const std::optional<std::size_t> large{allocator.allocate(20)};
+  CHECK(allocator.allocate(10) == 20u);
+  const std::optional<std::size_t> small{allocator.allocate(10)};
+  CHECK(allocator.allocate(10) == 40u);
+  allocator.free(*large);
+  allocator.free(*small);
+  // The 10 free at 30 fits exactly, so the 20 at 0 stays whole.
+  CHECK(allocator.allocate(10) == 30u);
+  CHECK(allocator.allocate(15) == 0u);
+  CHECK(allocator.allocate(40) == 50u);
+}
+
+auto testFailsWhenFull() -> void {
+  my::RangeAllocator allocator{30};
+  CHECK(allocator.allocate(30) == 0u);
+  CHECK(!allocator.allocate(1));
+  allocator.free(0);
+  CHECK(!allocator.allocate(31));
+  CHECK(allocator.allocate(10) == 0u);
+  CHECK(allocator.allocate(10) == 10u);
+  allocator.free(0);
+  // Twenty are free, but split in two.
+  CHECK(!allocator.allocate(20));
+  CHECK(allocator.getStats().used == 10);
+}
+
+auto testGrowsAndResets() -> void {
+  my::RangeAllocator allocator{30};
+  CHECK(allocator.allocate(20) == 0u);
+  CHECK(!allocator.allocate(20));
+  // Extends the free block at the old end.
+  allocator.grow(40);
+  CHECK(allocator.getCapacity() == 40);
+  CHECK(allocator.getStats().freeBlocks == 1);
+  CHECK(allocator.allocate(20) == 20u);
+  allocator.reset();
+  const my::RangeAllocatorStats stats{allocator.getStats()};
+  CHECK(stats.used == 0);
+  CHECK(stats.largestFreeBlock == 40);
+  CHECK(allocator.allocate(40) == 0u);
+}
+
+auto testAligns() -> void {
+  my::RangeAllocator allocator{16};
+  CHECK(allocator.allocate(1) == 0u);
+  CHECK(allocator.allocate(4, 4) == 4u);
+  // The space skipped for alignment stays free.
+  my::RangeAllocatorStats stats{allocator.getStats()};
+  CHECK(stats.used == 5);
+  CHECK(stats.freeBlocks == 2);
+  CHECK(allocator.allocate(3) == 1u);
+  CHECK(allocator.allocate(2) == 8u);
+  // The 6 left at 10 is big enough, but aligned to 4 it would start at 12.
+  CHECK(!allocator.allocate(6, 4));
+  CHECK(allocator.allocate(6, 2) == 10u);
+  stats = allocator.getStats();
+  CHECK(stats.used == 16);
+  CHECK(stats.freeBlocks == 0);
+}
+
+auto testCompactKeepsLiveRanges() -> void {
+  my::RangeAllocator allocator{32};
+  CHECK(allocator.allocate(3) == 0u);
+  CHECK(allocator.allocate(5) == 3u);
+  CHECK(allocator.allocate(4, 4) == 8u);
+  CHECK(allocator.allocate(6) == 12u);
+  allocator.free(3);
+  const std::map<std::size_t, std::size_t> moves{allocator.compact()};
+  // The aligned range moves only as far as its alignment allows.
+  const std::map<std::size_t, std::size_t> expected{
+    {0, 0}, {8, 4}, {12, 8}
+  };
+  CHECK(moves == expected);
+  my::RangeAllocatorStats stats{allocator.getStats()};
+  CHECK(stats.used == 13);
+  CHECK(stats.freeBlocks == 2);
+  CHECK(stats.largestFreeBlock == 18);
+  // The ranges are known by their new offsets.
+  allocator.free(4);
+  allocator.free(0);
+  allocator.free(8);
+  stats = allocator.getStats();
+  CHECK(stats.used == 0);
+  CHECK(stats.freeBlocks == 1);
+  CHECK(stats.largestFreeBlock == 32);
+}
+
+} // namespace
@@ -0,0 +1,121 @@
+#include "vertex-format.hxx"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "check.hxx"
+
+/*
+ * Declarations.
+ */
+
+namespace {
+
+auto testPacksSubnormalHalves() -> void;
+auto testOverflowsToInfinity() -> void;
+auto testRoundsHalvesToNearestEven() -> void;
+auto testRoundTripsHalves() -> void;
+auto testClampsSnormNormals() -> void;
+
+} // namespace
+
+/*
+ * Definitions.
+ */
+
+auto main() -> int {
+  testPacksSubnormalHalves();
+  testOverflowsToInfinity();
+  testRoundsHalvesToNearestEven();
+  testRoundTripsHalves();
+  testClampsSnormNormals();
+  return my::test::getExitCode();
+}
+
+namespace {
+
+auto testPacksSubnormalHalves() -> void {
+  CHECK(my::packHalf(std::ldexp(1.f, -14)) == 0x0400);
+  CHECK(my::packHalf(std::ldexp(1.f, -15)) == 0x0200);
+  CHECK(my::packHalf(std::ldexp(1.f, -24)) == 0x0001);
+  CHECK(my::packHalf(-std::ldexp(1.f, -24)) == 0x8001);
+  CHECK(my::packHalf(std::ldexp(1023.f, -24)) == 0x03ff);
+  // Halfway to the smallest subnormal rounds to even, which is zero;
+  // anything more rounds up to it.
+  CHECK(my::packHalf(std::ldexp(1.f, -25)) == 0x0000);
+  CHECK(my::packHalf(std::ldexp(3.f, -26)) == 0x0001);
+  CHECK(my::packHalf(std::ldexp(1.f, -30)) == 0x0000);
+  CHECK(my::packHalf(-std::ldexp(1.f, -30)) == 0x8000);
+  // The largest subnormal rounds up into the smallest normal.
+  CHECK(my::packHalf(std::ldexp(2047.f, -25)) == 0x0400);
+  CHECK(my::unpackHalf(0x0001) == std::ldexp(1.f, -24));
+  CHECK(my::unpackHalf(0x03ff) == std::ldexp(1023.f, -24));
+}
+
+auto testOverflowsToInfinity() -> void {
+  const float infinity{std::numeric_limits<float>::infinity()};
+  CHECK(my::packHalf(65504.f) == 0x7bff);
+  // Below halfway to the next power of two stays finite; halfway rounds
+  // to even, which is infinity.
+  CHECK(my::packHalf(65519.f) == 0x7bff);
+  CHECK(my::packHalf(65520.f) == 0x7c00);
+  CHECK(my::packHalf(70000.f) == 0x7c00);
+  CHECK(my::packHalf(-1e10f) == 0xfc00);
+  CHECK(my::packHalf(infinity) == 0x7c00);
+  CHECK(my::packHalf(-infinity) == 0xfc00);
+  const GLhalf nan{my::packHalf(std::numeric_limits<float>::quiet_NaN())};
+  CHECK((nan & 0x7c00) == 0x7c00 && (nan & 0x3ff) != 0);
+  CHECK(my::unpackHalf(0x7c00) == infinity);
+  CHECK(std::isnan(my::unpackHalf(nan)));
+}
+
+auto testRoundsHalvesToNearestEven() -> void {
+  // Half floats near 1 are 2^-10 apart.
+  CHECK(my::packHalf(1.f + std::ldexp(1.f, -11)) == 0x3c00);
+  CHECK(my::packHalf(1.f + std::ldexp(3.f, -11)) == 0x3c02);
+  CHECK(
+    my::packHalf(1.f + std::ldexp(1.f, -11) + std::ldexp(1.f, -20))
+    == 0x3c01
+  );
+  CHECK(my::packHalf(1.f + std::ldexp(1.f, -12)) == 0x3c00);
+  CHECK(my::packHalf(2049.f) == 0x6800);
+  CHECK(my::packHalf(2051.f) == 0x6802);
+  CHECK(my::packHalf(-2051.f) == 0xe802);
+}
+
+auto testRoundTripsHalves() -> void {
+  // Every half that isn't a NaN survives unpacking and packing again.
+  for (std::uint32_t bits{}; bits <= 0xffff; bits++) {
+    const auto half{static_cast<GLhalf>(bits)};
+    if ((half & 0x7c00) == 0x7c00 && (half & 0x3ff) != 0) {
+      continue;
+    }
+    CHECK(my::packHalf(my::unpackHalf(half)) == half);
+  }
+}
+
+auto testClampsSnormNormals() -> void {
+  // x in the low bits; each component is two's complement in 10 bits.
+  CHECK(my::packSnorm1010102({1.f, 0.f, 0.f}) == 0x1ffu);
+  CHECK(my::packSnorm1010102({0.f, 1.f, 0.f}) == 0x1ffu << 10);
+  CHECK(my::packSnorm1010102({0.f, 0.f, 1.f}) == 0x1ffu << 20);
+  CHECK(my::packSnorm1010102({-1.f, 0.f, 0.f}) == 0x201u);
+  CHECK(my::packSnorm1010102({.5f, -.5f, 0.f}) == (0x100u | 0x300u << 10));
+  // Out of range components clamp to -1 and 1, without spilling into
+  // their neighbours or the 2 unused bits.
+  CHECK(
+    my::packSnorm1010102({2.f, -2.f, 100.f})
+    == my::packSnorm1010102({1.f, -1.f, 1.f})
+  );
+  CHECK(my::packSnorm1010102({-5.f, -5.f, -5.f}) >> 30 == 0);
+  CHECK(
+    my::packSnorm1010102({-5.f, 0.f, 0.f})
+    == my::packSnorm1010102({-1.f, 0.f, 0.f})
+  );
+}
+
+} // namespace